@@ -611,6 +611,30 @@ xmmsc_broadcast_medialib_entry_updated (c)
 		if (ix == 1)
 			warn ("Audio::XMMSClient::broadcast_medialib_entry_changed is deprecated, use Audio::XMMSClient::broadcast_medialib_entry_updated instead.");
 
+=head2 broadcast_medialib_entries_changed
+
+=over 4
+
+=item Arguments: none
+
+=item Return Value: $result
+
+=back
+
+  my $result = $conn->broadcast_medialib_entries_changed;
+
+Request the medialib_entries_changed broadcast. This will be called if a lot of
+entries are added or changed at once on the serverside. A connection listening
+to it gets it instead of the medialib_entry_added and medialib_entry_updated
+broadcasts for those entries. The value is a hash with the ids of the added entries in the C<added>
+list and the ids of the changed entries in the C<changed> list.
+
+=cut
+
+xmmsc_result_t *
+xmmsc_broadcast_medialib_entries_changed (c)
+		xmmsc_connection_t *c
+
 =head2 medialib_entry_property_set_int
 
 =over 4
@@ -215,6 +215,7 @@ cdef extern from "xmmsclient/xmmsclient.h":
 	xmmsc_result_t *xmmsc_broadcast_medialib_entry_added   (xmmsc_connection_t *c)
 	xmmsc_result_t *xmmsc_broadcast_medialib_entry_updated (xmmsc_connection_t *c)
 	xmmsc_result_t *xmmsc_broadcast_medialib_entry_removed (xmmsc_connection_t *c)
+	xmmsc_result_t *xmmsc_broadcast_medialib_entries_changed (xmmsc_connection_t *c)
 
 	# Collections
 	ctypedef char *xmmsv_coll_namespace_t # Need to redeclare it
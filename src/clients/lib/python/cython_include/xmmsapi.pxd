@@ -200,6 +200,7 @@ cdef class XmmsApi(XmmsCore):
 	cpdef XmmsResult broadcast_medialib_entry_added(self, cb=*)
 	cpdef XmmsResult broadcast_medialib_entry_updated(self, cb=*)
 	cpdef XmmsResult broadcast_medialib_entry_removed(self, cb=*)
+	cpdef XmmsResult broadcast_medialib_entries_changed(self, cb=*)
 	cpdef XmmsResult broadcast_collection_changed(self, cb=*)
 	cpdef XmmsResult signal_mediainfo_reader_unindexed(self, cb=*)
 	cpdef XmmsResult broadcast_mediainfo_reader_status(self, cb=*)
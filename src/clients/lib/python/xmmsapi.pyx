@@ -1739,6 +1739,14 @@ cdef class XmmsApi(XmmsCore):
 		"""
 		return self.create_result(cb, xmmsc_broadcast_medialib_entry_removed(self.conn))
 
+	cpdef XmmsResult broadcast_medialib_entries_changed(self, cb = None):
+		"""
+		Set a method to handle the medialib entries changed broadcast
+		from the XMMS2 daemon. (i.e. many entries have been added or
+		changed at once)
+		"""
+		return self.create_result(cb, xmmsc_broadcast_medialib_entries_changed(self.conn))
+
 	cpdef XmmsResult broadcast_collection_changed(self, cb = None):
 		"""
 		Set a method to handle the collection changed broadcast
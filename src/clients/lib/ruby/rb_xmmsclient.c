@@ -757,6 +757,19 @@ c_broadcast_medialib_entry_removed (VALUE self)
 	METHOD_ADD_HANDLER (broadcast_medialib_entry_removed);
 }
 
+/*
+ * call-seq:
+ *  xc.broadcast_medialib_entries_changed -> result
+ *
+ * Retrieves the ids of many medialib entries added or changed at once
+ * as a broadcast, in a hash with the :added and :changed lists.
+ */
+static VALUE
+c_broadcast_medialib_entries_changed (VALUE self)
+{
+	METHOD_ADD_HANDLER (broadcast_medialib_entries_changed);
+}
+
 /*
  * call-seq:
  *  xc.playlist_set_next(pos) -> result
@@ -1668,6 +1681,8 @@ Init_Client (VALUE mXmms)
 	                  c_broadcast_medialib_entry_added, 0);
 	rb_define_method (c, "broadcast_medialib_entry_removed",
 	                  c_broadcast_medialib_entry_removed, 0);
+	rb_define_method (c, "broadcast_medialib_entries_changed",
+	                  c_broadcast_medialib_entries_changed, 0);
 
 	rb_define_method (c, "playlist", c_playlist, -1);
 	rb_define_method (c, "playlist_list", c_playlist_list, 0);
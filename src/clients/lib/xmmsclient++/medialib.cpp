@@ -31,6 +31,23 @@
 namespace Xmms
 {
 
+	static xmmsv_t*
+	getEntriesList( xmmsv_t* val, const char* key )
+	{
+		xmmsv_t* list = 0;
+		if( !xmmsv_dict_get( val, key, &list ) ) {
+			throw not_list_error( std::string( "No list of " ) + key +
+			                      " entries" );
+		}
+		return list;
+	}
+
+	EntriesChanged::EntriesChanged( xmmsv_t* val ) :
+		added( getEntriesList( val, "added" ) ),
+		changed( getEntriesList( val, "changed" ) )
+	{
+	}
+
 	Medialib::~Medialib()
 	{
 	}
@@ -235,6 +252,14 @@ namespace Xmms
 		return IntSignal( res, ml_ );
 	}
 
+	EntriesChangedSignal Medialib::broadcastEntriesChanged() const
+	{
+		xmmsc_result_t* res =
+			call( connected_,
+			      boost::bind( xmmsc_broadcast_medialib_entries_changed, conn_ ) );
+		return EntriesChangedSignal( res, ml_ );
+	}
+
 	Medialib::Medialib( xmmsc_connection_t*& conn, bool& connected,
 	                    MainloopInterface*& ml ) :
 		conn_( conn ), connected_( connected ), ml_( ml )
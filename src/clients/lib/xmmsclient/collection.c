@@ -302,6 +302,75 @@ xmmsc_coll_query (xmmsc_connection_t *conn, xmmsv_t *coll, xmmsv_t *fetch)
 	                       XMMSV_LIST_END);
 }
 
+/**
+ * Finds all media in the collection, and keeps them on the server to
+ * be fetched page by page with #xmmsc_coll_query_next.
+ *
+ * This avoids building and transferring the whole result at once for
+ * big collections. The fetch specification is applied to each page
+ * on its own, so it should produce one item per media, like a
+ * cluster-list by position does.
+ *
+ * @param conn  The connection to the server.
+ * @param coll  The collection used to query.
+ * @param fetch The fetch specification used for each page.
+ * @return The id of the cursor, to pass to #xmmsc_coll_query_next.
+ */
+xmmsc_result_t*
+xmmsc_coll_query_open (xmmsc_connection_t *conn, xmmsv_t *coll, xmmsv_t *fetch)
+{
+	x_check_conn (conn, NULL);
+	x_api_error_if (!coll, "with a NULL collection", NULL);
+	x_api_error_if (!fetch, "with a NULL fetch specification", NULL);
+
+	return xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_COLLECTION,
+	                       XMMS_IPC_COMMAND_COLLECTION_QUERY_OPEN,
+	                       XMMSV_LIST_ENTRY (xmmsv_ref (coll)),
+	                       XMMSV_LIST_ENTRY (xmmsv_ref (fetch)),
+	                       XMMSV_LIST_END);
+}
+
+/**
+ * Fetch the next page of a cursor opened with #xmmsc_coll_query_open.
+ * Once all media have been fetched, the result is none and the
+ * cursor is closed.
+ *
+ * @param conn  The connection to the server.
+ * @param cursor  The id of the cursor.
+ * @param count  The maximum number of media in the page.
+ * @return An xmmsv_t with the structure specified in fetch.
+ */
+xmmsc_result_t*
+xmmsc_coll_query_next (xmmsc_connection_t *conn, int cursor, int count)
+{
+	x_check_conn (conn, NULL);
+	x_api_error_if (count <= 0, "with a non-positive page size", NULL);
+
+	return xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_COLLECTION,
+	                       XMMS_IPC_COMMAND_COLLECTION_QUERY_NEXT,
+	                       XMMSV_LIST_ENTRY_INT (cursor),
+	                       XMMSV_LIST_ENTRY_INT (count),
+	                       XMMSV_LIST_END);
+}
+
+/**
+ * Close a cursor opened with #xmmsc_coll_query_open before all its
+ * media have been fetched.
+ *
+ * @param conn  The connection to the server.
+ * @param cursor  The id of the cursor.
+ */
+xmmsc_result_t*
+xmmsc_coll_query_close (xmmsc_connection_t *conn, int cursor)
+{
+	x_check_conn (conn, NULL);
+
+	return xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_COLLECTION,
+	                       XMMS_IPC_COMMAND_COLLECTION_QUERY_CLOSE,
+	                       XMMSV_LIST_ENTRY_INT (cursor),
+	                       XMMSV_LIST_END);
+}
+
 /**
  * Request the collection changed broadcast from the server. Everytime someone
  * manipulates a collection this will be emitted.
@@ -32,11 +32,19 @@
 #include <xmmsc/xmmsc_stdint.h>
 #include <xmmsc/xmmsc_sockets.h>
 
+/* Number of buckets the result index starts with, always a power of two */
+#define XMMSC_IPC_RESULTS_BUCKETS 32
 
 struct xmmsc_ipc_St {
 	xmms_ipc_transport_t *transport;
 	xmms_ipc_msg_t *read_msg;
-	x_list_t *results_list;
+
+	/* outstanding results hashed on their cookie, the cookies are
+	 * handed out sequentially so the low bits make a good hash */
+	x_list_t **results;
+	unsigned int results_buckets;
+	unsigned int results_count;
+
 	x_queue_t *out_msg;
 	char *error;
 	bool disconnect;
@@ -56,6 +64,10 @@ struct xmmsc_ipc_St {
 static inline void xmmsc_ipc_lock (xmmsc_ipc_t *ipc);
 static inline void xmmsc_ipc_unlock (xmmsc_ipc_t *ipc);
 static void xmmsc_ipc_exec_msg (xmmsc_ipc_t *ipc, xmms_ipc_msg_t *msg);
+static void xmmsc_ipc_results_grow (xmmsc_ipc_t *ipc);
+
+#define XMMSC_IPC_RESULTS_BUCKET(ipc, cookie) \
+	((ipc)->results[(cookie) & ((ipc)->results_buckets - 1)])
 
 
 int
@@ -170,7 +182,8 @@ xmmsc_ipc_init (void)
 	xmmsc_ipc_t *ipc;
 	ipc = x_new0 (xmmsc_ipc_t, 1);
 	ipc->disconnect = false;
-	ipc->results_list = NULL;
+	ipc->results = x_new0 (x_list_t *, XMMSC_IPC_RESULTS_BUCKETS);
+	ipc->results_buckets = XMMSC_IPC_RESULTS_BUCKETS;
 	ipc->out_msg = x_queue_new ();
 
 	return ipc;
@@ -209,7 +222,42 @@ xmmsc_ipc_result_register (xmmsc_ipc_t *ipc, xmmsc_result_t *res)
 	x_return_if_fail (res);
 
 	xmmsc_ipc_lock (ipc);
-	ipc->results_list = x_list_prepend (ipc->results_list, res);
+
+	if (ipc->results_count >= ipc->results_buckets * 2) {
+		xmmsc_ipc_results_grow (ipc);
+	}
+
+	XMMSC_IPC_RESULTS_BUCKET (ipc, xmmsc_result_cookie_get (res)) =
+		x_list_prepend (XMMSC_IPC_RESULTS_BUCKET (ipc, xmmsc_result_cookie_get (res)), res);
+	ipc->results_count++;
+
+	xmmsc_ipc_unlock (ipc);
+}
+
+/**
+ * Move a registered result to the bucket of its new cookie, to be called
+ * after the cookie of a restarted signal has changed.
+ */
+void
+xmmsc_ipc_result_rekey (xmmsc_ipc_t *ipc, xmmsc_result_t *res, uint32_t old_cookie)
+{
+	x_list_t *n;
+
+	x_return_if_fail (ipc);
+	x_return_if_fail (res);
+
+	xmmsc_ipc_lock (ipc);
+
+	for (n = XMMSC_IPC_RESULTS_BUCKET (ipc, old_cookie); n; n = x_list_next (n)) {
+		if (n->data == res) {
+			XMMSC_IPC_RESULTS_BUCKET (ipc, old_cookie) =
+				x_list_delete_link (XMMSC_IPC_RESULTS_BUCKET (ipc, old_cookie), n);
+			XMMSC_IPC_RESULTS_BUCKET (ipc, xmmsc_result_cookie_get (res)) =
+				x_list_prepend (XMMSC_IPC_RESULTS_BUCKET (ipc, xmmsc_result_cookie_get (res)), res);
+			break;
+		}
+	}
+
 	xmmsc_ipc_unlock (ipc);
 }
 
@@ -223,7 +271,7 @@ xmmsc_ipc_result_lookup (xmmsc_ipc_t *ipc, uint32_t cookie)
 
 	xmmsc_ipc_lock (ipc);
 
-	for (n = ipc->results_list; n; n = x_list_next (n)) {
+	for (n = XMMSC_IPC_RESULTS_BUCKET (ipc, cookie); n; n = x_list_next (n)) {
 		xmmsc_result_t *tmp = n->data;
 
 		if (cookie == xmmsc_result_cookie_get (tmp)) {
@@ -247,11 +295,13 @@ xmmsc_ipc_result_unregister (xmmsc_ipc_t *ipc, xmmsc_result_t *res)
 
 	xmmsc_ipc_lock (ipc);
 
-	for (n = ipc->results_list; n; n = x_list_next (n)) {
+	for (n = XMMSC_IPC_RESULTS_BUCKET (ipc, xmmsc_result_cookie_get (res)); n; n = x_list_next (n)) {
 		xmmsc_result_t *tmp = n->data;
 
 		if (xmmsc_result_cookie_get (res) == xmmsc_result_cookie_get (tmp)) {
-			ipc->results_list = x_list_delete_link (ipc->results_list, n);
+			XMMSC_IPC_RESULTS_BUCKET (ipc, xmmsc_result_cookie_get (res)) =
+				x_list_delete_link (XMMSC_IPC_RESULTS_BUCKET (ipc, xmmsc_result_cookie_get (res)), n);
+			ipc->results_count--;
 			xmmsc_result_clear_weakrefs (res);
 			break;
 		}
@@ -325,16 +375,20 @@ void
 xmmsc_ipc_destroy (xmmsc_ipc_t *ipc)
 {
 	x_list_t *n;
+	unsigned int i;
 
 	if (!ipc)
 		return;
 
-	for (n = ipc->results_list; n; n = x_list_next (n)) {
-		xmmsc_result_t *tmp = n->data;
-		xmmsc_result_clear_weakrefs (tmp);
+	for (i = 0; i < ipc->results_buckets; i++) {
+		for (n = ipc->results[i]; n; n = x_list_next (n)) {
+			xmmsc_result_t *tmp = n->data;
+			xmmsc_result_clear_weakrefs (tmp);
+		}
+		x_list_free (ipc->results[i]);
 	}
+	free (ipc->results);
 
-	x_list_free (ipc->results_list);
 	if (ipc->transport) {
 		xmms_ipc_transport_destroy (ipc->transport);
 	}
@@ -392,6 +446,35 @@ xmmsc_ipc_unlock (xmmsc_ipc_t *ipc)
 		ipc->unlockfunc (ipc->lockdata);
 }
 
+/* Double the number of buckets, called with the ipc lock held. */
+static void
+xmmsc_ipc_results_grow (xmmsc_ipc_t *ipc)
+{
+	x_list_t **old, *n;
+	unsigned int i, buckets;
+
+	old = ipc->results;
+	buckets = ipc->results_buckets;
+
+	ipc->results = x_new0 (x_list_t *, buckets * 2);
+	if (!ipc->results) {
+		ipc->results = old;
+		return;
+	}
+	ipc->results_buckets = buckets * 2;
+
+	for (i = 0; i < buckets; i++) {
+		for (n = old[i]; n; n = x_list_next (n)) {
+			xmmsc_result_t *tmp = n->data;
+			XMMSC_IPC_RESULTS_BUCKET (ipc, xmmsc_result_cookie_get (tmp)) =
+				x_list_prepend (XMMSC_IPC_RESULTS_BUCKET (ipc, xmmsc_result_cookie_get (tmp)), tmp);
+		}
+		x_list_free (old[i]);
+	}
+
+	free (old);
+}
+
 static void
 xmmsc_ipc_exec_msg (xmmsc_ipc_t *ipc, xmms_ipc_msg_t *msg)
 {
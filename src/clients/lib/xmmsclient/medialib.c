@@ -316,6 +316,36 @@ xmmsc_medialib_get_info (xmmsc_connection_t *c, int id)
 	                       XMMSV_LIST_ENTRY_INT (id), XMMSV_LIST_END);
 }
 
+/**
+ * Retrieve information about several entries from the medialib in
+ * one call. The result is a list with one entry per id, in the same
+ * order, each in the form #xmmsc_medialib_get_info returns, or none
+ * for ids that don't exist.
+ *
+ * @param c The connection structure.
+ * @param ids A list of medialib ids.
+ * @param keys A list of the property keys to return, or NULL for all.
+ * @param sources A list of the sources to return properties from, or
+ * NULL for all.
+ */
+xmmsc_result_t *
+xmmsc_medialib_get_info_batch (xmmsc_connection_t *c, xmmsv_t *ids,
+                               xmmsv_t *keys, xmmsv_t *sources)
+{
+	x_check_conn (c, NULL);
+	x_api_error_if (!ids, "with a NULL id list", NULL);
+
+	keys = keys ? xmmsv_ref (keys) : xmmsv_new_list ();
+	sources = sources ? xmmsv_ref (sources) : xmmsv_new_list ();
+
+	return xmmsc_send_cmd (c, XMMS_IPC_OBJECT_MEDIALIB,
+	                       XMMS_IPC_COMMAND_MEDIALIB_GET_INFO_BATCH,
+	                       XMMSV_LIST_ENTRY (xmmsv_ref (ids)),
+	                       XMMSV_LIST_ENTRY (keys),
+	                       XMMSV_LIST_ENTRY (sources),
+	                       XMMSV_LIST_END);
+}
+
 /**
  * Request the medialib_entry_added broadcast. This will be called
  * if a new entry is added to the medialib serverside.
@@ -370,6 +400,22 @@ xmmsc_broadcast_medialib_entry_removed (xmmsc_connection_t *c)
 	return xmmsc_send_broadcast_msg (c, XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_REMOVED);
 }
 
+/**
+ * Request the medialib_entries_changed broadcast. This will be called
+ * when a lot of entries are added or changed at once on the serverside.
+ * A connection listening to it gets it instead of the
+ * medialib_entry_added and medialib_entry_changed broadcasts for those
+ * entries. The argument will be a dict with the "added" and "changed"
+ * lists of medialib ids.
+ */
+xmmsc_result_t *
+xmmsc_broadcast_medialib_entries_changed (xmmsc_connection_t *c)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_broadcast_msg (c, XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED);
+}
+
 /**
  * Associate a int value with a medialib entry. Uses default
  * source which is client/&lt;clientname&gt;
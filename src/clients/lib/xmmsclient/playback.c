@@ -198,6 +198,23 @@ xmmsc_signal_playback_playtime (xmmsc_connection_t *c)
 	return xmmsc_send_signal_msg (c, XMMS_IPC_SIGNAL_PLAYBACK_PLAYTIME);
 }
 
+/**
+ * Request the playback_playtime signal, delivered at most rate times
+ * per second. The server updates the playtime every 100 ms, so rates
+ * above 10 make no difference; a rate of 0 or less removes the limit.
+ * Status bars that only show seconds will want a rate of 1.
+ * The latest playtime is not lost in between: it is delivered when the
+ * interval ends, or right away when the playback status changes.
+ */
+xmmsc_result_t *
+xmmsc_signal_playback_playtime_rate (xmmsc_connection_t *c, int rate)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_signal_msg_interval (c, XMMS_IPC_SIGNAL_PLAYBACK_PLAYTIME,
+	                                       rate > 0 ? 1000 / rate : 0);
+}
+
 /**
  * Make server emit the current playtime.
  */
@@ -55,6 +55,29 @@ xmmsc_main_stats (xmmsc_connection_t *c)
 	return xmmsc_send_msg_no_arg (c, XMMS_IPC_OBJECT_MAIN, XMMS_IPC_COMMAND_MAIN_STATS);
 }
 
+/**
+ * Get the profiling counters of the playback pipeline from the server
+ */
+xmmsc_result_t *
+xmmsc_main_profile (xmmsc_connection_t *c)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_msg_no_arg (c, XMMS_IPC_OBJECT_MAIN, XMMS_IPC_COMMAND_MAIN_PROFILE);
+}
+
+/**
+ * Request the profiling counters broadcast, sent every
+ * core.profile_interval seconds.
+ */
+xmmsc_result_t *
+xmmsc_broadcast_main_profile (xmmsc_connection_t *c)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_broadcast_msg (c, XMMS_IPC_SIGNAL_MAIN_PROFILE);
+}
+
 /**
  * Request status for the mediainfo reader. It can be idle or working
  */
@@ -397,6 +397,26 @@ xmmsc_send_signal_msg (xmmsc_connection_t *c, int signalid)
 	return res;
 }
 
+/**
+ * Like #xmmsc_send_signal_msg, but asks the server not to deliver the
+ * signal more often than once every interval milliseconds. The server
+ * keeps the interval when the signal is restarted.
+ */
+xmmsc_result_t *
+xmmsc_send_signal_msg_interval (xmmsc_connection_t *c, int signalid,
+                                int interval)
+{
+	xmmsc_result_t *res;
+
+	res = xmmsc_send_cmd (c, XMMS_IPC_OBJECT_SIGNAL, XMMS_IPC_COMMAND_SIGNAL,
+	                      XMMSV_LIST_ENTRY_INT (signalid),
+	                      XMMSV_LIST_ENTRY_INT (interval), XMMSV_LIST_END);
+
+	xmmsc_result_restartable (res, signalid);
+
+	return res;
+}
+
 xmmsc_result_t *
 xmmsc_send_msg_no_arg (xmmsc_connection_t *c, int object, int method)
 {
@@ -41,9 +41,19 @@ typedef struct cli_move_positions_St {
 	gint pos;
 } cli_move_positions_t;
 
-typedef struct cli_list_positions_St {
+/* Number of entries fetched per get_info_batch call when listing */
+#define CLI_LIST_BATCH_SIZE 256
+
+typedef struct cli_list_batch_St {
 	xmmsc_connection_t *sync;
 	column_display_t *coldisp;
+	/* ids waiting to be fetched, and their playlist positions */
+	xmmsv_t *ids;
+	GArray *positions;
+} cli_list_batch_t;
+
+typedef struct cli_list_positions_St {
+	cli_list_batch_t *batch;
 	xmmsv_t *entries;
 } cli_list_positions_t;
 
@@ -238,6 +248,68 @@ cli_list_print_row (column_display_t *coldisp, xmmsv_t *propdict)
 	column_display_print (coldisp, info);
 }
 
+static void
+cli_list_batch_init (cli_list_batch_t *batch, cli_context_t *ctx,
+                     column_display_t *coldisp)
+{
+	batch->sync = cli_context_xmms_sync (ctx);
+	batch->coldisp = coldisp;
+	batch->ids = xmmsv_new_list ();
+	batch->positions = g_array_new (FALSE, FALSE, sizeof (gint));
+}
+
+static void
+cli_list_batch_print (cli_list_batch_t *batch, xmmsv_t *infos)
+{
+	xmmsv_t *propdict;
+	gint i;
+
+	for (i = 0; xmmsv_list_get (infos, i, &propdict); i++) {
+		if (xmmsv_is_type (propdict, XMMSV_TYPE_NONE)) {
+			g_printf (_("Server error: %s\n"), "No such entry");
+			continue;
+		}
+		column_display_set_position (batch->coldisp,
+		                             g_array_index (batch->positions, gint, i));
+		cli_list_print_row (batch->coldisp, propdict);
+	}
+}
+
+/* Fetch and print the rows queued so far */
+static void
+cli_list_batch_flush (cli_list_batch_t *batch)
+{
+	if (xmmsv_list_get_size (batch->ids) == 0) {
+		return;
+	}
+
+	XMMS_CALL_CHAIN (XMMS_CALL_P (xmmsc_medialib_get_info_batch, batch->sync, batch->ids, NULL, NULL),
+	                 FUNC_CALL_P (cli_list_batch_print, batch, XMMS_PREV_VALUE));
+
+	xmmsv_list_clear (batch->ids);
+	g_array_set_size (batch->positions, 0);
+}
+
+static void
+cli_list_batch_add (cli_list_batch_t *batch, gint pos, gint id)
+{
+	xmmsv_list_append_int (batch->ids, id);
+	g_array_append_val (batch->positions, pos);
+
+	if (xmmsv_list_get_size (batch->ids) >= CLI_LIST_BATCH_SIZE) {
+		cli_list_batch_flush (batch);
+	}
+}
+
+static void
+cli_list_batch_finish (cli_list_batch_t *batch)
+{
+	cli_list_batch_flush (batch);
+
+	xmmsv_unref (batch->ids);
+	g_array_free (batch->positions, TRUE);
+}
+
 static void
 cli_list_print_positions_row (gint pos, void *udata)
 {
@@ -249,9 +321,7 @@ cli_list_print_positions_row (gint pos, void *udata)
 	}
 
 	if (xmmsv_list_get_int (pack->entries, pos, &id)) {
-		column_display_set_position (pack->coldisp, pos);
-		XMMS_CALL_CHAIN (XMMS_CALL_P (xmmsc_medialib_get_info, pack->sync, id),
-		                 FUNC_CALL_P (cli_list_print_row, pack->coldisp, XMMS_PREV_VALUE));
+		cli_list_batch_add (pack->batch, pos, id);
 	}
 }
 
@@ -259,20 +329,23 @@ static void
 cli_list_print_positions (cli_context_t *ctx, column_display_t *coldisp,
                           xmmsv_t *list, gpointer udata)
 {
+	cli_list_batch_t batch;
 	cli_list_positions_t pudata = {
-		.sync = cli_context_xmms_sync (ctx),
-		.coldisp = coldisp,
+		.batch = &batch,
 		.entries = list
 	};
 	playlist_positions_t *positions = (playlist_positions_t *) udata;
+
+	cli_list_batch_init (&batch, ctx, coldisp);
 	playlist_positions_foreach (positions, cli_list_print_positions_row, TRUE, &pudata);
+	cli_list_batch_finish (&batch);
 }
 
 static void
 cli_list_print_ids (cli_context_t *ctx, column_display_t *coldisp,
                     xmmsv_t *list, gpointer udata)
 {
-	xmmsc_connection_t *conn = cli_context_xmms_sync (ctx);
+	cli_list_batch_t batch;
 	xmmsv_list_iter_t *it;
 	GTree *lookup = NULL;
 	gint id;
@@ -282,16 +355,18 @@ cli_list_print_ids (cli_context_t *ctx, column_display_t *coldisp,
 	if (filter != NULL)
 		lookup = g_tree_new_from_xmmsv (filter);
 
+	cli_list_batch_init (&batch, ctx, coldisp);
+
 	xmmsv_get_list_iter (list, &it);
 	while (xmmsv_list_iter_entry_int (it, &id)) {
-		column_display_set_position (coldisp, xmmsv_list_iter_tell (it));
 		if (lookup == NULL || g_tree_lookup (lookup, GINT_TO_POINTER (id)) != NULL) {
-			XMMS_CALL_CHAIN (XMMS_CALL_P (xmmsc_medialib_get_info, conn, id),
-			                 FUNC_CALL_P (cli_list_print_row, coldisp, XMMS_PREV_VALUE));
+			cli_list_batch_add (&batch, xmmsv_list_iter_tell (it), id);
 		}
 		xmmsv_list_iter_next (it);
 	}
 
+	cli_list_batch_finish (&batch);
+
 	if (lookup)
 		g_tree_destroy (lookup);
 }
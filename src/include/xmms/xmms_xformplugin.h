@@ -51,7 +51,7 @@
 
 
 
-#define XMMS_XFORM_API_VERSION 7
+#define XMMS_XFORM_API_VERSION 8
 
 #include <xmms/xmms_error.h>
 #include <xmms/xmms_plugin.h>
@@ -170,6 +170,28 @@ typedef struct xmms_xform_methods_St {
 	 * This is called without init() beeing called.
 	 */
 	gboolean (*browse)(xmms_xform_t *, const gchar *, xmms_error_t *);
+
+	/**
+	 * Process method.
+	 *
+	 * Optional in-place kernel for effect plugins.  It is called with
+	 * a number of frames of interleaved float samples, and lets the
+	 * effect run inside the shared effect stage instead of as an
+	 * xform of its own.  The xform is initialised as usual, but its
+	 * input is always of format #XMMS_SAMPLE_FORMAT_FLOAT and the read
+	 * and seek methods are never called.
+	 */
+	void (*process)(xmms_xform_t *, gfloat *, gint);
+	/**
+	 * Active method.
+	 *
+	 * Optional companion to process.  Returns FALSE while process
+	 * would leave the samples untouched, for example when the effect
+	 * is disabled.  When no effect in the stage is active the stream
+	 * passes through without being converted to float.  Effects
+	 * without it count as always active.
+	 */
+	gboolean (*active)(xmms_xform_t *);
 } xmms_xform_methods_t;
 
 #define XMMS_XFORM_METHODS_INIT(m) memset (&m, 0, sizeof (xmms_xform_methods_t))
@@ -242,6 +264,22 @@ void xmms_xform_plugin_indata_add (xmms_xform_plugin_t *plugin, ...) XMMS_PUBLIC
 
 void xmms_xform_plugin_set_out_stream_type (xmms_xform_plugin_t *plugin, ...) XMMS_PUBLIC;
 
+/**
+ * Declare that the plugin's init method gathers all the metadata
+ * the plugin can provide, without decoding any audio.
+ *
+ * When a chain is only set up to resolve metadata, it ends with
+ * such a plugin, and the xforms that would follow it (usually a
+ * decoder) are never initialised. The chain still fails if no plugin
+ * takes the plugin's output, and segments of a file (startms/stopms)
+ * always get a full chain.
+ *
+ * Should be called from the plugin's setupfunc.
+ *
+ * @param plugin the plugin
+ */
+void xmms_xform_plugin_set_metadata_only (xmms_xform_plugin_t *plugin) XMMS_PUBLIC;
+
 /**
  * Get private data for this xform.
  *
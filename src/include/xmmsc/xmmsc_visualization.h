@@ -127,6 +127,8 @@ typedef struct {
 	int stereo;
 	/* wether the stereo signal should go 00001111 (false) or 01010101 (true) */
 	int pcm_hardwire;
+	/* number of samples the spectrum is computed from, 256 to 8192 */
+	int spectrum_size;
 
 	/* TODO: implement following.. */
 	double freq;
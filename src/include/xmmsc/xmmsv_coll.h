@@ -49,6 +49,7 @@ int xmmsv_coll_idlist_get_index_int32 (xmmsv_t *coll, int index, int32_t *val) X
 int xmmsv_coll_idlist_get_index_int64 (xmmsv_t *coll, int index, int64_t *val) XMMS_PUBLIC;
 int xmmsv_coll_idlist_set_index (xmmsv_t *coll, int index, int64_t val) XMMS_PUBLIC;
 int xmmsv_coll_idlist_get_size (xmmsv_t *coll) XMMS_PUBLIC;
+int xmmsv_coll_idlist_get_ids (xmmsv_t *coll, const int64_t **ids) XMMS_PUBLIC;
 
 int xmmsv_coll_is_type (xmmsv_t *val, xmmsv_coll_type_t t) XMMS_PUBLIC;
 xmmsv_coll_type_t xmmsv_coll_get_type (xmmsv_t *coll) XMMS_PUBLIC;
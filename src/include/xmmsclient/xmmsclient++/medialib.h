@@ -30,6 +30,28 @@ namespace Xmms
 
 	class Client;
 
+	/** @class EntriesChanged medialib.h "xmmsclient/xmmsclient++/medialib.h"
+	 *  @brief The entries announced by the medialib entries changed
+	 *  broadcast.
+	 */
+	class EntriesChanged
+	{
+
+		public:
+
+			/** Constructor, from the value of the broadcast. */
+			EntriesChanged( xmmsv_t* val );
+
+			/** Ids of the added entries. */
+			List< int > added;
+
+			/** Ids of the changed entries. */
+			List< int > changed;
+
+	};
+
+	typedef SignalAdapter< EntriesChanged > EntriesChangedSignal;
+
 	/** @class Medialib medialib.h "xmmsclient/xmmsclient++/medialib.h"
 	 *  @brief This class controls the medialib.
 	 */
@@ -321,6 +343,22 @@ namespace Xmms
 			 */
 			IntSignal broadcastEntryRemoved() const;
 
+			/** Request the medialib entries changed broadcast.
+			 *
+			 *  This will be called when a lot of entries are added or
+			 *  changed at once serverside. A connection listening to
+			 *  it gets it instead of the entry added and entry updated
+			 *  broadcasts for those entries.
+			 *
+			 *  @param slot Function pointer to a function taking a
+			 *              const EntriesChanged& and returning a bool.
+			 *  @param error Function pointer to an error callback
+			 *               function. (<b>optional</b>)
+			 *
+			 *  @throw connection_error If the client isn't connected.
+			 */
+			EntriesChangedSignal broadcastEntriesChanged() const;
+
 		/** @cond */
 		private:
 			friend class Client;
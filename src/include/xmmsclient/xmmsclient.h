@@ -142,6 +142,7 @@ xmmsc_result_t *xmmsc_broadcast_playback_current_id (xmmsc_connection_t *c) XMMS
 
 /* signals */
 xmmsc_result_t *xmmsc_signal_playback_playtime (xmmsc_connection_t *c) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_signal_playback_playtime_rate (xmmsc_connection_t *c, int rate) XMMS_PUBLIC;
 
 
 /*
@@ -166,8 +167,10 @@ xmmsc_result_t *xmmsc_broadcast_config_value_changed (xmmsc_connection_t *c) XMM
 xmmsc_result_t *xmmsc_main_list_plugins (xmmsc_connection_t *c, xmms_plugin_type_t type) XMMS_PUBLIC;
 
 xmmsc_result_t *xmmsc_main_stats (xmmsc_connection_t *c) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_main_profile (xmmsc_connection_t *c) XMMS_PUBLIC;
 
 /* broadcasts */
+xmmsc_result_t *xmmsc_broadcast_main_profile (xmmsc_connection_t *c) XMMS_PUBLIC;
 xmmsc_result_t *xmmsc_broadcast_mediainfo_reader_status (xmmsc_connection_t *c) XMMS_PUBLIC;
 
 /* signals */
@@ -215,6 +218,7 @@ xmmsc_result_t *xmmsc_medialib_add_entry_args (xmmsc_connection_t *conn, const c
 xmmsc_result_t *xmmsc_medialib_add_entry_full (xmmsc_connection_t *conn, const char *url, xmmsv_t *args) XMMS_PUBLIC;
 xmmsc_result_t *xmmsc_medialib_add_entry_encoded (xmmsc_connection_t *conn, const char *url) XMMS_PUBLIC;
 xmmsc_result_t *xmmsc_medialib_get_info (xmmsc_connection_t *, int) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_medialib_get_info_batch (xmmsc_connection_t *c, xmmsv_t *ids, xmmsv_t *keys, xmmsv_t *sources) XMMS_PUBLIC;
 xmmsc_result_t *xmmsc_medialib_path_import (xmmsc_connection_t *conn, const char *path) XMMS_PUBLIC XMMS_DEPRECATED;
 xmmsc_result_t *xmmsc_medialib_path_import_encoded (xmmsc_connection_t *conn, const char *path) XMMS_PUBLIC XMMS_DEPRECATED;
 xmmsc_result_t *xmmsc_medialib_import_path (xmmsc_connection_t *conn, const char *path) XMMS_PUBLIC;
@@ -249,6 +253,7 @@ xmmsc_result_t *xmmsc_broadcast_medialib_entry_changed (xmmsc_connection_t *c) X
 xmmsc_result_t *xmmsc_broadcast_medialib_entry_updated (xmmsc_connection_t *c) XMMS_PUBLIC;
 xmmsc_result_t *xmmsc_broadcast_medialib_entry_added (xmmsc_connection_t *c) XMMS_PUBLIC;
 xmmsc_result_t *xmmsc_broadcast_medialib_entry_removed (xmmsc_connection_t *c) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_broadcast_medialib_entries_changed (xmmsc_connection_t *c) XMMS_PUBLIC;
 
 
 /*
@@ -267,6 +272,9 @@ xmmsc_result_t* xmmsc_coll_sync (xmmsc_connection_t *conn) XMMS_PUBLIC;
 xmmsc_result_t* xmmsc_coll_query_ids (xmmsc_connection_t *conn, xmmsv_t *coll, xmmsv_t *order, int limit_start, int limit_len) XMMS_PUBLIC;
 xmmsc_result_t* xmmsc_coll_query_infos (xmmsc_connection_t *conn, xmmsv_t *coll, xmmsv_t *order, int limit_start, int limit_len, xmmsv_t *fetch, xmmsv_t *group) XMMS_PUBLIC XMMS_DEPRECATED;
 xmmsc_result_t* xmmsc_coll_query (xmmsc_connection_t *conn, xmmsv_t *coll, xmmsv_t *fetch) XMMS_PUBLIC;
+xmmsc_result_t* xmmsc_coll_query_open (xmmsc_connection_t *conn, xmmsv_t *coll, xmmsv_t *fetch) XMMS_PUBLIC;
+xmmsc_result_t* xmmsc_coll_query_next (xmmsc_connection_t *conn, int cursor, int count) XMMS_PUBLIC;
+xmmsc_result_t* xmmsc_coll_query_close (xmmsc_connection_t *conn, int cursor) XMMS_PUBLIC;
 
 /* string-to-collection parser */
 typedef enum {
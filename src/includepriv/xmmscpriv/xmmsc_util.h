@@ -51,6 +51,15 @@ typedef void (*XDestroyNotify) (void *data);
 #define x_malloc0(size) calloc (1, size)
 #define x_malloc(size) malloc (size)
 
+/* reference counts, atomic where the compiler lets us */
+#if defined (__GNUC__)
+#define x_atomic_inc(p) __sync_add_and_fetch ((p), 1)
+#define x_atomic_dec(p) __sync_sub_and_fetch ((p), 1)
+#else
+#define x_atomic_inc(p) (++*(p))
+#define x_atomic_dec(p) (--*(p))
+#endif
+
 /* utility functions */
 char *x_vasprintf (const char *fmt, va_list args) XMMS_FORMAT(printf, 1, 0);
 char *x_asprintf (const char *fmt, ...) XMMS_FORMAT(printf, 1, 2);
@@ -51,13 +51,18 @@ struct xmmsv_St {
 	} value;
 	xmmsv_type_t type;
 
-	int ref;  /* refcounting */
+	int ref;  /* refcounting, updated atomically */
 };
 
 xmmsv_t *_xmmsv_new (xmmsv_type_t type);
 
 void _xmmsv_list_free (xmmsv_list_internal_t *dict);
 void _xmmsv_dict_free (xmmsv_dict_internal_t *dict);
+int _xmmsv_dict_walk (xmmsv_t *dictv, int *pos, const char **key, xmmsv_t **val);
 void _xmmsv_coll_free (xmmsv_coll_internal_t *coll);
 
+unsigned int _xmmsv_list_generation (xmmsv_t *listv);
+
+int _xmmsv_coll_idlist_set_ids (xmmsv_t *coll, const int64_t *ids, int size);
+
 #endif
@@ -24,7 +24,15 @@
 typedef struct xmms_sample_converter_St xmms_sample_converter_t;
 typedef guint (*xmms_sample_conv_func_t) (xmms_sample_converter_t *, xmms_sample_t *, guint , xmms_sample_t *);
 
-xmms_sample_converter_t *xmms_sample_converter_init (xmms_stream_type_t *from, xmms_stream_type_t *to);
+typedef enum {
+	XMMS_SAMPLE_RESAMPLE_LINEAR,
+	XMMS_SAMPLE_RESAMPLE_LOW,
+	XMMS_SAMPLE_RESAMPLE_MEDIUM,
+	XMMS_SAMPLE_RESAMPLE_HIGH
+} xmms_sample_resample_quality_t;
+
+xmms_sample_converter_t *xmms_sample_converter_init (xmms_stream_type_t *from, xmms_stream_type_t *to, xmms_sample_resample_quality_t quality);
+xmms_sample_resample_quality_t xmms_sample_resample_quality_from_string (const gchar *name);
 
 gint64 xmms_sample_convert_scale (xmms_sample_converter_t *conv, gint64 samples);
 gint64 xmms_sample_convert_rev_scale (xmms_sample_converter_t *conv, gint64 samples);
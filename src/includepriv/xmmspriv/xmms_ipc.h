@@ -17,6 +17,21 @@ xmms_ipc_manager_t *xmms_ipc_manager_get (void);
 gboolean xmms_ipc_has_pending (guint signalid);
 void xmms_ipc_send_message (gint cli, xmms_ipc_msg_t *msg, xmms_error_t *err);
 void xmms_ipc_send_broadcast (guint broadcastid, gint cli, xmmsv_t *arg, xmms_error_t *err);
+void xmms_ipc_broadcast_each (guint broadcastid, xmmsv_t *args, guint unless);
 GList *xmms_ipc_get_connected_clients (void);
+void xmms_ipc_signal_flush (guint signalid);
+
+/** How often a client wants a signal, and the value held back meanwhile */
+typedef struct xmms_ipc_signal_rate_St {
+	/** Minimum time between two deliveries, in microseconds */
+	gint64 interval;
+	/** When the signal was last delivered */
+	gint64 last;
+	xmmsv_t *held;
+} xmms_ipc_signal_rate_t;
+
+xmmsv_t *xmms_ipc_signal_rate_offer (xmms_ipc_signal_rate_t *rate, xmmsv_t *arg, gint64 now);
+xmmsv_t *xmms_ipc_signal_rate_take (xmms_ipc_signal_rate_t *rate, gint64 now);
+void xmms_ipc_signal_rate_clear (xmms_ipc_signal_rate_t *rate);
 
 #endif
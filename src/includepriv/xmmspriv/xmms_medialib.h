@@ -36,8 +36,10 @@ s4_sourcepref_t *xmms_medialib_get_source_preferences (xmms_medialib_t *medialib
 char *xmms_medialib_uuid (xmms_medialib_t *mlib);
 s4_resultset_t *xmms_medialib_session_query (xmms_medialib_session_t *s, s4_fetchspec_t *spec, s4_condition_t *cond);
 
-guint xmms_medialib_num_not_resolved (xmms_medialib_session_t *s);
-xmms_medialib_entry_t xmms_medialib_entry_not_resolved_get (xmms_medialib_session_t *s);
+guint xmms_medialib_num_not_resolved (xmms_medialib_t *medialib);
+xmms_medialib_entry_t xmms_medialib_entry_not_resolved_get (xmms_medialib_t *medialib);
+GList *xmms_medialib_entries_not_resolved_get (xmms_medialib_t *medialib);
+gboolean xmms_medialib_unresolved_commit (xmms_medialib_t *medialib, s4_transaction_t *trans, GHashTable *changes);
 
 xmms_medialib_entry_t xmms_medialib_entry_new (xmms_medialib_session_t *s, const char *url, xmms_error_t *error);
 xmms_medialib_entry_t xmms_medialib_entry_new_encoded (xmms_medialib_session_t *s, const char *url, xmms_error_t *error);
@@ -70,10 +72,14 @@ xmmsv_t *xmms_medialib_query_to_xmmsv (s4_resultset_t *set, xmms_fetch_spec_t *s
 
 xmms_medialib_session_t *xmms_medialib_session_begin (xmms_medialib_t *mlib);
 xmms_medialib_session_t *xmms_medialib_session_begin_ro (xmms_medialib_t *medialib);
+xmms_medialib_session_t *xmms_medialib_session_begin_bulk (xmms_medialib_t *medialib);
 void xmms_medialib_session_abort (xmms_medialib_session_t *session);
 gboolean xmms_medialib_session_commit (xmms_medialib_session_t *session);
 s4_resultset_t *xmms_medialib_session_query (xmms_medialib_session_t *session, s4_fetchspec_t *specification, s4_condition_t *condition);
 s4_sourcepref_t *xmms_medialib_session_get_source_preferences (xmms_medialib_session_t *session);
+xmms_medialib_t *xmms_medialib_session_get_medialib (xmms_medialib_session_t *session);
+void xmms_medialib_session_track_new_id (xmms_medialib_session_t *session, gint32 id);
+gint32 xmms_medialib_session_get_next_id (xmms_medialib_session_t *session);
 void xmms_medialib_session_track_garbage (xmms_medialib_session_t *session, xmmsv_t *data);
 gint xmms_medialib_session_property_set (xmms_medialib_session_t *session, xmms_medialib_entry_t entry, const gchar *key, const s4_val_t *value, const gchar *source);
 gint xmms_medialib_session_property_unset (xmms_medialib_session_t *session, xmms_medialib_entry_t entry, const gchar *key, const s4_val_t *value, const gchar *source);
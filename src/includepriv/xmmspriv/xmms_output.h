@@ -23,6 +23,7 @@
 #include <xmms/xmms_outputplugin.h>
 #include <xmmspriv/xmms_playlist.h>
 #include <xmmspriv/xmms_plugin.h>
+#include <xmmspriv/xmms_ringbuf.h>
 
 /*
  * Private function prototypes -- do NOT use in plugins.
@@ -40,4 +41,12 @@ guint32 xmms_output_latency (xmms_output_t *output);
 
 gboolean xmms_output_plugin_switch (xmms_output_t *output, xmms_output_plugin_t *new_plugin);
 
+void xmms_output_read_stats_get (xmms_output_t *output, guint64 *filler_reads, guint64 *xform_reads, guint64 *xform_plugin_reads, guint *chunk_size);
+xmmsv_t *xmms_output_profile_get (xmms_output_t *output);
+
+gint xmms_output_read_reserve (xmms_output_t *output, gconstpointer *buffer, gint len);
+void xmms_output_read_commit (xmms_output_t *output, gint len);
+
+guint xmms_output_sink_queue (xmms_ringbuf_t *ringbuf, GMutex *mutex, gboolean block, guint frame_size, gconstpointer data, guint len, guint64 *dropped);
+
 #endif
@@ -25,6 +25,8 @@
 typedef struct xmms_ringbuf_St xmms_ringbuf_t;
 
 xmms_ringbuf_t *xmms_ringbuf_new (guint size);
+xmms_ringbuf_t *xmms_ringbuf_new_lockfree (guint size, GMutex *hotspot_mutex);
+gboolean xmms_ringbuf_is_lockfree (const xmms_ringbuf_t *ringbuf);
 void xmms_ringbuf_destroy (xmms_ringbuf_t *ringbuf);
 void xmms_ringbuf_clear (xmms_ringbuf_t *ringbuf);
 guint xmms_ringbuf_bytes_free (const xmms_ringbuf_t *ringbuf);
@@ -39,6 +41,11 @@ void xmms_ringbuf_hotspot_set (xmms_ringbuf_t *ringbuf, gboolean (*cb) (void *),
 guint xmms_ringbuf_write (xmms_ringbuf_t *ringbuf, gconstpointer data, guint length);
 guint xmms_ringbuf_write_wait (xmms_ringbuf_t *ringbuf, gconstpointer data, guint length, GMutex *mtx);
 
+gpointer xmms_ringbuf_write_reserve (xmms_ringbuf_t *ringbuf, guint *length);
+void xmms_ringbuf_write_commit (xmms_ringbuf_t *ringbuf, guint length);
+gconstpointer xmms_ringbuf_read_reserve (xmms_ringbuf_t *ringbuf, guint *length);
+void xmms_ringbuf_read_commit (xmms_ringbuf_t *ringbuf, guint length);
+
 void xmms_ringbuf_wait_free (xmms_ringbuf_t *ringbuf, guint len, GMutex *mtx);
 void xmms_ringbuf_wait_used (xmms_ringbuf_t *ringbuf, guint len, GMutex *mtx);
 
@@ -27,5 +27,6 @@ struct xmms_visualization_St;
 typedef struct xmms_visualization_St xmms_visualization_t;
 
 xmms_visualization_t *xmms_visualization_new (xmms_output_t *output);
+void xmms_visualization_stats_get (xmms_visualization_t *vis, guint *frames_sent, guint *frames_dropped);
 
 #endif
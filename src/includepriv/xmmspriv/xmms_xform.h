@@ -34,12 +34,17 @@ gboolean xmms_xform_plugin_verify (xmms_plugin_t *plugin);
 
 xmms_xform_t *xmms_xform_chain_setup (xmms_medialib_t *medialib, xmms_medialib_entry_t entry, GList *goal_formats, gboolean rehash);
 xmms_xform_t *xmms_xform_chain_setup_session (xmms_medialib_t *medialib, xmms_medialib_session_t *session, xmms_medialib_entry_t entry, GList *goal_fmts, gboolean rehash);
+xmms_xform_t *xmms_xform_chain_setup_metadata_session (xmms_medialib_t *medialib, xmms_medialib_session_t *session, xmms_medialib_entry_t entry, GList *goal_fmts);
 xmms_xform_t *xmms_xform_chain_setup_url_session (xmms_medialib_t *medialib, xmms_medialib_session_t *session, xmms_medialib_entry_t entry, const gchar *url, GList *goal_fmts, gboolean rehash);
 xmms_xform_t *xmms_xform_chain_setup_url (xmms_medialib_t *medialib, xmms_medialib_entry_t entry, const gchar *url, GList *goal_formats, gboolean rehash);
 
 gint64 xmms_xform_this_seek (xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whence, xmms_error_t *err);
 int xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, int siz, xmms_error_t *err);
+void xmms_xform_this_process (xmms_xform_t *xform, gfloat *buf, gint frames);
+gboolean xmms_xform_this_active (xmms_xform_t *xform);
 gboolean xmms_xform_iseos (xmms_xform_t *xform);
+void xmms_xform_chain_read_calls (xmms_xform_t *xform, guint64 *reads, guint64 *plugin_reads);
+xmmsv_t *xmms_xform_chain_profile (xmms_xform_t *xform);
 
 const GList *xmms_xform_goal_hints_get (xmms_xform_t *xform);
 xmms_stream_type_t *xmms_xform_intype_get (xmms_xform_t *xform);
@@ -50,6 +55,8 @@ xmmsv_t *xmms_xform_browse_method (xmms_xform_t *xform, const gchar *url, xmms_e
 
 const char *xmms_xform_indata_find_str (xmms_xform_t *xform, xmms_stream_type_key_t key);
 
+void xmms_effect_stage_kernel_add (xmms_xform_t *stage, xmms_xform_t *kernel);
+
 #define XMMS_XFORM_BUILTIN_DEFINE(shname, name, ver, desc, setupfunc) XMMS_BUILTIN_DEFINE(XMMS_PLUGIN_TYPE_XFORM, XMMS_XFORM_API_VERSION, shname, name, ver, desc, (gboolean (*)(gpointer))setupfunc)
 
 #endif
@@ -21,6 +21,8 @@ gboolean xmms_xform_plugin_can_read (const xmms_xform_plugin_t *plugin);
 gboolean xmms_xform_plugin_can_seek (const xmms_xform_plugin_t *plugin);
 gboolean xmms_xform_plugin_can_browse (const xmms_xform_plugin_t *plugin);
 gboolean xmms_xform_plugin_can_destroy (const xmms_xform_plugin_t *plugin);
+gboolean xmms_xform_plugin_can_metadata_only (const xmms_xform_plugin_t *plugin);
+gboolean xmms_xform_plugin_can_process (const xmms_xform_plugin_t *plugin);
 
 gboolean xmms_xform_plugin_init (const xmms_xform_plugin_t *plugin, xmms_xform_t *xform);
 gboolean xmms_xform_plugin_metadata_mapper_match (const xmms_xform_plugin_t *xform_plugin, xmms_xform_t *xform, const gchar *key, const gchar *value, gsize length);
@@ -28,6 +30,9 @@ gint xmms_xform_plugin_read (const xmms_xform_plugin_t *plugin, xmms_xform_t *xf
 gint64 xmms_xform_plugin_seek (const xmms_xform_plugin_t *plugin, xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whence, xmms_error_t *err);
 gboolean xmms_xform_plugin_browse (const xmms_xform_plugin_t *plugin, xmms_xform_t *xform, const gchar *url, xmms_error_t *error);
 void xmms_xform_plugin_destroy (const xmms_xform_plugin_t *plugin, xmms_xform_t *xform);
+void xmms_xform_plugin_process (xmms_xform_plugin_t *plugin, xmms_xform_t *xform, gfloat *buf, gint frames);
+gboolean xmms_xform_plugin_active (const xmms_xform_plugin_t *plugin, xmms_xform_t *xform);
+xmmsv_t *xmms_xform_plugin_process_stats (void);
 
 gboolean xmms_xform_plugin_supports (const xmms_xform_plugin_t *plugin, const xmms_stream_type_t *st, gint *priority);
 
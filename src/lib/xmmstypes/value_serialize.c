@@ -20,6 +20,10 @@
 #include <xmmsc/xmmsc_stdbool.h>
 #include <xmmsc/xmmsv.h>
 #include <xmmscpriv/xmmsc_util.h>
+#include <xmmscpriv/xmmsv.h>
+
+/* number of ids converted per chunk when (de)serializing an idlist */
+#define IDLIST_CHUNK 256
 
 static bool _internal_put_on_bb_bin (xmmsv_t *bb, const unsigned char *data, unsigned int len);
 static bool _internal_put_on_bb_error (xmmsv_t *bb, const char *errmsg);
@@ -28,6 +32,7 @@ static bool _internal_put_on_bb_int64 (xmmsv_t *bb, int64_t v);
 static bool _internal_put_on_bb_float (xmmsv_t *bb, float v);
 static bool _internal_put_on_bb_string (xmmsv_t *bb, const char *str);
 static bool _internal_put_on_bb_collection (xmmsv_t *bb, xmmsv_t *coll);
+static bool _internal_put_on_bb_idlist (xmmsv_t *bb, xmmsv_t *coll);
 static bool _internal_put_on_bb_value_list (xmmsv_t *bb, xmmsv_t *v);
 static bool _internal_put_on_bb_value_dict (xmmsv_t *bb, xmmsv_t *v);
 
@@ -41,6 +46,7 @@ static bool _internal_get_from_bb_int64 (xmmsv_t *bb, int64_t *v);
 static bool _internal_get_from_bb_float (xmmsv_t *bb, float *v);
 static bool _internal_get_from_bb_string_alloc (xmmsv_t *bb, char **buf, unsigned int *len);
 static bool _internal_get_from_bb_collection_alloc (xmmsv_t *bb, xmmsv_t **coll);
+static bool _internal_get_from_bb_idlist (xmmsv_t *bb, xmmsv_t *coll);
 static bool _internal_get_from_bb_value_dict_alloc (xmmsv_t *bb, xmmsv_t **val);
 static bool _internal_get_from_bb_value_list_alloc (xmmsv_t *bb, xmmsv_t **val);
 
@@ -146,7 +152,7 @@ _internal_put_on_bb_collection (xmmsv_t *bb, xmmsv_t *coll)
 	}
 
 	/* idlist */
-	if (!_internal_put_on_bb_value_list (bb, xmmsv_coll_idlist_get (coll))) {
+	if (!_internal_put_on_bb_idlist (bb, coll)) {
 		return false;
 	}
 
@@ -168,17 +174,54 @@ _internal_put_on_bb_collection (xmmsv_t *bb, xmmsv_t *coll)
 	return true;
 }
 
+/* Same layout as an INT64 restricted list, but written from the
+ * packed ids in chunks rather than one value at a time.
+ */
 static bool
-_internal_put_on_bb_value_list (xmmsv_t *bb, xmmsv_t *v)
+_internal_put_on_bb_idlist (xmmsv_t *bb, xmmsv_t *coll)
 {
-	xmmsv_list_iter_t *it;
-	xmmsv_type_t type;
-	xmmsv_t *entry;
+	unsigned char buf[IDLIST_CHUNK * 8];
+	const int64_t *ids;
+	int size, i, j, n;
+
+	size = xmmsv_coll_idlist_get_ids (coll, &ids);
+
+	if (!xmmsv_bitbuffer_put_bits (bb, 32, XMMSV_TYPE_INT64)) {
+		return false;
+	}
 
-	if (!xmmsv_get_list_iter (v, &it)) {
+	if (!xmmsv_bitbuffer_put_bits (bb, 32, size)) {
 		return false;
 	}
 
+	for (i = 0; i < size; i += n) {
+		n = MIN (size - i, IDLIST_CHUNK);
+		for (j = 0; j < n; j++) {
+			uint64_t id = ids[i + j];
+			int k;
+			for (k = 7; k >= 0; k--) {
+				buf[j * 8 + k] = id & 0xff;
+				id >>= 8;
+			}
+		}
+		if (!xmmsv_bitbuffer_put_data (bb, buf, n * 8)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Lists and dicts are read without iterators, which would register
+ * with (and so modify) the value, so that a value shared between
+ * threads can be serialized by all of them at once. */
+static bool
+_internal_put_on_bb_value_list (xmmsv_t *bb, xmmsv_t *v)
+{
+	xmmsv_type_t type;
+	xmmsv_t *entry;
+	int i;
+
 	if (!xmmsv_list_get_type (v, &type)) {
 		return false;
 	}
@@ -193,18 +236,16 @@ _internal_put_on_bb_value_list (xmmsv_t *bb, xmmsv_t *v)
 	}
 
 	if (type != XMMSV_TYPE_NONE) {
-		while (xmmsv_list_iter_entry (it, &entry)) {
+		for (i = 0; xmmsv_list_get (v, i, &entry); i++) {
 			if (!_internal_put_on_bb_value_of_type (bb, type, entry)) {
 				return false;
 			}
-			xmmsv_list_iter_next (it);
 		}
 	} else {
-		while (xmmsv_list_iter_entry (it, &entry)) {
+		for (i = 0; xmmsv_list_get (v, i, &entry); i++) {
 			if (!xmmsv_bitbuffer_serialize_value (bb, entry)) {
 				return false;
 			}
-			xmmsv_list_iter_next (it);
 		}
 	}
 
@@ -214,11 +255,11 @@ _internal_put_on_bb_value_list (xmmsv_t *bb, xmmsv_t *v)
 static bool
 _internal_put_on_bb_value_dict (xmmsv_t *bb, xmmsv_t *v)
 {
-	xmmsv_dict_iter_t *it;
 	const char *key;
 	xmmsv_t *entry;
+	int pos = 0;
 
-	if (!xmmsv_get_dict_iter (v, &it)) {
+	if (!xmmsv_is_type (v, XMMSV_TYPE_DICT)) {
 		return false;
 	}
 
@@ -227,14 +268,13 @@ _internal_put_on_bb_value_dict (xmmsv_t *bb, xmmsv_t *v)
 		return false;
 	}
 
-	while (xmmsv_dict_iter_pair (it, &key, &entry)) {
+	while (_xmmsv_dict_walk (v, &pos, &key, &entry)) {
 		if (!_internal_put_on_bb_string (bb, key)) {
 			return false;
 		}
 		if (!xmmsv_bitbuffer_serialize_value (bb, entry)) {
 			return false;
 		}
-		xmmsv_dict_iter_next (it);
 	}
 
 	return true;
@@ -388,11 +428,9 @@ _internal_get_from_bb_collection_alloc (xmmsv_t *bb, xmmsv_t **coll)
 	xmmsv_coll_attributes_set (*coll, dict);
 	xmmsv_unref (dict);
 
-	if (!_internal_get_from_bb_value_list_alloc (bb, &list)) {
+	if (!_internal_get_from_bb_idlist (bb, *coll)) {
 		goto err;
 	}
-	xmmsv_coll_idlist_set (*coll, list);
-	xmmsv_unref (list);
 
 	if (!_internal_get_from_bb_value_list_alloc (bb, &list)) {
 		goto err;
@@ -408,6 +446,57 @@ err:
 	return false;
 }
 
+static bool
+_internal_get_from_bb_idlist (xmmsv_t *bb, xmmsv_t *coll)
+{
+	unsigned char buf[IDLIST_CHUNK * 8];
+	xmmsv_t *list;
+	int32_t len, type;
+	int i, n;
+
+	if (!_internal_get_from_bb_int32_positive (bb, &type)) {
+		return false;
+	}
+
+	if (!_internal_get_from_bb_int32_positive (bb, &len)) {
+		return false;
+	}
+
+	/* Unrestricted idlists are valid on the wire, take the slow way */
+	if (type != XMMSV_TYPE_INT64) {
+		bool ret = false;
+
+		if (!xmmsv_bitbuffer_goto (bb, xmmsv_bitbuffer_pos (bb) - 64)) {
+			return false;
+		}
+		if (_internal_get_from_bb_value_list_alloc (bb, &list)) {
+			if (xmmsv_list_restrict_type (list, XMMSV_TYPE_INT64)) {
+				xmmsv_coll_idlist_set (coll, list);
+				ret = true;
+			}
+			xmmsv_unref (list);
+		}
+		return ret;
+	}
+
+	while (len > 0) {
+		n = MIN (len, IDLIST_CHUNK);
+		if (!_internal_get_from_bb_data (bb, buf, n * 8)) {
+			return false;
+		}
+		for (i = 0; i < n; i++) {
+			uint64_t id = 0;
+			int k;
+			for (k = 0; k < 8; k++) {
+				id = (id << 8) | buf[i * 8 + k];
+			}
+			xmmsv_coll_idlist_append (coll, (int64_t) id);
+		}
+		len -= n;
+	}
+
+	return true;
+}
 
 static bool
 _internal_get_from_bb_value_dict_alloc (xmmsv_t *bb, xmmsv_t **val)
@@ -16,6 +16,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 
 #include <xmmscpriv/xmmsv.h>
 #include <xmmscpriv/xmmsc_util.h>
@@ -72,6 +73,48 @@ xmmsv_new_bitbuffer (void)
 	return val;
 }
 
+/* Positions and lengths are kept in bits in an int, so a bitbuffer can
+ * hold at most this many whole bytes worth of bits.
+ */
+#define XMMSV_BITBUFFER_MAX_BITS (INT_MAX & ~7)
+
+/* Make room for writing bits at the current position, growing the
+ * buffer geometrically so that appending is amortized constant time.
+ */
+static int
+_xmmsv_bitbuffer_reserve (xmmsv_t *v, size_t bits)
+{
+	unsigned char *buf;
+	size_t ol, nl, need;
+
+	x_api_error_if (bits > (size_t) (XMMSV_BITBUFFER_MAX_BITS - v->value.bit.pos),
+	                "bitbuffer too large", 0);
+
+	need = v->value.bit.pos + bits;
+	ol = v->value.bit.alloclen;
+	if (need <= ol)
+		return 1;
+
+	nl = ol * 2;
+	nl = nl < 128 ? 128 : nl;
+	while (nl < need)
+		nl *= 2;
+	nl = (nl + 7) & ~7;
+	if (nl > XMMSV_BITBUFFER_MAX_BITS)
+		nl = XMMSV_BITBUFFER_MAX_BITS;
+
+	buf = realloc (v->value.bit.buf, nl / 8);
+	if (!buf) {
+		x_oom ();
+		return 0;
+	}
+
+	memset (buf + ol / 8, 0, (nl - ol) / 8);
+	v->value.bit.buf = buf;
+	v->value.bit.alloclen = nl;
+	return 1;
+}
+
 int
 xmmsv_bitbuffer_get_bits (xmmsv_t *v, int bits, int64_t *res)
 {
@@ -80,6 +123,24 @@ xmmsv_bitbuffer_get_bits (xmmsv_t *v, int bits, int64_t *res)
 
 	x_api_error_if (bits < 1, "less than one bit requested", 0);
 
+	/* whole bytes on a byte boundary, the common case when parsing */
+	if (!(v->value.bit.pos % 8) && !(bits % 8) && bits <= 64) {
+		const unsigned char *p;
+		uint64_t u = 0;
+
+		if (v->value.bit.pos + bits > v->value.bit.len)
+			return 0;
+
+		p = v->value.bit.buf + v->value.bit.pos / 8;
+		for (i = 0; i < bits / 8; i++) {
+			u = (u << 8) | p[i];
+		}
+
+		v->value.bit.pos += bits;
+		*res = (int64_t) u;
+		return 1;
+	}
+
 	if (bits == 1) {
 		int pos = v->value.bit.pos;
 
@@ -105,6 +166,16 @@ xmmsv_bitbuffer_get_bits (xmmsv_t *v, int bits, int64_t *res)
 int
 xmmsv_bitbuffer_get_data (xmmsv_t *v, unsigned char *b, int len)
 {
+	if (!(v->value.bit.pos % 8)) {
+		/* compare in bytes, len * 8 would overflow for a large len */
+		if (len < 0 || len > (v->value.bit.len - v->value.bit.pos) / 8)
+			return 0;
+
+		memcpy (b, v->value.bit.buf + v->value.bit.pos / 8, len);
+		v->value.bit.pos += len * 8;
+		return 1;
+	}
+
 	while (len) {
 		int64_t t;
 		if (!xmmsv_bitbuffer_get_bits (v, 8, &t))
@@ -126,19 +197,33 @@ xmmsv_bitbuffer_put_bits (xmmsv_t *v, int bits, int64_t d)
 	x_api_error_if (v->value.bit.ro, "write to readonly bitbuffer", 0);
 	x_api_error_if (bits < 1, "less than one bit requested", 0);
 
+	/* whole bytes on a byte boundary, stored big endian as the bit
+	 * by bit path below would */
+	if (!(v->value.bit.pos % 8) && !(bits % 8) && bits <= 64) {
+		unsigned char *p;
+		uint64_t u = (uint64_t) d;
+
+		if (!_xmmsv_bitbuffer_reserve (v, bits))
+			return 0;
+
+		p = v->value.bit.buf + v->value.bit.pos / 8;
+		for (i = bits / 8 - 1; i >= 0; i--) {
+			p[i] = u & 0xff;
+			u >>= 8;
+		}
+
+		v->value.bit.pos += bits;
+		if (v->value.bit.pos > v->value.bit.len)
+			v->value.bit.len = v->value.bit.pos;
+		return 1;
+	}
+
 	if (bits == 1) {
 		pos = v->value.bit.pos;
 
-		if (pos >= v->value.bit.alloclen) {
-			int ol, nl;
-			nl = v->value.bit.alloclen * 2;
-			ol = v->value.bit.alloclen;
-			nl = nl < 128 ? 128 : nl;
-			nl = (nl + 7) & ~7;
-			v->value.bit.buf = realloc (v->value.bit.buf, nl / 8);
-			memset (v->value.bit.buf + ol / 8, 0, (nl - ol) / 8);
-			v->value.bit.alloclen = nl;
-		}
+		if (!_xmmsv_bitbuffer_reserve (v, 1))
+			return 0;
+
 		t = v->value.bit.buf[pos / 8];
 
 		t = (t & (~(1<<(7-(pos % 8))))) | (d << (7-(pos % 8)));
@@ -174,6 +259,23 @@ xmmsv_bitbuffer_put_bits_at (xmmsv_t *v, int bits, int64_t d, int offset)
 int
 xmmsv_bitbuffer_put_data (xmmsv_t *v, const unsigned char *b, int len)
 {
+	x_api_error_if (v->value.bit.ro, "write to readonly bitbuffer", 0);
+
+	if (!(v->value.bit.pos % 8)) {
+		x_api_error_if (len < 0, "negative length", 0);
+
+		x_api_error_if (len > XMMSV_BITBUFFER_MAX_BITS / 8, "bitbuffer too large", 0);
+
+		if (!_xmmsv_bitbuffer_reserve (v, (size_t) len * 8))
+			return 0;
+
+		memcpy (v->value.bit.buf + v->value.bit.pos / 8, b, len);
+		v->value.bit.pos += len * 8;
+		if (v->value.bit.pos > v->value.bit.len)
+			v->value.bit.len = v->value.bit.pos;
+		return 1;
+	}
+
 	while (len) {
 		int t;
 		t = *b;
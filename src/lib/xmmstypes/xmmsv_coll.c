@@ -30,10 +30,24 @@ struct xmmsv_coll_internal_St {
 	xmmsv_coll_type_t type;
 	xmmsv_t *operands;
 	xmmsv_t *attributes;
+
+	/* the idlist, packed */
+	int64_t *ids;
+	int ids_size;
+	int ids_allocated;
+
+	/* list of the same ids handed out by xmmsv_coll_idlist_get, NULL
+	 * until asked for. From then on every change is applied to both,
+	 * and changes made to the list directly are read back into the
+	 * packed ids when its generation moves. */
 	xmmsv_t *idlist;
+	unsigned int idlist_generation;
 };
 
 static xmmsv_coll_internal_t *_xmmsv_coll_new (xmmsv_coll_type_t type);
+static int _xmmsv_coll_idlist_resize (xmmsv_coll_internal_t *coll, int newsize);
+static void _xmmsv_coll_idlist_sync (xmmsv_coll_internal_t *coll);
+static void _xmmsv_coll_idlist_synced (xmmsv_coll_internal_t *coll);
 
 
 /**
@@ -128,9 +142,6 @@ _xmmsv_coll_new (xmmsv_coll_type_t type)
 
 	coll->type = type;
 
-	coll->idlist = xmmsv_new_list ();
-	xmmsv_list_restrict_type (coll->idlist, XMMSV_TYPE_INT64);
-
 	coll->operands = xmmsv_new_list ();
 	xmmsv_list_restrict_type (coll->operands, XMMSV_TYPE_COLL);
 
@@ -154,11 +165,118 @@ _xmmsv_coll_free (xmmsv_coll_internal_t *coll)
 	/* Unref all the operands and attributes */
 	xmmsv_unref (coll->operands);
 	xmmsv_unref (coll->attributes);
-	xmmsv_unref (coll->idlist);
+	if (coll->idlist) {
+		xmmsv_unref (coll->idlist);
+	}
 
+	free (coll->ids);
 	free (coll);
 }
 
+/* Same rules as for list positions, negative ones count from the end. */
+static int
+_xmmsv_coll_idlist_position_normalize (int *pos, int size, int allow_append)
+{
+	if (*pos < 0) {
+		if (-*pos > size)
+			return 0;
+		*pos = size + *pos;
+	}
+
+	if (*pos > size)
+		return 0;
+
+	if (!allow_append && *pos == size)
+		return 0;
+
+	return 1;
+}
+
+static int
+_xmmsv_coll_idlist_resize (xmmsv_coll_internal_t *coll, int newsize)
+{
+	int64_t *newmem;
+
+	newmem = realloc (coll->ids, newsize * sizeof (int64_t));
+	if (newsize != 0 && newmem == NULL) {
+		x_oom ();
+		return 0;
+	}
+
+	coll->ids = newmem;
+	coll->ids_allocated = newsize;
+
+	return 1;
+}
+
+/* Pick up changes made through the list from xmmsv_coll_idlist_get. */
+static void
+_xmmsv_coll_idlist_sync (xmmsv_coll_internal_t *coll)
+{
+	int64_t id;
+	int i, size;
+
+	if (!coll->idlist ||
+	    coll->idlist_generation == _xmmsv_list_generation (coll->idlist)) {
+		return;
+	}
+
+	size = xmmsv_list_get_size (coll->idlist);
+	if (size > coll->ids_allocated && !_xmmsv_coll_idlist_resize (coll, size)) {
+		return;
+	}
+
+	for (i = 0; xmmsv_list_get_int64 (coll->idlist, i, &id); i++) {
+		coll->ids[i] = id;
+	}
+	coll->ids_size = size;
+
+	_xmmsv_coll_idlist_synced (coll);
+}
+
+/* Note that the list holds the same ids as the packed array again. */
+static void
+_xmmsv_coll_idlist_synced (xmmsv_coll_internal_t *coll)
+{
+	if (coll->idlist) {
+		coll->idlist_generation = _xmmsv_list_generation (coll->idlist);
+	}
+}
+
+/**
+ * Replace the ids of the collection with a copy of the given ones.
+ *
+ * @param coll the collection to modify.
+ * @param ids the new ids.
+ * @param size the number of ids.
+ * @return 1 upon success otherwise 0
+ */
+int
+_xmmsv_coll_idlist_set_ids (xmmsv_t *coll, const int64_t *ids, int size)
+{
+	xmmsv_coll_internal_t *c = coll->value.coll;
+	int i;
+
+	if (size > c->ids_allocated && !_xmmsv_coll_idlist_resize (c, size)) {
+		return 0;
+	}
+
+	if (size > 0) {
+		memcpy (c->ids, ids, size * sizeof (int64_t));
+	}
+	c->ids_size = size;
+
+	if (c->idlist) {
+		xmmsv_list_clear (c->idlist);
+		for (i = 0; i < size; i++) {
+			xmmsv_list_append_int (c->idlist, ids[i]);
+		}
+		_xmmsv_coll_idlist_synced (c);
+	}
+
+	return 1;
+}
+
 /**
  * Set the list of ids in the given collection.
  * The list must be 0-terminated.
@@ -172,9 +290,9 @@ xmmsv_coll_set_idlist (xmmsv_t *coll, int ids[])
 {
 	unsigned int i;
 
-	xmmsv_list_clear (coll->value.coll->idlist);
+	xmmsv_coll_idlist_clear (coll);
 	for (i = 0; ids[i]; i++) {
-		xmmsv_list_append_int (coll->value.coll->idlist, ids[i]);
+		xmmsv_coll_idlist_append (coll, ids[i]);
 	}
 }
 
@@ -255,7 +373,11 @@ xmmsv_coll_idlist_append (xmmsv_t *coll, int64_t id)
 {
 	x_return_val_if_fail (coll, 0);
 
-	return xmmsv_list_append_int (coll->value.coll->idlist, id);
+	/* pick up changes made through xmmsv_coll_idlist_get first,
+	 * ids_size may be stale until then */
+	_xmmsv_coll_idlist_sync (coll->value.coll);
+
+	return xmmsv_coll_idlist_insert (coll, coll->value.coll->ids_size, id);
 }
 
 /**
@@ -268,9 +390,37 @@ xmmsv_coll_idlist_append (xmmsv_t *coll, int64_t id)
 int
 xmmsv_coll_idlist_insert (xmmsv_t *coll, int index, int64_t id)
 {
+	xmmsv_coll_internal_t *c;
+
 	x_return_val_if_fail (coll, 0);
 
-	return xmmsv_list_insert_int (coll->value.coll->idlist, index, id);
+	c = coll->value.coll;
+	_xmmsv_coll_idlist_sync (c);
+
+	if (!_xmmsv_coll_idlist_position_normalize (&index, c->ids_size, 1)) {
+		return 0;
+	}
+
+	if (c->ids_size == c->ids_allocated) {
+		int success;
+		success = _xmmsv_coll_idlist_resize (c, c->ids_allocated > 0 ? c->ids_allocated << 1 : 8);
+		x_return_val_if_fail (success, 0);
+	}
+
+	if (c->ids_size > index) {
+		memmove (c->ids + index + 1, c->ids + index,
+		         (c->ids_size - index) * sizeof (int64_t));
+	}
+
+	c->ids[index] = id;
+	c->ids_size++;
+
+	if (c->idlist) {
+		xmmsv_list_insert_int (c->idlist, index, id);
+		_xmmsv_coll_idlist_synced (c);
+	}
+
+	return 1;
 }
 
 /**
@@ -283,9 +433,37 @@ xmmsv_coll_idlist_insert (xmmsv_t *coll, int index, int64_t id)
 int
 xmmsv_coll_idlist_move (xmmsv_t *coll, int index, int newindex)
 {
+	xmmsv_coll_internal_t *c;
+	int64_t id;
+
 	x_return_val_if_fail (coll, 0);
 
-	return xmmsv_list_move (coll->value.coll->idlist, index, newindex);
+	c = coll->value.coll;
+	_xmmsv_coll_idlist_sync (c);
+
+	if (!_xmmsv_coll_idlist_position_normalize (&index, c->ids_size, 0)) {
+		return 0;
+	}
+	if (!_xmmsv_coll_idlist_position_normalize (&newindex, c->ids_size, 0)) {
+		return 0;
+	}
+
+	id = c->ids[index];
+	if (index < newindex) {
+		memmove (c->ids + index, c->ids + index + 1,
+		         (newindex - index) * sizeof (int64_t));
+	} else {
+		memmove (c->ids + newindex + 1, c->ids + newindex,
+		         (index - newindex) * sizeof (int64_t));
+	}
+	c->ids[newindex] = id;
+
+	if (c->idlist) {
+		xmmsv_list_move (c->idlist, index, newindex);
+		_xmmsv_coll_idlist_synced (c);
+	}
+
+	return 1;
 }
 
 /**
@@ -297,9 +475,34 @@ xmmsv_coll_idlist_move (xmmsv_t *coll, int index, int newindex)
 int
 xmmsv_coll_idlist_remove (xmmsv_t *coll, int index)
 {
+	xmmsv_coll_internal_t *c;
+
 	x_return_val_if_fail (coll, 0);
 
-	return xmmsv_list_remove (coll->value.coll->idlist, index);
+	c = coll->value.coll;
+	_xmmsv_coll_idlist_sync (c);
+
+	if (!_xmmsv_coll_idlist_position_normalize (&index, c->ids_size, 0)) {
+		return 0;
+	}
+
+	c->ids_size--;
+	if (index < c->ids_size) {
+		memmove (c->ids + index, c->ids + index + 1,
+		         (c->ids_size - index) * sizeof (int64_t));
+	}
+
+	/* Reduce memory usage by two if possible */
+	if (c->ids_size <= c->ids_allocated >> 2) {
+		_xmmsv_coll_idlist_resize (c, c->ids_allocated >> 1);
+	}
+
+	if (c->idlist) {
+		xmmsv_list_remove (c->idlist, index);
+		_xmmsv_coll_idlist_synced (c);
+	}
+
+	return 1;
 }
 
 /**
@@ -310,9 +513,23 @@ xmmsv_coll_idlist_remove (xmmsv_t *coll, int index)
 int
 xmmsv_coll_idlist_clear (xmmsv_t *coll)
 {
+	xmmsv_coll_internal_t *c;
+
 	x_return_val_if_fail (coll, 0);
 
-	return xmmsv_list_clear (coll->value.coll->idlist);
+	c = coll->value.coll;
+
+	free (c->ids);
+	c->ids = NULL;
+	c->ids_size = 0;
+	c->ids_allocated = 0;
+
+	if (c->idlist) {
+		xmmsv_list_clear (c->idlist);
+		_xmmsv_coll_idlist_synced (c);
+	}
+
+	return 1;
 }
 
 /**
@@ -327,7 +544,7 @@ xmmsv_coll_idlist_get_index_int32 (xmmsv_t *coll, int index, int32_t *val)
 {
 	int64_t raw_val;
 	x_return_val_if_fail (coll, 0);
-	if (xmmsv_list_get_int (coll->value.coll->idlist, index, &raw_val)) {
+	if (xmmsv_coll_idlist_get_index_int64 (coll, index, &raw_val)) {
 		*val = INT64_TO_INT32 (raw_val);
 		return true;
 	}
@@ -345,7 +562,16 @@ int
 xmmsv_coll_idlist_get_index_int64 (xmmsv_t *coll, int index, int64_t *val)
 {
 	x_return_val_if_fail (coll, 0);
-	return xmmsv_list_get_int (coll->value.coll->idlist, index, val);
+
+	_xmmsv_coll_idlist_sync (coll->value.coll);
+
+	if (!_xmmsv_coll_idlist_position_normalize (&index, coll->value.coll->ids_size, 0)) {
+		return 0;
+	}
+
+	*val = coll->value.coll->ids[index];
+
+	return 1;
 }
 
 /**
@@ -358,9 +584,25 @@ xmmsv_coll_idlist_get_index_int64 (xmmsv_t *coll, int index, int64_t *val)
 int
 xmmsv_coll_idlist_set_index (xmmsv_t *coll, int index, int64_t val)
 {
+	xmmsv_coll_internal_t *c;
+
 	x_return_val_if_fail (coll, 0);
 
-	return xmmsv_list_set_int (coll->value.coll->idlist, index, val);
+	c = coll->value.coll;
+	_xmmsv_coll_idlist_sync (c);
+
+	if (!_xmmsv_coll_idlist_position_normalize (&index, c->ids_size, 0)) {
+		return 0;
+	}
+
+	c->ids[index] = val;
+
+	if (c->idlist) {
+		xmmsv_list_set_int (c->idlist, index, val);
+		_xmmsv_coll_idlist_synced (c);
+	}
+
+	return 1;
 }
 
 /**
@@ -373,7 +615,31 @@ xmmsv_coll_idlist_get_size (xmmsv_t *coll)
 {
 	x_return_val_if_fail (coll, 0);
 
-	return xmmsv_list_get_size (coll->value.coll->idlist);
+	_xmmsv_coll_idlist_sync (coll->value.coll);
+
+	return coll->value.coll->ids_size;
+}
+
+/**
+ * Get the ids of the collection as a packed array, without going
+ * through an #xmmsv_t per id.
+ *
+ * @param coll  The collection to consider.
+ * @param ids   Pointer set to the ids. They are owned by the collection
+ *              and only valid until its idlist is next changed.
+ * @return  The number of ids.
+ */
+int
+xmmsv_coll_idlist_get_ids (xmmsv_t *coll, const int64_t **ids)
+{
+	x_return_val_if_fail (coll, 0);
+	x_return_val_if_fail (ids, 0);
+
+	_xmmsv_coll_idlist_sync (coll->value.coll);
+
+	*ids = coll->value.coll->ids;
+
+	return coll->value.coll->ids_size;
 }
 
 /**
@@ -409,22 +675,42 @@ xmmsv_coll_get_type (xmmsv_t *coll)
  * This function does not increase the refcount of the list, the reference is
  * still owned by the collection.
  *
+ * The list is created on the first call and kept up to date from then
+ * on, changes made to it are changes to the idlist. The ids are also
+ * kept packed, see #xmmsv_coll_idlist_get_ids for cheaper bulk access.
+ *
  * Note that this must not be confused with the content of the collection,
  * which must be queried using xmmsc_coll_query_ids!
  *
  * @param coll  The collection to consider.
- * @return The 0-terminated list of ids.
+ * @return The list of ids.
  */
 xmmsv_t *
 xmmsv_coll_idlist_get (xmmsv_t *coll)
 {
+	xmmsv_coll_internal_t *c;
+	int i;
+
 	x_return_null_if_fail (coll);
 
-	return coll->value.coll->idlist;
+	c = coll->value.coll;
+
+	if (!c->idlist) {
+		c->idlist = xmmsv_new_list ();
+		xmmsv_list_restrict_type (c->idlist, XMMSV_TYPE_INT64);
+		for (i = 0; i < c->ids_size; i++) {
+			xmmsv_list_append_int (c->idlist, c->ids[i]);
+		}
+		_xmmsv_coll_idlist_synced (c);
+	}
+
+	return c->idlist;
 }
 
 /**
  * Replace the idlist in the given collection.
+ * The ids are copied, later changes to the list have no effect on the
+ * collection.
  *
  * @param coll The collection in which to set the idlist.
  * @param operands The new idlist.
@@ -432,15 +718,24 @@ xmmsv_coll_idlist_get (xmmsv_t *coll)
 void
 xmmsv_coll_idlist_set (xmmsv_t *coll, xmmsv_t *idlist)
 {
-	xmmsv_t *old;
+	int64_t id;
+	int i;
 
 	x_return_if_fail (coll);
 	x_return_if_fail (idlist);
 	x_return_if_fail (xmmsv_list_restrict_type (idlist, XMMSV_TYPE_INT64));
 
-	old = coll->value.coll->idlist;
-	coll->value.coll->idlist = xmmsv_ref (idlist);
-	xmmsv_unref (old);
+	/* already the list of this very collection */
+	if (idlist == coll->value.coll->idlist) {
+		return;
+	}
+
+	xmmsv_coll_idlist_clear (coll);
+	_xmmsv_coll_idlist_resize (coll->value.coll, xmmsv_list_get_size (idlist));
+
+	for (i = 0; xmmsv_list_get_int (idlist, i, &id); i++) {
+		xmmsv_coll_idlist_append (coll, id);
+	}
 }
 
 xmmsv_t *
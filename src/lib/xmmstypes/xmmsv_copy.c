@@ -132,7 +132,9 @@ duplicate_list_value (xmmsv_t *val)
 static xmmsv_t *
 duplicate_coll_value (xmmsv_t *val)
 {
-	xmmsv_t *dup_val, *attributes, *operands, *idlist, *copy;
+	xmmsv_t *dup_val, *attributes, *operands, *copy;
+	const int64_t *ids;
+	int size;
 
 	dup_val = xmmsv_new_coll (xmmsv_coll_get_type (val));
 
@@ -146,10 +148,8 @@ duplicate_coll_value (xmmsv_t *val)
 	xmmsv_coll_operands_set (dup_val, copy);
 	xmmsv_unref (copy);
 
-	idlist = xmmsv_coll_idlist_get (val);
-	copy = xmmsv_copy (idlist);
-	xmmsv_coll_idlist_set (dup_val, copy);
-	xmmsv_unref (copy);
+	size = xmmsv_coll_idlist_get_ids (val, &ids);
+	_xmmsv_coll_idlist_set_ids (dup_val, ids, size);
 
 	return dup_val;
 }
@@ -524,6 +524,42 @@ xmmsv_dict_foreach (xmmsv_t *dictv, xmmsv_dict_foreach_func func,
 	return 1;
 }
 
+/**
+ * Step to the next pair of a dict without an iterator.
+ *
+ * Iterators register themselves with the dict, this does not touch it,
+ * so a dict that is no longer modified can be walked from several
+ * threads at once.
+ *
+ * @param dictv The #xmmsv_t containing the dict.
+ * @param pos Where to continue, 0 for the first pair. Moved past the
+ *            pair returned.
+ * @param key Set to the key of the pair.
+ * @param val Set to the value of the pair.
+ * @return 1 if there was a pair, 0 at the end of the dict.
+ */
+int
+_xmmsv_dict_walk (xmmsv_t *dictv, int *pos, const char **key, xmmsv_t **val)
+{
+	xmmsv_dict_internal_t *d;
+
+	x_return_val_if_fail (dictv, 0);
+	x_return_val_if_fail (xmmsv_is_type (dictv, XMMSV_TYPE_DICT), 0);
+
+	d = dictv->value.dict;
+
+	for (; *pos < (1 << d->size); (*pos)++) {
+		if (d->data[*pos].str != NULL && d->data[*pos].str != DELETED_STR) {
+			*key = d->data[*pos].str;
+			*val = d->data[*pos].value;
+			(*pos)++;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
 /**
  * Return the size of the dict.
  *
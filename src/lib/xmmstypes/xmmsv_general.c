@@ -230,6 +230,9 @@ xmmsv_new_bin (const unsigned char *data, unsigned int len)
 /**
  * References the #xmmsv_t
  *
+ * The count is updated atomically, so a value that is no longer
+ * modified may be referenced and released from several threads.
+ *
  * @param val the value to reference.
  * @return val
  */
@@ -237,7 +240,7 @@ xmmsv_t *
 xmmsv_ref (xmmsv_t *val)
 {
 	x_return_val_if_fail (val, NULL);
-	val->ref++;
+	x_atomic_inc (&val->ref);
 
 	return val;
 }
@@ -254,8 +257,7 @@ xmmsv_unref (xmmsv_t *val)
 	x_return_if_fail (val);
 	x_api_error_if (val->ref < 1, "with a freed value",);
 
-	val->ref--;
-	if (val->ref == 0) {
+	if (x_atomic_dec (&val->ref) == 0) {
 		_xmmsv_free (val);
 	}
 }
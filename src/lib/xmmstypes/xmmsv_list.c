@@ -35,6 +35,7 @@ struct xmmsv_list_internal_St {
 	bool restricted;
 	xmmsv_type_t restricttype;
 	x_list_t *iterators;
+	unsigned int generation; /* bumped on every change */
 };
 
 static void _xmmsv_list_iter_free (xmmsv_list_iter_t *it);
@@ -149,6 +150,7 @@ _xmmsv_list_insert (xmmsv_list_internal_t *l, int pos, xmmsv_t *val)
 
 	l->list[pos] = xmmsv_ref (val);
 	l->size++;
+	l->generation++;
 
 	/* update iterators pos */
 	for (n = l->iterators; n; n = n->next) {
@@ -182,6 +184,7 @@ _xmmsv_list_remove (xmmsv_list_internal_t *l, int pos)
 	xmmsv_unref (l->list[pos]);
 
 	l->size--;
+	l->generation++;
 
 	/* fill the gap */
 	if (pos < l->size) {
@@ -223,6 +226,7 @@ _xmmsv_list_move (xmmsv_list_internal_t *l, int old_pos, int new_pos)
 	}
 
 	v = l->list[old_pos];
+	l->generation++;
 	if (old_pos < new_pos) {
 		memmove (l->list + old_pos, l->list + old_pos + 1,
 		         (new_pos - old_pos) * sizeof (xmmsv_t *));
@@ -278,6 +282,7 @@ _xmmsv_list_clear (xmmsv_list_internal_t *l)
 
 	l->size = 0;
 	l->allocated = 0;
+	l->generation++;
 
 	/* reset iterator pos */
 	for (n = l->iterators; n; n = n->next) {
@@ -291,6 +296,20 @@ _xmmsv_list_sort (xmmsv_list_internal_t *l, xmmsv_list_compare_func_t comparator
 {
 	qsort (l->list, l->size, sizeof (xmmsv_t *),
 	       (int (*)(const void *, const void *)) comparator);
+	l->generation++;
+}
+
+/**
+ * Get a counter that changes whenever the content of the list does,
+ * so that derived data can tell whether it's stale.
+ *
+ * @param listv A #xmmsv_t containing a list.
+ * @return the current generation of the list.
+ */
+unsigned int
+_xmmsv_list_generation (xmmsv_t *listv)
+{
+	return listv->value.list->generation;
 }
 
 /**
@@ -372,6 +391,7 @@ xmmsv_list_set (xmmsv_t *listv, int pos, xmmsv_t *val)
 
 	old_val = l->list[pos];
 	l->list[pos] = xmmsv_ref (val);
+	l->generation++;
 	xmmsv_unref (old_val);
 
 	return 1;
@@ -904,15 +924,14 @@ xmmsv_list_iter_remove (xmmsv_list_iter_t *it)
 static int
 _xmmsv_list_flatten (xmmsv_t *list, xmmsv_t *result, int depth)
 {
-	xmmsv_list_iter_t *it;
 	xmmsv_t *val;
 	int ret = 1;
+	int i;
 
 	x_return_val_if_fail (xmmsv_is_type (list, XMMSV_TYPE_LIST), 0);
 
-	for (xmmsv_get_list_iter (list, &it);
-	     xmmsv_list_iter_entry (it, &val) && ret;
-	     xmmsv_list_iter_next (it)) {
+	/* no iterator, so the list itself is left untouched */
+	for (i = 0; ret && xmmsv_list_get (list, i, &val); i++) {
 		if (depth == 0) {
 			xmmsv_list_append (result, val);
 		} else {
@@ -118,6 +118,9 @@ xmms_asf_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 
 	xmms_xform_plugin_methods_set (xform_plugin, &methods);
 
+	/* tags and duration are all known after init */
+	xmms_xform_plugin_set_metadata_only (xform_plugin);
+
 	xmms_xform_plugin_metadata_mapper_init (xform_plugin,
 	                                        basic_mappings,
 	                                        G_N_ELEMENTS (basic_mappings),
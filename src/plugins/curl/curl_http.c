@@ -43,8 +43,35 @@ typedef struct {
 	struct curl_slist *http_200_aliases;
 	struct curl_slist *http_req_headers;
 
+	/* Once the first data has arrived the transfer is driven by the
+	 * fetch thread, which fills the buffer ahead of the reads. The
+	 * fields below are protected by mutex, the curl handles belong to
+	 * whoever drives the transfer.
+	 */
+	GThread *thread;
+	GMutex mutex;
+	GCond cond;
+	gboolean prefetching;
+	gboolean running;
+
+	/* circular; pos is the stream offset of the byte at bufferpos.
+	 * The behind bytes before bufferpos have been read but are kept
+	 * until the writer needs the room, for short seeks backwards. */
 	gchar *buffer;
-	guint bufferpos, bufferlen;
+	guint buffersize;
+	guint bufferpos, bufferlen, behind;
+	gint64 pos;
+
+	/* how much to wait for before reading again after running dry */
+	guint prebuffer;
+	gboolean refill;
+
+	/* content length, and whether the server takes range requests */
+	gint64 size;
+	gboolean seekable;
+	/* offset the fetch thread should restart the transfer at, or -1 */
+	gint64 seek_to;
+	gboolean aborted;
 
 	gint curl_code;
 
@@ -53,6 +80,11 @@ typedef struct {
 	xmms_error_t status;
 
 	gboolean broken_version;
+
+	/* stats */
+	guint stalls;
+	guint64 stall_usec;
+	guint lowest_fill;
 } xmms_curl_data_t;
 
 typedef void (*handler_func_t) (xmms_xform_t *xform, gchar *header);
@@ -61,6 +93,7 @@ static void header_handler_contentlength (xmms_xform_t *xform, gchar *header);
 static void header_handler_icy_metaint (xmms_xform_t *xform, gchar *header);
 static void header_handler_icy_name (xmms_xform_t *xform, gchar *header);
 static void header_handler_icy_genre (xmms_xform_t *xform, gchar *header);
+static void header_handler_accept_ranges (xmms_xform_t *xform, gchar *header);
 static handler_func_t header_handler_find (gchar *header);
 
 typedef struct {
@@ -73,6 +106,7 @@ handler_t handlers[] = {
 	{ "icy-metaint", header_handler_icy_metaint },
 	{ "icy-name", header_handler_icy_name },
 	{ "icy-genre", header_handler_icy_genre },
+	{ "accept-ranges", header_handler_accept_ranges },
 /*	{ "\r\n", header_handler_last }, */
 	{ NULL, NULL }
 };
@@ -86,7 +120,9 @@ static gboolean xmms_curl_init (xmms_xform_t *xform);
 static void xmms_curl_destroy (xmms_xform_t *xform);
 static gint fill_buffer (xmms_xform_t *xform, xmms_curl_data_t *data, xmms_error_t *error);
 static gint xmms_curl_read (xmms_xform_t *xform, void *buffer, gint len, xmms_error_t *error);
-/* static gint64 xmms_curl_seek (xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whence, xmms_error_t *error); */
+static gint64 xmms_curl_seek (xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whence, xmms_error_t *error);
+static gpointer xmms_curl_fetch (gpointer arg);
+static void xmms_curl_wait_data (xmms_curl_data_t *data, guint len);
 static size_t xmms_curl_callback_write (void *ptr, size_t size, size_t nmemb, void *stream);
 static size_t xmms_curl_callback_header (void *ptr, size_t size, size_t nmemb, void *stream);
 
@@ -110,9 +146,7 @@ xmms_curl_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 	methods.init = xmms_curl_init;
 	methods.destroy = xmms_curl_destroy;
 	methods.read = xmms_curl_read;
-	/*
 	methods.seek = xmms_curl_seek;
-	*/
 
 	xmms_xform_plugin_methods_set (xform_plugin, &methods);
 
@@ -141,6 +175,12 @@ xmms_curl_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 	                                            "user", NULL, NULL);
 	xmms_xform_plugin_config_property_register (xform_plugin, "proxypass",
 	                                            "password", NULL, NULL);
+	/* in KiB, how far to read ahead of the decoder, and how much to
+	 * have before starting and after running out of data */
+	xmms_xform_plugin_config_property_register (xform_plugin, "buffersize",
+	                                            "1024", NULL, NULL);
+	xmms_xform_plugin_config_property_register (xform_plugin, "prebuffer",
+	                                            "32", NULL, NULL);
 
 	xmms_xform_plugin_indata_add (xform_plugin,
 	                              XMMS_STREAM_TYPE_MIMETYPE,
@@ -170,6 +210,7 @@ xmms_curl_init (xmms_xform_t *xform)
 	xmms_config_property_t *val;
 	xmms_error_t error;
 	gint metaint, verbose, connecttimeout, readtimeout, useproxy, authproxy;
+	gint buffersize, prebuffer;
 	const gchar *proxyaddress, *proxyuser, *proxypass;
 	gchar proxyuserpass[90];
 	const gchar *url;
@@ -209,11 +250,27 @@ xmms_curl_init (xmms_xform_t *xform)
 	val = xmms_xform_config_lookup (xform, "proxypass");
 	proxypass = xmms_config_property_get_string (val);
 
+	val = xmms_xform_config_lookup (xform, "buffersize");
+	buffersize = xmms_config_property_get_int (val);
+
+	val = xmms_xform_config_lookup (xform, "prebuffer");
+	prebuffer = xmms_config_property_get_int (val);
+
 	g_snprintf (proxyuserpass, sizeof (proxyuserpass), "%s:%s", proxyuser,
 	            proxypass);
 
-	data->buffer = g_malloc (CURL_MAX_WRITE_SIZE);
+	/* room for a few writes from curl at least, the first fill is done
+	 * before there is anyone to empty the buffer */
+	data->buffersize = MAX (buffersize * 1024, 4 * CURL_MAX_WRITE_SIZE);
+	data->prebuffer = CLAMP (prebuffer * 1024, 1, data->buffersize / 2);
+	data->lowest_fill = data->buffersize;
+	data->buffer = g_malloc (data->buffersize);
 	data->url = g_strdup (url);
+	data->size = -1;
+	data->seek_to = -1;
+	data->running = TRUE;
+	g_mutex_init (&data->mutex);
+	g_cond_init (&data->cond);
 
 	/* check for broken version of curl here */
 	version = curl_version_info (CURLVERSION_NOW);
@@ -296,6 +353,18 @@ xmms_curl_init (xmms_xform_t *xform)
 		return FALSE;
 	}
 
+	/* seeking is done by restarting the transfer at the new offset */
+	data->seekable = data->seekable && data->size > 0 && !data->meta_offset;
+	XMMS_DBG ("%s is %sseekable", data->url, data->seekable ? "" : "not ");
+
+	data->prefetching = TRUE;
+	data->thread = g_thread_new ("x2 curl fetch", xmms_curl_fetch, xform);
+
+	/* give the buffer a head start on the decoder */
+	g_mutex_lock (&data->mutex);
+	xmms_curl_wait_data (data, data->prebuffer);
+	g_mutex_unlock (&data->mutex);
+
 	if (data->meta_offset > 0) {
 		XMMS_DBG ("icy-metadata detected");
 		xmms_xform_auxdata_set_int (xform, "meta_offset", data->meta_offset);
@@ -374,7 +443,10 @@ fill_buffer (xmms_xform_t *xform, xmms_curl_data_t *data, xmms_error_t *error)
 				if (curlmsg == NULL)
 					break;
 
-				if (curlmsg->msg == CURLMSG_DONE && curlmsg->data.result != CURLE_OK) {
+				if (curlmsg->msg == CURLMSG_DONE && data->aborted &&
+				    curlmsg->data.result == CURLE_WRITE_ERROR) {
+					XMMS_DBG ("Transfer stopped for seeking");
+				} else if (curlmsg->msg == CURLMSG_DONE && curlmsg->data.result != CURLE_OK) {
 					xmms_log_error ("Curl fill_buffer returned error: (%d) %s",
 					                curlmsg->data.result,
 					                curl_easy_strerror (curlmsg->data.result));
@@ -383,22 +455,114 @@ fill_buffer (xmms_xform_t *xform, xmms_curl_data_t *data, xmms_error_t *error)
 				}
 			} while (messages > 0);
 
-			data->done = TRUE;
 			return 0;
 		}
 
-		if (data->bufferlen > 0) {
+		/* the fetch thread checks for seeks and shutdown in between */
+		if (data->prefetching || data->bufferlen > 0) {
 			return 1;
 		}
 	}
 }
 
+/*
+ * Restart the transfer at offset, with the mutex held. Only called
+ * by the fetch thread.
+ */
+static void
+xmms_curl_restart (xmms_curl_data_t *data, gint64 offset)
+{
+	data->pos = offset;
+	data->bufferpos = 0;
+	data->bufferlen = 0;
+	data->behind = 0;
+	data->done = FALSE;
+	data->aborted = FALSE;
+	data->refill = TRUE;
+	xmms_error_reset (&data->status);
+
+	/* servers answer a range starting at the end with an error */
+	if (offset >= data->size) {
+		data->done = TRUE;
+		g_cond_broadcast (&data->cond);
+		return;
+	}
+
+	XMMS_DBG ("Restarting transfer at %" G_GINT64_FORMAT, offset);
+
+	curl_multi_remove_handle (data->curl_multi, data->curl_easy);
+	curl_easy_setopt (data->curl_easy, CURLOPT_RESUME_FROM_LARGE,
+	                  (curl_off_t) offset);
+	curl_multi_add_handle (data->curl_multi, data->curl_easy);
+	data->curl_code = CURLM_CALL_MULTI_PERFORM;
+}
+
+static gpointer
+xmms_curl_fetch (gpointer arg)
+{
+	xmms_xform_t *xform = (xmms_xform_t *) arg;
+	xmms_curl_data_t *data;
+	xmms_error_t error;
+	gint ret;
+
+	data = xmms_xform_private_data_get (xform);
+	g_return_val_if_fail (data, NULL);
+
+	g_mutex_lock (&data->mutex);
+
+	while (data->running) {
+		if (data->seek_to >= 0) {
+			xmms_curl_restart (data, data->seek_to);
+			data->seek_to = -1;
+			continue;
+		}
+
+		if (data->done) {
+			g_cond_wait (&data->cond, &data->mutex);
+			continue;
+		}
+
+		g_mutex_unlock (&data->mutex);
+
+		xmms_error_reset (&error);
+		ret = fill_buffer (xform, data, &error);
+
+		g_mutex_lock (&data->mutex);
+
+		/* a transfer we stopped ourselves isn't the end of the stream */
+		if (ret <= 0 && data->seek_to < 0 && data->running) {
+			if (ret == -1) {
+				data->status = error;
+			}
+			data->done = TRUE;
+			g_cond_broadcast (&data->cond);
+		}
+	}
+
+	g_mutex_unlock (&data->mutex);
+
+	return NULL;
+}
+
+/*
+ * Wait for len bytes in the buffer, or the end of the stream, with the
+ * mutex held.
+ */
+static void
+xmms_curl_wait_data (xmms_curl_data_t *data, guint len)
+{
+	while ((data->seek_to >= 0 || data->bufferlen < len) && !data->done) {
+		g_cond_wait (&data->cond, &data->mutex);
+	}
+}
+
 static gint
 xmms_curl_read (xmms_xform_t *xform, void *buffer, gint len,
                 xmms_error_t *error)
 {
 	xmms_curl_data_t *data;
-	gint ret;
+	gint64 start;
+	guint cnt;
 
 	g_return_val_if_fail (xform, -1);
 	g_return_val_if_fail (buffer, -1);
@@ -407,29 +571,131 @@ xmms_curl_read (xmms_xform_t *xform, void *buffer, gint len,
 	data = xmms_xform_private_data_get (xform);
 	g_return_val_if_fail (data, -1);
 
-	if (data->done)
-		return 0;
+	g_mutex_lock (&data->mutex);
+
+	if (!data->bufferlen && !data->done) {
+		/* ran dry, let the buffer build up again instead of handing
+		 * out every byte as it trickles in. Waiting after a seek
+		 * doesn't count as a stall. */
+		start = g_get_monotonic_time ();
+		xmms_curl_wait_data (data, data->prebuffer);
+
+		if (!data->refill) {
+			start = g_get_monotonic_time () - start;
+			data->stalls++;
+			data->stall_usec += start;
+			XMMS_DBG ("Stalled for %" G_GINT64_FORMAT " ms waiting for %s",
+			          start / 1000, data->url);
+		}
+	}
+	data->refill = FALSE;
 
-	while (TRUE) {
+	if (!data->bufferlen) {
+		gint ret = 0;
 
-		/* if we have data available, just pick it up (even if there's
-		   less bytes available than was requested) */
-		if (data->bufferlen) {
-			len = MIN (len, data->bufferlen);
-			memcpy (buffer, data->buffer, len);
-			data->bufferlen -= len;
-			if (data->bufferlen) {
-				memmove (data->buffer, data->buffer + len, data->bufferlen);
-			}
-			return len;
+		if (xmms_error_iserror (&data->status)) {
+			xmms_error_set (error, XMMS_ERROR_GENERIC,
+			                xmms_error_message_get (&data->status));
+			ret = -1;
 		}
 
-		ret = fill_buffer (xform, data, error);
+		g_mutex_unlock (&data->mutex);
 
-		if (ret == 0 || ret == -1) {
-			return ret;
-		}
+		return ret;
+	}
+
+	/* if we have data available, just pick it up (even if there's
+	   less bytes available than was requested) */
+	len = MIN (len, data->bufferlen);
+	cnt = MIN (len, data->buffersize - data->bufferpos);
+	memcpy (buffer, data->buffer + data->bufferpos, cnt);
+	memcpy ((gchar *) buffer + cnt, data->buffer, len - cnt);
+
+	data->bufferpos = (data->bufferpos + len) % data->buffersize;
+	data->bufferlen -= len;
+	data->behind += len;
+	data->pos += len;
+	if (!data->done) {
+		data->lowest_fill = MIN (data->lowest_fill, data->bufferlen);
+	}
+
+	g_cond_broadcast (&data->cond);
+	g_mutex_unlock (&data->mutex);
+
+	return len;
+}
+
+static gint64
+xmms_curl_seek (xmms_xform_t *xform, gint64 offset,
+                xmms_xform_seek_mode_t whence, xmms_error_t *error)
+{
+	xmms_curl_data_t *data;
+	gint64 target;
+
+	g_return_val_if_fail (xform, -1);
+
+	data = xmms_xform_private_data_get (xform);
+	g_return_val_if_fail (data, -1);
+
+	if (!data->seekable) {
+		xmms_error_set (error, XMMS_ERROR_INVAL, "Couldn't seek");
+		return -1;
 	}
+
+	g_mutex_lock (&data->mutex);
+
+	switch (whence) {
+		case XMMS_XFORM_SEEK_SET:
+			target = offset;
+			break;
+		case XMMS_XFORM_SEEK_CUR:
+			target = data->pos + offset;
+			break;
+		case XMMS_XFORM_SEEK_END:
+			target = data->size + offset;
+			break;
+		default:
+			target = -1;
+			break;
+	}
+
+	if (target < 0 || target > data->size) {
+		g_mutex_unlock (&data->mutex);
+		xmms_error_set (error, XMMS_ERROR_INVAL, "Seek out of range");
+		return -1;
+	}
+
+	if (data->seek_to < 0 && target >= data->pos &&
+	    target - data->pos <= data->bufferlen) {
+		/* already fetched, skip ahead in the buffer */
+		guint skip = target - data->pos;
+
+		data->bufferpos = (data->bufferpos + skip) % data->buffersize;
+		data->bufferlen -= skip;
+		data->behind += skip;
+	} else if (data->seek_to < 0 && target < data->pos &&
+	           data->pos - target <= data->behind) {
+		/* read before but still in the buffer, step back */
+		guint back = data->pos - target;
+
+		data->bufferpos = (data->bufferpos + data->buffersize - back) % data->buffersize;
+		data->bufferlen += back;
+		data->behind -= back;
+	} else {
+		/* the fetch thread starts a range request from here, anything
+		 * it still writes from the old transfer is thrown away */
+		data->seek_to = target;
+		data->bufferpos = 0;
+		data->bufferlen = 0;
+		data->behind = 0;
+		data->done = FALSE;
+	}
+	data->pos = target;
+
+	g_cond_broadcast (&data->cond);
+	g_mutex_unlock (&data->mutex);
+
+	return target;
 }
 
 static void
@@ -442,6 +708,19 @@ xmms_curl_destroy (xmms_xform_t *xform)
 	data = xmms_xform_private_data_get (xform);
 	g_return_if_fail (data);
 
+	if (data->thread) {
+		g_mutex_lock (&data->mutex);
+		data->running = FALSE;
+		g_cond_broadcast (&data->cond);
+		g_mutex_unlock (&data->mutex);
+
+		g_thread_join (data->thread);
+
+		XMMS_DBG ("%s: %u stalls, %" G_GUINT64_FORMAT " ms stalled, "
+		          "lowest fill %u of %u bytes", data->url, data->stalls,
+		          data->stall_usec / 1000, data->lowest_fill, data->buffersize);
+	}
+
 	xmms_curl_free_data (data);
 }
 
@@ -454,7 +733,7 @@ xmms_curl_callback_write (void *ptr, size_t size, size_t nmemb, void *stream)
 {
 	xmms_curl_data_t *data;
 	xmms_xform_t *xform = (xmms_xform_t *) stream;
-	gint len;
+	guint len, written = 0, wr, cnt;
 
 	g_return_val_if_fail (xform, 0);
 
@@ -463,12 +742,38 @@ xmms_curl_callback_write (void *ptr, size_t size, size_t nmemb, void *stream)
 
 	len = size * nmemb;
 
-	g_return_val_if_fail ((data->bufferlen + len) <= CURL_MAX_WRITE_SIZE, 0);
+	g_mutex_lock (&data->mutex);
 
-	memcpy (data->buffer + data->bufferlen, ptr, len);
-	data->bufferlen = data->bufferlen + len;
+	/* wait for the reader to make room; a short write makes curl stop
+	 * the transfer, which is what we want on seek and shutdown */
+	while (written < len && data->running && data->seek_to < 0) {
+		cnt = MIN (len - written, data->buffersize - data->bufferlen);
+		if (!cnt) {
+			if (!data->prefetching) {
+				break;
+			}
+			g_cond_wait (&data->cond, &data->mutex);
+			continue;
+		}
 
-	return len;
+		wr = (data->bufferpos + data->bufferlen) % data->buffersize;
+		cnt = MIN (cnt, data->buffersize - wr);
+		memcpy (data->buffer + wr, (gchar *) ptr + written, cnt);
+		data->bufferlen += cnt;
+		/* the oldest bytes read are overwritten first */
+		data->behind = MIN (data->behind, data->buffersize - data->bufferlen);
+		written += cnt;
+
+		g_cond_broadcast (&data->cond);
+	}
+
+	if (written < len) {
+		data->aborted = TRUE;
+	}
+
+	g_mutex_unlock (&data->mutex);
+
+	return written;
 }
 
 static int
@@ -486,6 +791,7 @@ static size_t
 xmms_curl_callback_header (void *ptr, size_t size, size_t nmemb, void *stream)
 {
 	xmms_xform_t *xform = (xmms_xform_t *) stream;
+	xmms_curl_data_t *data;
 	handler_func_t func;
 	gchar *header;
 
@@ -494,6 +800,13 @@ xmms_curl_callback_header (void *ptr, size_t size, size_t nmemb, void *stream)
 	g_return_val_if_fail (xform, 0);
 	g_return_val_if_fail (ptr, 0);
 
+	/* the headers of range requests after a seek describe the range,
+	 * not the stream */
+	data = xmms_xform_private_data_get (xform);
+	if (data && data->prefetching) {
+		return size * nmemb;
+	}
+
 	header = g_strndup ((gchar*)ptr, size * nmemb);
 
 	func = header_handler_find (header);
@@ -533,13 +846,25 @@ static void
 header_handler_contentlength (xmms_xform_t *xform,
                               gchar *header)
 {
-	int length;
+	xmms_curl_data_t *data;
+	guint64 length;
+	gchar *end;
 	const gchar *metakey;
 
-	length = strtoul (header, NULL, 10);
+	length = g_ascii_strtoull (header, &end, 10);
+	if (end == header || length > G_MAXINT64) {
+		xmms_log_error ("Invalid Content-Length: %s", header);
+		return;
+	}
+
+	data = xmms_xform_private_data_get (xform);
+	data->size = length;
 
-	metakey = XMMS_MEDIALIB_ENTRY_PROPERTY_SIZE,
-	xmms_xform_metadata_set_int (xform, metakey, length);
+	/* the size property is an int, leave it unset for larger streams */
+	if (length <= G_MAXINT) {
+		metakey = XMMS_MEDIALIB_ENTRY_PROPERTY_SIZE;
+		xmms_xform_metadata_set_int (xform, metakey, length);
+	}
 }
 
 static void
@@ -569,6 +894,17 @@ header_handler_icy_genre (xmms_xform_t *xform,
 	xmms_xform_metadata_set_str (xform, metakey, header);
 }
 
+static void
+header_handler_accept_ranges (xmms_xform_t *xform,
+                              gchar *header)
+{
+	xmms_curl_data_t *data;
+
+	data = xmms_xform_private_data_get (xform);
+
+	data->seekable = g_ascii_strcasecmp (header, "bytes") == 0;
+}
+
 static void
 xmms_curl_free_data (xmms_curl_data_t *data)
 {
@@ -582,15 +918,9 @@ xmms_curl_free_data (xmms_curl_data_t *data)
 
 	g_free (data->buffer);
 
+	g_mutex_clear (&data->mutex);
+	g_cond_clear (&data->cond);
+
 	g_free (data->url);
 	g_free (data);
 }
-
-/*
-static gint64
-xmms_curl_seek (xmms_xform_t *xform, gint64 offset,
-                xmms_xform_seek_mode_t whence, xmms_error_t *error) {
-	xmms_error_set (error, XMMS_ERROR_INVAL, "Couldn't seek");
-	return -1;
-}
-*/
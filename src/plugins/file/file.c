@@ -25,6 +25,10 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef HAVE_MMAP
+# include <sys/mman.h>
+#endif
+
 #include "browse/browse.h"
 
 /* not available everywhere. */
@@ -37,8 +41,18 @@
 
 typedef struct {
 	gint fd;
+
+	/** The whole file when it could be mapped, NULL otherwise */
+	guchar *map;
+	gsize size;
+	/** Read position within map */
+	gsize pos;
 } xmms_file_data_t;
 
+/** How far ahead of the read position to ask the kernel to page in
+    after a seek */
+#define XMMS_FILE_READAHEAD (256 * 1024)
+
 /*
  * Function prototypes
  */
@@ -72,6 +86,12 @@ xmms_file_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 
 	xmms_xform_plugin_methods_set (xform_plugin, &methods);
 
+	/* map regular files into memory instead of read (). Off by default:
+	 * a file that shrinks while mapped, or a failing network filesystem,
+	 * raises SIGBUS instead of a read error. */
+	xmms_xform_plugin_config_property_register (xform_plugin, "mmap", "0",
+	                                            NULL, NULL);
+
 	xmms_xform_plugin_indata_add (xform_plugin,
 	                              XMMS_STREAM_TYPE_MIMETYPE,
 	                              "application/x-url",
@@ -85,6 +105,49 @@ xmms_file_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 /*
  * Member functions
  */
+
+static void
+xmms_file_map (xmms_xform_t *xform, xmms_file_data_t *data)
+{
+#ifdef HAVE_MMAP
+	xmms_config_property_t *cv;
+	struct stat st;
+	off_t size;
+	void *map;
+
+	cv = xmms_xform_config_lookup (xform, "mmap");
+	if (!cv || !xmms_config_property_get_int (cv)) {
+		return;
+	}
+
+	/* the size of what we opened, the path may point elsewhere by now */
+	if (fstat (data->fd, &st) == -1 || !S_ISREG (st.st_mode)) {
+		return;
+	}
+	size = st.st_size;
+
+	/* empty files can't be mapped, and files larger than the address
+	 * space are read the old way */
+	if (size <= 0 || (guint64) size > G_MAXSIZE) {
+		return;
+	}
+
+	map = mmap (NULL, size, PROT_READ, MAP_PRIVATE, data->fd, 0);
+	if (map == MAP_FAILED) {
+		XMMS_DBG ("Couldn't map file, falling back to read: %s",
+		          strerror (errno));
+		return;
+	}
+
+#ifdef HAVE_MADVISE
+	madvise (map, size, MADV_SEQUENTIAL);
+#endif
+
+	data->map = map;
+	data->size = size;
+#endif
+}
+
 static gboolean
 xmms_file_init (xmms_xform_t *xform)
 {
@@ -117,10 +180,16 @@ xmms_file_init (xmms_xform_t *xform)
 		return FALSE;
 	}
 
+#ifdef HAVE_POSIX_FADVISE
+	posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
 	data = g_new0 (xmms_file_data_t, 1);
 	data->fd = fd;
 	xmms_xform_private_data_set (xform, data);
 
+	xmms_file_map (xform, data);
+
 	xmms_xform_outdata_type_add (xform,
 	                             XMMS_STREAM_TYPE_MIMETYPE,
 	                             "application/octet-stream",
@@ -145,6 +214,11 @@ xmms_file_destroy (xmms_xform_t *xform)
 	if (!data)
 		return;
 
+#ifdef HAVE_MMAP
+	if (data->map)
+		munmap (data->map, data->size);
+#endif
+
 	if (data->fd != -1)
 		close (data->fd);
 
@@ -164,6 +238,16 @@ xmms_file_read (xmms_xform_t *xform, void *buffer, gint len, xmms_error_t *error
 	data = xmms_xform_private_data_get (xform);
 	g_return_val_if_fail (data, -1);
 
+	if (data->map) {
+		if (data->pos >= data->size) {
+			return 0;
+		}
+		ret = MIN (len, data->size - data->pos);
+		memcpy (buffer, data->map + data->pos, ret);
+		data->pos += ret;
+		return ret;
+	}
+
 	ret = read (data->fd, buffer, len);
 
 	if (ret == -1) {
@@ -197,6 +281,34 @@ xmms_file_seek (xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whenc
 			break;
 	}
 
+	if (data->map) {
+		if (w == SEEK_CUR) {
+			offset += data->pos;
+		} else if (w == SEEK_END) {
+			offset += data->size;
+		}
+
+		if (offset < 0) {
+			xmms_error_set (error, XMMS_ERROR_INVAL, "Couldn't seek");
+			return -1;
+		}
+
+		data->pos = offset;
+
+#ifdef HAVE_MADVISE
+		/* sequential read-ahead starts over from the new position,
+		 * get the kernel going before the first read */
+		if (data->pos < data->size) {
+			gsize page = data->pos & ~((gsize) sysconf (_SC_PAGESIZE) - 1);
+			madvise (data->map + page,
+			         MIN (XMMS_FILE_READAHEAD, data->size - page),
+			         MADV_WILLNEED);
+		}
+#endif
+
+		return offset;
+	}
+
 	res = lseek (data->fd, offset, w);
 	if (res == (off_t)-1) {
 		xmms_error_set (error, XMMS_ERROR_INVAL, "Couldn't seek");
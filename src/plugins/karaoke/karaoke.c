@@ -53,6 +53,8 @@ static void xmms_karaoke_destroy (xmms_xform_t *xform);
 static void xmms_karaoke_config_changed (xmms_object_t *object, xmmsv_t *d, gpointer userdata);
 static gint xmms_karaoke_read (xmms_xform_t *xform, xmms_sample_t *buf, gint len,
                                xmms_error_t *err);
+static void xmms_karaoke_process (xmms_xform_t *xform, gfloat *buf, gint frames);
+static gboolean xmms_karaoke_active (xmms_xform_t *xform);
 static gint64 xmms_karaoke_seek (xmms_xform_t *xform, gint64 offset,
                                  xmms_xform_seek_mode_t whence,
                                  xmms_error_t *err);
@@ -77,6 +79,8 @@ xmms_karaoke_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 	methods.destroy = xmms_karaoke_destroy;
 	methods.read = xmms_karaoke_read;
 	methods.seek = xmms_karaoke_seek;
+	methods.process = xmms_karaoke_process;
+	methods.active = xmms_karaoke_active;
 
 	xmms_xform_plugin_methods_set (xform_plugin, &methods);
 
@@ -264,6 +268,52 @@ xmms_karaoke_read (xmms_xform_t *xform, xmms_sample_t *buffer, gint len,
 	return ret;
 }
 
+static gboolean
+xmms_karaoke_active (xmms_xform_t *xform)
+{
+	xmms_karaoke_data_t *data;
+
+	data = xmms_xform_private_data_get (xform);
+	g_return_val_if_fail (data, FALSE);
+
+	return data->enabled && data->channels >= 2;
+}
+
+/* Same as xmms_karaoke_read, on float samples.  The output is left
+ * unclamped, the effect stage clamps once after the last effect. */
+static void
+xmms_karaoke_process (xmms_xform_t *xform, gfloat *buf, gint frames)
+{
+	xmms_karaoke_data_t *data;
+	gfloat l, r, out, level, mono_level;
+	gdouble y;
+	gint i;
+
+	data = xmms_xform_private_data_get (xform);
+	g_return_if_fail (data);
+
+	if (!data->enabled || data->channels < 2) {
+		return;
+	}
+
+	level = data->level / 32.0;
+	mono_level = data->mono_level / 10.0;
+
+	for (i = 0; i < frames * data->channels; i += data->channels) {
+		l = buf[i];
+		r = buf[i+1];
+
+		y = (data->a*(l+r)*0.5 - data->b*data->y1) - data->c*data->y2;
+		data->y2 = data->y1;
+		data->y1 = y;
+
+		out = CLAMP (y * mono_level, -1.0, 1.0) * level;
+
+		buf[i]   = l - r*level + out;
+		buf[i+1] = r - l*level + out;
+	}
+}
+
 static gint64
 xmms_karaoke_seek (xmms_xform_t *xform, gint64 offset,
                    xmms_xform_seek_mode_t whence, xmms_error_t *err)
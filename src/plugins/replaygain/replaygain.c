@@ -47,6 +47,7 @@ typedef struct xmms_replaygain_data_St {
 	gfloat gain;
 	gboolean has_replaygain;
 	gboolean enabled;
+	gint channels;
 	xmms_replaygain_apply_func_t apply;
 } xmms_replaygain_data_t;
 
@@ -66,6 +67,9 @@ static gboolean xmms_replaygain_init (xmms_xform_t *xform);
 static void xmms_replaygain_destroy (xmms_xform_t *xform);
 static gint xmms_replaygain_read (xmms_xform_t *xform, xmms_sample_t *buf,
                                   gint len, xmms_error_t *error);
+static void xmms_replaygain_process (xmms_xform_t *xform, gfloat *buf,
+                                     gint frames);
+static gboolean xmms_replaygain_active (xmms_xform_t *xform);
 static gint64 xmms_replaygain_seek (xmms_xform_t *xform, gint64 samples,
                                     xmms_xform_seek_mode_t whence,
                                     xmms_error_t *error);
@@ -105,6 +109,8 @@ xmms_replaygain_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 	methods.destroy = xmms_replaygain_destroy;
 	methods.read = xmms_replaygain_read;
 	methods.seek = xmms_replaygain_seek;
+	methods.process = xmms_replaygain_process;
+	methods.active = xmms_replaygain_active;
 
 	xmms_xform_plugin_methods_set (xform_plugin, &methods);
 
@@ -178,6 +184,7 @@ xmms_replaygain_init (xmms_xform_t *xform)
 	compute_gain (xform, data);
 
 	fmt = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_FORMAT);
+	data->channels = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_CHANNELS);
 
 	switch (fmt) {
 		case XMMS_SAMPLE_FORMAT_S8:
@@ -268,6 +275,32 @@ xmms_replaygain_read (xmms_xform_t *xform, xmms_sample_t *buf, gint len,
 	return read;
 }
 
+static void
+xmms_replaygain_process (xmms_xform_t *xform, gfloat *buf, gint frames)
+{
+	xmms_replaygain_data_t *data;
+
+	data = xmms_xform_private_data_get (xform);
+	g_return_if_fail (data);
+
+	if (!data->has_replaygain || !data->enabled) {
+		return;
+	}
+
+	apply_float (buf, frames * data->channels, data->gain);
+}
+
+static gboolean
+xmms_replaygain_active (xmms_xform_t *xform)
+{
+	xmms_replaygain_data_t *data;
+
+	data = xmms_xform_private_data_get (xform);
+	g_return_val_if_fail (data, FALSE);
+
+	return data->has_replaygain && data->enabled;
+}
+
 static gint64
 xmms_replaygain_seek (xmms_xform_t *xform, gint64 samples,
                       xmms_xform_seek_mode_t whence, xmms_error_t *error)
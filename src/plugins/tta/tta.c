@@ -114,6 +114,9 @@ xmms_tta_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 
 	xmms_xform_plugin_methods_set (xform_plugin, &methods);
 
+	/* tags and duration are all known after init */
+	xmms_xform_plugin_set_metadata_only (xform_plugin);
+
 	xmms_xform_plugin_indata_add (xform_plugin,
 	                              XMMS_STREAM_TYPE_MIMETYPE,
 	                              "audio/x-tta",
@@ -30,7 +30,9 @@
 #include <xmmspriv/xmms_xform.h>
 #include <xmmspriv/xmms_streamtype.h>
 #include <xmmspriv/xmms_medialib.h>
+#include <xmmspriv/xmms_ipc.h>
 #include <xmms/xmms_ipc.h>
+#include <xmms/xmms_config.h>
 #include <xmms/xmms_log.h>
 
 
@@ -72,6 +74,36 @@ typedef enum {
 	XMMS_COLLECTION_FIND_STATE_NOMATCH,
 } coll_find_state_t;
 
+/** A query kept open by query_open, handed out page by page */
+typedef struct {
+	gint32 id;
+	/** The client that opened the cursor, the only one that may use it */
+	gint32 client;
+	/** The matching media ids, in order */
+	xmms_medialib_entry_t *ids;
+	gint size;
+	xmmsv_t *fetch;
+	gint position;
+} coll_cursor_t;
+
+/** A cached query result */
+typedef struct {
+	/** Canonical form of the bound collection and fetch specification */
+	gchar *key;
+	xmmsv_t *result;
+	/** Rough number of bytes held by the key and result */
+	gsize size;
+	/** Position in the recently used queue */
+	GList *link;
+} coll_cache_entry_t;
+
+/** Rough size of a value itself, for the query cache accounting */
+#define XMMS_COLLECTION_CACHE_VALUE_OVERHEAD 48
+/** At most this many cursors are kept per client, its oldest is dropped first */
+#define XMMS_COLLECTION_MAX_CURSORS 16
+/** Upper bound of the number of media in one page */
+#define XMMS_COLLECTION_MAX_PAGE 10000
+
 typedef struct add_metadata_from_tree_user_data_St {
 	xmms_medialib_entry_t entry;
 	xmms_medialib_session_t *session;
@@ -117,7 +149,19 @@ static void xmms_collection_client_rename (xmms_coll_dag_t *dag, const gchar *fr
 
 static xmmsv_t * xmms_collection_client_query_infos (xmms_coll_dag_t *dag, xmmsv_t *coll, int limit_start, int limit_len, xmmsv_t *fetch, xmmsv_t *group, xmms_error_t *err);
 static xmmsv_t * xmms_collection_client_query (xmms_coll_dag_t *dag, xmmsv_t *coll, xmmsv_t *fetch, xmms_error_t *err);
+static xmmsv_t *xmms_collection_query (xmms_coll_dag_t *dag, xmmsv_t *coll, xmmsv_t *fetch, gboolean cached, xmms_error_t *err);
 static xmmsv_t *xmms_collection_client_idlist_from_playlist (xmms_coll_dag_t *dag, const gchar *mediainfo, xmms_error_t *err);
+static gint32 xmms_collection_client_query_open (xmms_coll_dag_t *dag, xmmsv_t *coll, xmmsv_t *fetch, gint32 client, xmms_error_t *err);
+static xmmsv_t *xmms_collection_client_query_next (xmms_coll_dag_t *dag, gint32 cursor, gint32 count, gint32 client, xmms_error_t *err);
+static void xmms_collection_client_query_close (xmms_coll_dag_t *dag, gint32 cursor, gint32 client, xmms_error_t *err);
+static void coll_cursor_free (coll_cursor_t *cursor);
+static void xmms_collection_client_disconnected (xmms_object_t *object, xmmsv_t *data, gpointer udata);
+
+static void coll_cache_entry_free (coll_cache_entry_t *entry);
+static gboolean coll_cache_key_append (GString *key, xmmsv_t *value);
+static gsize coll_cache_value_size (xmmsv_t *value);
+static void xmms_collection_cache_invalidate (xmms_object_t *object, xmmsv_t *data, gpointer udata);
+static void xmms_collection_cache_size_changed (xmms_object_t *object, xmmsv_t *data, gpointer udata);
 
 
 #include "collection_ipc.c"
@@ -166,6 +210,27 @@ struct xmms_coll_dag_St {
 	GMutex mutex;
 
 	xmms_medialib_t *medialib;
+
+	/** Protects the cursors */
+	GMutex cursor_mutex;
+	/** Open cursors by id */
+	GHashTable *cursors;
+	/** Ids of the open cursors, oldest first */
+	GQueue *cursor_order;
+	gint32 next_cursor;
+
+	/** Protects the query cache */
+	GMutex cache_mutex;
+	/** Cached query results by key */
+	GHashTable *cache;
+	/** Cached entries, most recently used first */
+	GQueue *cache_order;
+	/** Maximum number of bytes held by the cache, 0 disables it */
+	gsize cache_limit;
+	/** Number of bytes held by the cache */
+	gsize cache_bytes;
+	/** Bumped on every invalidation */
+	guint cache_generation;
 };
 
 /** Initializes a new xmms_coll_dag_t.
@@ -175,15 +240,54 @@ struct xmms_coll_dag_St {
 xmms_coll_dag_t *
 xmms_collection_init (xmms_medialib_t *medialib)
 {
+	xmms_config_property_t *cv;
 	xmms_coll_dag_t *ret;
 	gint i;
 
 	ret = xmms_object_new (xmms_coll_dag_t, xmms_collection_destroy);
 	g_mutex_init (&ret->mutex);
 
+	g_mutex_init (&ret->cursor_mutex);
+	ret->cursors = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+	                                      (GDestroyNotify) coll_cursor_free);
+	ret->cursor_order = g_queue_new ();
+	ret->next_cursor = 1;
+
+	g_mutex_init (&ret->cache_mutex);
+	ret->cache = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+	                                    (GDestroyNotify) coll_cache_entry_free);
+	ret->cache_order = g_queue_new ();
+
+	cv = xmms_config_property_register ("collection.query_cache_bytes", "4194304",
+	                                    xmms_collection_cache_size_changed,
+	                                    ret);
+	ret->cache_limit = MAX (0, xmms_config_property_get_int (cv));
+
 	xmms_object_ref (medialib);
 	ret->medialib = medialib;
 
+	/* anything that may change a query result drops the cache */
+	xmms_object_connect (XMMS_OBJECT (medialib),
+	                     XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_ADDED,
+	                     xmms_collection_cache_invalidate, ret);
+	xmms_object_connect (XMMS_OBJECT (medialib),
+	                     XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_CHANGED,
+	                     xmms_collection_cache_invalidate, ret);
+	xmms_object_connect (XMMS_OBJECT (medialib),
+	                     XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_REMOVED,
+	                     xmms_collection_cache_invalidate, ret);
+	xmms_object_connect (XMMS_OBJECT (medialib),
+	                     XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED,
+	                     xmms_collection_cache_invalidate, ret);
+	xmms_object_connect (XMMS_OBJECT (ret),
+	                     XMMS_IPC_SIGNAL_COLLECTION_CHANGED,
+	                     xmms_collection_cache_invalidate, ret);
+
+	/* cursors belong to the client that opened them */
+	xmms_object_connect (XMMS_OBJECT (xmms_ipc_manager_get ()),
+	                     XMMS_IPC_SIGNAL_IPC_MANAGER_CLIENT_DISCONNECTED,
+	                     xmms_collection_client_disconnected, ret);
+
 	for (i = 0; i < XMMS_COLLECTION_NUM_NAMESPACES; ++i) {
 		ret->collrefs[i] = g_hash_table_new_full (g_str_hash, g_str_equal,
 		                                          g_free, coll_unref);
@@ -667,7 +771,8 @@ xmms_collection_query_ids (xmms_coll_dag_t *dag, xmmsv_t *coll,
 	                         XMMSV_DICT_ENTRY ("data", metadata),
 	                         XMMSV_DICT_END);
 
-	ret = xmms_collection_client_query (dag, coll, spec, err);
+	/* the caller owns the result, so it must not be a cached one */
+	ret = xmms_collection_query (dag, coll, spec, FALSE, err);
 	xmmsv_unref (spec);
 
 	return ret;
@@ -804,13 +909,30 @@ xmms_collection_client_query_infos (xmms_coll_dag_t *dag, xmmsv_t *coll,
 	return ret;
 }
 
+/**
+ * Run a query for a client.
+ *
+ * Results are cached until the media library or the collections
+ * change. A cached result is shared between the clients asking for it,
+ * so it must not be modified.
+ */
 xmmsv_t *
 xmms_collection_client_query (xmms_coll_dag_t *dag, xmmsv_t *coll,
                               xmmsv_t *fetch, xmms_error_t *err)
+{
+	return xmms_collection_query (dag, coll, fetch, TRUE, err);
+}
+
+static xmmsv_t *
+xmms_collection_query (xmms_coll_dag_t *dag, xmmsv_t *coll,
+                       xmmsv_t *fetch, gboolean cached, xmms_error_t *err)
 {
 	const gchar *valerr = "Invalid collection: unknown reason. This is "
 	                      "probably a bug in xmms2d.";
 	xmms_medialib_session_t *session;
+	coll_cache_entry_t *entry;
+	GString *key = NULL;
+	guint generation;
 	xmmsv_t *ret;
 
 	/* validate the collection to query */
@@ -825,16 +947,488 @@ xmms_collection_client_query (xmms_coll_dag_t *dag, xmmsv_t *coll,
 
 	xmms_collection_apply_to_collection (dag, coll, bind_all_references, NULL);
 
+	if (cached && dag->cache_limit > 0) {
+		/* references are bound by now, so the key covers their contents */
+		key = g_string_new (NULL);
+		if (!coll_cache_key_append (key, coll) ||
+		    !coll_cache_key_append (key, fetch)) {
+			g_string_free (key, TRUE);
+			key = NULL;
+		}
+	}
+
+	g_mutex_lock (&dag->cache_mutex);
+
+	generation = dag->cache_generation;
+
+	if (key != NULL) {
+		entry = g_hash_table_lookup (dag->cache, key->str);
+		if (entry != NULL) {
+			g_queue_unlink (dag->cache_order, entry->link);
+			g_queue_push_head_link (dag->cache_order, entry->link);
+
+			ret = xmmsv_ref (entry->result);
+
+			g_mutex_unlock (&dag->cache_mutex);
+			g_mutex_unlock (&dag->mutex);
+
+			g_string_free (key, TRUE);
+
+			return ret;
+		}
+	}
+
+	g_mutex_unlock (&dag->cache_mutex);
+
 	do {
 		session = xmms_medialib_session_begin_ro (dag->medialib);
 		ret = xmms_medialib_query (session, coll, fetch, err);
 	} while (!xmms_medialib_session_commit (session));
 
+	if (key != NULL) {
+		entry = NULL;
+
+		if (ret != NULL) {
+			entry = g_new0 (coll_cache_entry_t, 1);
+			entry->size = key->len + coll_cache_value_size (ret);
+			entry->key = g_string_free (key, FALSE);
+			entry->result = xmmsv_ref (ret);
+		} else {
+			g_string_free (key, TRUE);
+		}
+
+		g_mutex_lock (&dag->cache_mutex);
+
+		/* the result may predate a change announced while querying,
+		 * and one larger than the whole cache would only empty it */
+		if (entry != NULL && generation == dag->cache_generation &&
+		    entry->size <= dag->cache_limit &&
+		    !g_hash_table_contains (dag->cache, entry->key)) {
+			g_queue_push_head (dag->cache_order, entry);
+			entry->link = g_queue_peek_head_link (dag->cache_order);
+			g_hash_table_insert (dag->cache, entry->key, entry);
+			dag->cache_bytes += entry->size;
+
+			while (dag->cache_bytes > dag->cache_limit) {
+				entry = g_queue_pop_tail (dag->cache_order);
+				dag->cache_bytes -= entry->size;
+				g_hash_table_remove (dag->cache, entry->key);
+			}
+		} else if (entry != NULL) {
+			coll_cache_entry_free (entry);
+		}
+
+		g_mutex_unlock (&dag->cache_mutex);
+	}
+
 	g_mutex_unlock (&dag->mutex);
 
 	return ret;
 }
 
+static void
+coll_cache_entry_free (coll_cache_entry_t *entry)
+{
+	xmmsv_unref (entry->result);
+	g_free (entry->key);
+	g_free (entry);
+}
+
+static void
+coll_cache_key_append_dict (const gchar *key, xmmsv_t *value, gpointer udata)
+{
+	GList **keys = (GList **) udata;
+	*keys = g_list_prepend (*keys, (gpointer) key);
+}
+
+/**
+ * Append a canonical form of a value to a cache key. Dicts are written
+ * with sorted keys so equal values always give equal keys.
+ *
+ * @returns FALSE if results involving the value must not be cached.
+ */
+static gboolean
+coll_cache_key_append (GString *key, xmmsv_t *value)
+{
+	const gchar *str;
+	gint64 ival;
+	gfloat fval;
+	gint seed;
+	xmmsv_t *item;
+	GList *keys, *n;
+	gboolean ret = TRUE;
+	gint i;
+
+	switch (xmmsv_get_type (value)) {
+		case XMMSV_TYPE_NONE:
+			g_string_append_c (key, 'n');
+			break;
+		case XMMSV_TYPE_INT64:
+			xmmsv_get_int64 (value, &ival);
+			g_string_append_printf (key, "i%" G_GINT64_FORMAT ";", ival);
+			break;
+		case XMMSV_TYPE_FLOAT:
+			xmmsv_get_float (value, &fval);
+			g_string_append_printf (key, "f%a;", fval);
+			break;
+		case XMMSV_TYPE_STRING:
+			xmmsv_get_string (value, &str);
+			g_string_append_printf (key, "s%" G_GSIZE_FORMAT ":%s",
+			                        strlen (str), str);
+			break;
+		case XMMSV_TYPE_LIST:
+			g_string_append_c (key, '[');
+			for (i = 0; ret && xmmsv_list_get (value, i, &item); i++) {
+				ret = coll_cache_key_append (key, item);
+			}
+			g_string_append_c (key, ']');
+			break;
+		case XMMSV_TYPE_DICT:
+			keys = NULL;
+			xmmsv_dict_foreach (value, coll_cache_key_append_dict, &keys);
+			keys = g_list_sort (keys, (GCompareFunc) strcmp);
+
+			g_string_append_c (key, '{');
+			for (n = keys; ret && n != NULL; n = g_list_next (n)) {
+				g_string_append_printf (key, "%" G_GSIZE_FORMAT ":%s",
+				                        strlen (n->data), (gchar *) n->data);
+				xmmsv_dict_get (value, n->data, &item);
+				ret = coll_cache_key_append (key, item);
+			}
+			g_string_append_c (key, '}');
+
+			g_list_free (keys);
+			break;
+		case XMMSV_TYPE_COLL:
+			/* an unseeded random order differs on every run */
+			if (xmmsv_coll_is_type (value, XMMS_COLLECTION_TYPE_ORDER) &&
+			    xmmsv_coll_attribute_get_string (value, "type", &str) &&
+			    strcmp (str, "random") == 0 &&
+			    !xmms_collection_get_int_attr (value, "seed", &seed)) {
+				return FALSE;
+			}
+
+			g_string_append_printf (key, "c%d", xmmsv_coll_get_type (value));
+			ret = coll_cache_key_append (key, xmmsv_coll_attributes_get (value));
+
+			g_string_append_c (key, '[');
+			for (i = 0; xmmsv_coll_idlist_get_index_int64 (value, i, &ival); i++) {
+				g_string_append_printf (key, "i%" G_GINT64_FORMAT ";", ival);
+			}
+			g_string_append_c (key, ']');
+
+			ret = ret && coll_cache_key_append (key, xmmsv_coll_operands_get (value));
+			break;
+		default:
+			ret = FALSE;
+			break;
+	}
+
+	return ret;
+}
+
+static void
+coll_cache_value_size_dict (const gchar *key, xmmsv_t *value, gpointer udata)
+{
+	gsize *size = (gsize *) udata;
+	*size += strlen (key) + 1 + coll_cache_value_size (value);
+}
+
+/**
+ * Roughly estimate the memory held by a value, including what it
+ * contains.
+ */
+static gsize
+coll_cache_value_size (xmmsv_t *value)
+{
+	const gchar *str;
+	xmmsv_t *item;
+	gsize size;
+	gint i;
+
+	size = XMMS_COLLECTION_CACHE_VALUE_OVERHEAD;
+
+	switch (xmmsv_get_type (value)) {
+		case XMMSV_TYPE_STRING:
+			xmmsv_get_string (value, &str);
+			size += strlen (str) + 1;
+			break;
+		case XMMSV_TYPE_LIST:
+			for (i = 0; xmmsv_list_get (value, i, &item); i++) {
+				size += sizeof (xmmsv_t *) + coll_cache_value_size (item);
+			}
+			break;
+		case XMMSV_TYPE_DICT:
+			xmmsv_dict_foreach (value, coll_cache_value_size_dict, &size);
+			break;
+		default:
+			break;
+	}
+
+	return size;
+}
+
+/**
+ * Drop all cached query results. Connected to every signal that
+ * announces a change which may affect the result of a query.
+ */
+static void
+xmms_collection_cache_invalidate (xmms_object_t *object, xmmsv_t *data,
+                                  gpointer udata)
+{
+	xmms_coll_dag_t *dag = (xmms_coll_dag_t *) udata;
+
+	g_mutex_lock (&dag->cache_mutex);
+	dag->cache_generation++;
+	g_hash_table_remove_all (dag->cache);
+	g_queue_clear (dag->cache_order);
+	dag->cache_bytes = 0;
+	g_mutex_unlock (&dag->cache_mutex);
+}
+
+static void
+xmms_collection_cache_size_changed (xmms_object_t *object, xmmsv_t *data,
+                                    gpointer udata)
+{
+	xmms_coll_dag_t *dag = (xmms_coll_dag_t *) udata;
+	gint size;
+
+	size = xmms_config_property_get_int ((xmms_config_property_t *) object);
+
+	g_mutex_lock (&dag->cache_mutex);
+	dag->cache_limit = MAX (0, size);
+	g_mutex_unlock (&dag->cache_mutex);
+
+	xmms_collection_cache_invalidate (object, data, udata);
+}
+
+static void
+coll_cursor_free (coll_cursor_t *cursor)
+{
+	g_free (cursor->ids);
+	xmmsv_unref (cursor->fetch);
+	g_free (cursor);
+}
+
+/* Must be called with cursor_mutex held. */
+static void
+xmms_collection_cursor_remove (xmms_coll_dag_t *dag, gint32 id)
+{
+	g_queue_remove (dag->cursor_order, GINT_TO_POINTER (id));
+	g_hash_table_remove (dag->cursors, GINT_TO_POINTER (id));
+}
+
+/* Must be called with cursor_mutex held. Cursors of other clients are
+ * reported as missing, their ids are no business of the caller. */
+static coll_cursor_t *
+xmms_collection_cursor_lookup (xmms_coll_dag_t *dag, gint32 id, gint32 client,
+                               xmms_error_t *err)
+{
+	coll_cursor_t *cursor;
+
+	cursor = g_hash_table_lookup (dag->cursors, GINT_TO_POINTER (id));
+	if (cursor == NULL || cursor->client != client) {
+		xmms_error_set (err, XMMS_ERROR_NOENT, "No such cursor");
+		return NULL;
+	}
+
+	return cursor;
+}
+
+/**
+ * Drop the cursors of a client that went away.
+ */
+static void
+xmms_collection_client_disconnected (xmms_object_t *object, xmmsv_t *data,
+                                     gpointer udata)
+{
+	xmms_coll_dag_t *dag = (xmms_coll_dag_t *) udata;
+	coll_cursor_t *cursor;
+	GList *n, *next;
+	gint32 client;
+
+	if (!xmmsv_get_int32 (data, &client)) {
+		return;
+	}
+
+	g_mutex_lock (&dag->cursor_mutex);
+
+	for (n = dag->cursor_order->head; n; n = next) {
+		next = n->next;
+		cursor = g_hash_table_lookup (dag->cursors, n->data);
+		if (cursor->client == client) {
+			xmms_collection_cursor_remove (dag, cursor->id);
+		}
+	}
+
+	g_mutex_unlock (&dag->cursor_mutex);
+}
+
+/**
+ * Open a cursor over the media matched by a collection.
+ *
+ * Only the ordered ids of the matching media are kept, the fetch
+ * specification is applied to one page at a time by
+ * #xmms_collection_client_query_next, so the full result is never
+ * built. The ids themselves are all resolved here, so that the pages
+ * stay consistent with each other while the media library changes.
+ *
+ * The cursor can only be used by the client that opened it, and is
+ * dropped when that client disconnects.
+ *
+ * @param dag  The collection DAG.
+ * @param coll  The collection used to match media.
+ * @param fetch  The fetch specification used for each page.
+ * @param client  The id of the calling client.
+ * @param err  If an error occurs, a message is stored in it.
+ * @return The id of the new cursor, or 0 on error.
+ */
+static gint32
+xmms_collection_client_query_open (xmms_coll_dag_t *dag, xmmsv_t *coll,
+                                   xmmsv_t *fetch, gint32 client,
+                                   xmms_error_t *err)
+{
+	coll_cursor_t *cursor, *other;
+	xmmsv_t *ids;
+	gint32 id, oldest = 0;
+	guint open = 0;
+	GList *n;
+	gint i;
+
+	ids = xmms_collection_query_ids (dag, coll, err);
+	if (ids == NULL) {
+		return 0;
+	}
+
+	cursor = g_new0 (coll_cursor_t, 1);
+	cursor->client = client;
+	cursor->size = xmmsv_list_get_size (ids);
+	cursor->ids = g_new (xmms_medialib_entry_t, cursor->size);
+	cursor->fetch = xmmsv_ref (fetch);
+
+	for (i = 0; i < cursor->size; i++) {
+		xmmsv_list_get_int32 (ids, i, &cursor->ids[i]);
+	}
+	xmmsv_unref (ids);
+
+	g_mutex_lock (&dag->cursor_mutex);
+
+	for (n = dag->cursor_order->head; n; n = n->next) {
+		other = g_hash_table_lookup (dag->cursors, n->data);
+		if (other->client == client && open++ == 0) {
+			oldest = other->id;
+		}
+	}
+
+	if (open >= XMMS_COLLECTION_MAX_CURSORS) {
+		XMMS_DBG ("Too many open cursors, dropping cursor %d", oldest);
+		xmms_collection_cursor_remove (dag, oldest);
+	}
+
+	id = cursor->id = dag->next_cursor++;
+	if (dag->next_cursor <= 0) {
+		dag->next_cursor = 1;
+	}
+
+	g_hash_table_insert (dag->cursors, GINT_TO_POINTER (id), cursor);
+	g_queue_push_tail (dag->cursor_order, GINT_TO_POINTER (id));
+
+	g_mutex_unlock (&dag->cursor_mutex);
+
+	return id;
+}
+
+/**
+ * Fetch the next page of a cursor opened by
+ * #xmms_collection_client_query_open.
+ *
+ * The fetch specification of the cursor is applied to the media of
+ * the page alone, in order. Aggregates such as count or sum therefore
+ * cover one page, not the whole result. The cursor is closed once it
+ * has no more media to hand out.
+ *
+ * @param dag  The collection DAG.
+ * @param cursor  The id of the cursor.
+ * @param count  The maximum number of media in the page.
+ * @param client  The id of the calling client.
+ * @param err  If an error occurs, a message is stored in it.
+ * @return The page, or none if the cursor has no more media.
+ */
+static xmmsv_t *
+xmms_collection_client_query_next (xmms_coll_dag_t *dag, gint32 cursor,
+                                   gint32 count, gint32 client,
+                                   xmms_error_t *err)
+{
+	coll_cursor_t *cur;
+	xmmsv_t *page, *fetch, *ret;
+	gint i, end;
+
+	if (count <= 0) {
+		xmms_error_set (err, XMMS_ERROR_INVAL, "Page size must be positive");
+		return NULL;
+	}
+
+	count = MIN (count, XMMS_COLLECTION_MAX_PAGE);
+
+	g_mutex_lock (&dag->cursor_mutex);
+
+	cur = xmms_collection_cursor_lookup (dag, cursor, client, err);
+	if (cur == NULL) {
+		g_mutex_unlock (&dag->cursor_mutex);
+		return NULL;
+	}
+
+	end = MIN (cur->position + count, cur->size);
+
+	page = xmmsv_new_coll (XMMS_COLLECTION_TYPE_IDLIST);
+	for (i = cur->position; i < end; i++) {
+		xmmsv_coll_idlist_append (page, cur->ids[i]);
+	}
+
+	fetch = xmmsv_ref (cur->fetch);
+
+	if (cur->position == end) {
+		xmms_collection_cursor_remove (dag, cursor);
+	} else {
+		cur->position = end;
+	}
+
+	g_mutex_unlock (&dag->cursor_mutex);
+
+	/* pages are rarely asked for twice, keep them out of the cache */
+	if (xmmsv_coll_idlist_get_size (page) > 0) {
+		ret = xmms_collection_query (dag, page, fetch, FALSE, err);
+	} else {
+		ret = xmmsv_new_none ();
+	}
+
+	xmmsv_unref (fetch);
+	xmmsv_unref (page);
+
+	return ret;
+}
+
+/**
+ * Close a cursor before all its pages have been fetched.
+ *
+ * @param dag  The collection DAG.
+ * @param cursor  The id of the cursor.
+ * @param client  The id of the calling client.
+ * @param err  If an error occurs, a message is stored in it.
+ */
+static void
+xmms_collection_client_query_close (xmms_coll_dag_t *dag, gint32 cursor,
+                                    gint32 client, xmms_error_t *err)
+{
+	g_mutex_lock (&dag->cursor_mutex);
+
+	if (xmms_collection_cursor_lookup (dag, cursor, client, err)) {
+		xmms_collection_cursor_remove (dag, cursor);
+	}
+
+	g_mutex_unlock (&dag->cursor_mutex);
+}
+
 /**
  * Update a reference to point to a new collection.
  *
@@ -996,15 +1590,44 @@ static void
 xmms_collection_destroy (xmms_object_t *object)
 {
 	xmms_coll_dag_t *dag = (xmms_coll_dag_t *)object;
+	xmms_config_property_t *cv;
 	gint i;
 
 	XMMS_DBG ("Deactivating collection object.");
 
 	g_return_if_fail (dag);
 
+	xmms_object_disconnect (XMMS_OBJECT (dag->medialib),
+	                        XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_ADDED,
+	                        xmms_collection_cache_invalidate, dag);
+	xmms_object_disconnect (XMMS_OBJECT (dag->medialib),
+	                        XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_CHANGED,
+	                        xmms_collection_cache_invalidate, dag);
+	xmms_object_disconnect (XMMS_OBJECT (dag->medialib),
+	                        XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_REMOVED,
+	                        xmms_collection_cache_invalidate, dag);
+	xmms_object_disconnect (XMMS_OBJECT (dag->medialib),
+	                        XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED,
+	                        xmms_collection_cache_invalidate, dag);
+	xmms_object_disconnect (XMMS_OBJECT (xmms_ipc_manager_get ()),
+	                        XMMS_IPC_SIGNAL_IPC_MANAGER_CLIENT_DISCONNECTED,
+	                        xmms_collection_client_disconnected, dag);
+
+	cv = xmms_config_lookup ("collection.query_cache_bytes");
+	xmms_config_property_callback_remove (cv, xmms_collection_cache_size_changed,
+	                                      dag);
+
 	xmms_object_unref (dag->medialib);
 	g_mutex_clear (&dag->mutex);
 
+	g_hash_table_destroy (dag->cache);
+	g_queue_free (dag->cache_order);
+	g_mutex_clear (&dag->cache_mutex);
+
+	g_hash_table_destroy (dag->cursors);
+	g_queue_free (dag->cursor_order);
+	g_mutex_clear (&dag->cursor_mutex);
+
 	for (i = 0; i < XMMS_COLLECTION_NUM_NAMESPACES; ++i) {
 		g_hash_table_destroy (dag->collrefs[i]);  /* dag is freed here */
 	}
@@ -52,15 +52,41 @@ struct xmms_sample_converter_St {
 
 	xmms_sample_t *state;
 
+	/* windowed sinc filter, interpolator_ratio phases of taps
+	 * coefficients each, NULL when interpolating linearly */
+	gfloat *filter;
+	guint taps;
+
+	/* the last taps - 1 input frames followed by the new ones */
+	gfloat *history;
+	guint history_frames;
+
+	/* output of the filter, before conversion to the output format */
+	gfloat *result;
+	guint result_frames;
+
 	xmms_sample_conv_func_t func;
 
 };
 
-static void recalculate_resampler (xmms_sample_converter_t *conv, guint from, guint to);
+/* Largest interpolation ratio we build a filter for, above that the
+ * table gets too big and we interpolate linearly instead. */
+#define SINC_MAX_PHASES 1024
+
+static const struct {
+	guint taps;
+	gdouble rolloff;
+} sinc_presets[] = {
+	[XMMS_SAMPLE_RESAMPLE_LOW] = { 8, 0.80 },
+	[XMMS_SAMPLE_RESAMPLE_MEDIUM] = { 16, 0.90 },
+	[XMMS_SAMPLE_RESAMPLE_HIGH] = { 32, 0.95 },
+};
+
+static void recalculate_resampler (xmms_sample_converter_t *conv, guint from, guint to, xmms_sample_resample_quality_t quality);
 static xmms_sample_conv_func_t
 xmms_sample_conv_get (guint inchannels, xmms_sample_format_t intype,
                       guint outchannels, xmms_sample_format_t outtype,
-                      gboolean resample);
+                      gboolean resample, gboolean sinc);
 
 
 
@@ -71,10 +97,21 @@ xmms_sample_converter_destroy (xmms_object_t *obj)
 
 	g_free (conv->buf);
 	g_free (conv->state);
+	g_free (conv->filter);
+	g_free (conv->history);
+	g_free (conv->result);
 }
 
+/**
+ * Create a converter between two audio formats.
+ *
+ * @param from the format of the input
+ * @param to the format of the output
+ * @param quality how to resample, if the sample rates differ
+ */
 xmms_sample_converter_t *
-xmms_sample_converter_init (xmms_stream_type_t *from, xmms_stream_type_t *to)
+xmms_sample_converter_init (xmms_stream_type_t *from, xmms_stream_type_t *to,
+                            xmms_sample_resample_quality_t quality)
 {
 	xmms_sample_converter_t *conv = xmms_object_new (xmms_sample_converter_t, xmms_sample_converter_destroy);
 	gint fformat, fsamplerate, fchannels;
@@ -96,9 +133,13 @@ xmms_sample_converter_init (xmms_stream_type_t *from, xmms_stream_type_t *to)
 
 	conv->resample = fsamplerate != tsamplerate;
 
+	if (conv->resample)
+		recalculate_resampler (conv, fsamplerate, tsamplerate, quality);
+
 	conv->func = xmms_sample_conv_get (fchannels, fformat,
 	                                   tchannels, tformat,
-	                                   conv->resample);
+	                                   conv->resample,
+	                                   conv->filter != NULL);
 
 	if (!conv->func) {
 		xmms_object_unref (conv);
@@ -108,12 +149,27 @@ xmms_sample_converter_init (xmms_stream_type_t *from, xmms_stream_type_t *to)
 		return NULL;
 	}
 
-	if (conv->resample)
-		recalculate_resampler (conv, fsamplerate, tsamplerate);
-
 	return conv;
 }
 
+/**
+ * Map the name of a resampling quality to its value. Unknown names
+ * give the medium quality.
+ */
+xmms_sample_resample_quality_t
+xmms_sample_resample_quality_from_string (const gchar *name)
+{
+	if (!g_ascii_strcasecmp (name, "linear")) {
+		return XMMS_SAMPLE_RESAMPLE_LINEAR;
+	} else if (!g_ascii_strcasecmp (name, "low")) {
+		return XMMS_SAMPLE_RESAMPLE_LOW;
+	} else if (!g_ascii_strcasecmp (name, "high")) {
+		return XMMS_SAMPLE_RESAMPLE_HIGH;
+	}
+
+	return XMMS_SAMPLE_RESAMPLE_MEDIUM;
+}
+
 /**
  * Return the audio format used by the converter as source
  */
@@ -170,8 +226,136 @@ xmms_sample_converter_to_medialib (xmms_sample_converter_t *conv, xmms_medialib_
 }
 
 
+/* Build the polyphase filter. Phase p computes the output p / L of the
+ * way between two input frames, from taps input frames centered on it.
+ */
+static void
+calculate_sinc_filter (xmms_sample_converter_t *conv, guint taps,
+                       gdouble rolloff)
+{
+	guint phases = conv->interpolator_ratio;
+	gdouble cutoff, t, x, w, sum;
+	guint p, k;
+
+	/* when decimating the cutoff moves down to the new nyquist */
+	cutoff = rolloff * MIN (1.0, (gdouble) conv->interpolator_ratio / conv->decimator_ratio);
+
+	conv->taps = taps;
+	conv->filter = g_new (gfloat, phases * taps);
+
+	for (p = 0; p < phases; p++) {
+		gfloat *h = &conv->filter[p * taps];
+
+		sum = 0.0;
+		for (k = 0; k < taps; k++) {
+			t = (gdouble) k - (taps / 2 - 1) - (gdouble) p / phases;
+
+			x = M_PI * cutoff * t;
+			w = 0.42 + 0.5 * cos (M_PI * t / (taps / 2)) +
+			    0.08 * cos (2.0 * M_PI * t / (taps / 2));
+			if (fabs (t) >= taps / 2) {
+				w = 0.0;
+			}
+
+			h[k] = (x == 0.0 ? 1.0 : sin (x) / x) * w;
+			sum += h[k];
+		}
+
+		/* unity gain for dc */
+		for (k = 0; k < taps; k++) {
+			h[k] /= sum;
+		}
+	}
+}
+
+/* Make room for len new input frames after the history, and return
+ * where they go.
+ */
+static gfloat *
+sinc_input_get (xmms_sample_converter_t *conv, guint len)
+{
+	guint channels = xmms_stream_type_get_int (conv->from, XMMS_STREAM_TYPE_FMT_CHANNELS);
+
+	if (conv->taps - 1 + len > conv->history_frames) {
+		conv->history_frames = conv->taps - 1 + len;
+		conv->history = g_renew (gfloat, conv->history,
+		                         conv->history_frames * channels);
+	}
+
+	return &conv->history[(conv->taps - 1) * channels];
+}
+
+/* Clamp a filtered sample to the range of the READ/WRITE macros */
+static inline guint32
+sinc_sample_get (gfloat v)
+{
+	v += 2147483648.0f;
+	if (v <= 0.0f) {
+		return 0;
+	}
+	if (v >= 4294967295.0f) {
+		return G_MAXUINT32;
+	}
+	return (guint32) v;
+}
+
+/* Run the filter over the history and len new frames put there with
+ * sinc_input_get. Returns the number of output frames, each one with
+ * as many channels as the input.
+ */
+static guint
+sinc_run (xmms_sample_converter_t *conv, guint len, gfloat **result)
+{
+	guint channels = xmms_stream_type_get_int (conv->from, XMMS_STREAM_TYPE_FMT_CHANNELS);
+	guint taps = conv->taps;
+	guint pos, ipos, n = 0;
+	guint k, c, need;
+
+	need = (len * conv->interpolator_ratio / conv->decimator_ratio) + 1;
+	if (need > conv->result_frames) {
+		conv->result_frames = need;
+		conv->result = g_renew (gfloat, conv->result, need * channels);
+	}
+
+	pos = conv->offset;
+
+	while (pos < len * conv->interpolator_ratio) {
+		const gfloat *h = &conv->filter[(pos % conv->interpolator_ratio) * taps];
+		gfloat *out = &conv->result[n * channels];
+
+		ipos = pos / conv->interpolator_ratio;
+
+		for (c = 0; c < channels; c++) {
+			out[c] = 0.0f;
+		}
+
+		/* channels innermost, they are next to each other */
+		for (k = 0; k < taps; k++) {
+			const gfloat *in = &conv->history[(ipos + k) * channels];
+
+			for (c = 0; c < channels; c++) {
+				out[c] += h[k] * in[c];
+			}
+		}
+
+		n++;
+		pos += conv->decimator_ratio;
+	}
+
+	conv->offset = pos - len * conv->interpolator_ratio;
+
+	/* keep the last frames around for the next call */
+	memmove (conv->history, &conv->history[len * channels],
+	         (taps - 1) * channels * sizeof (gfloat));
+
+	*result = conv->result;
+
+	return n;
+}
+
 static void
-recalculate_resampler (xmms_sample_converter_t *conv, guint from, guint to)
+recalculate_resampler (xmms_sample_converter_t *conv, guint from, guint to,
+                       xmms_sample_resample_quality_t quality)
 {
 	guint a,b;
 
@@ -198,13 +382,21 @@ recalculate_resampler (xmms_sample_converter_t *conv, guint from, guint to)
 
 	conv->state = g_malloc0 (xmms_sample_frame_size_get (conv->from));
 
-	/*
-	 * calculate filter here
-	 *
-	 * We don't use no stinkning filter. Maybe we should,
-	 * but I'm deaf anyway, I wont hear any difference.
-	 */
+	if (quality == XMMS_SAMPLE_RESAMPLE_LINEAR) {
+		return;
+	}
+
+	if (conv->interpolator_ratio > SINC_MAX_PHASES) {
+		XMMS_DBG ("Resampling ratio too fine for a filter, interpolating linearly");
+		return;
+	}
+
+	calculate_sinc_filter (conv, sinc_presets[quality].taps,
+	                       sinc_presets[quality].rolloff);
 
+	conv->history_frames = sinc_presets[quality].taps - 1;
+	conv->history = g_new0 (gfloat, conv->history_frames *
+	                        xmms_stream_type_get_int (conv->from, XMMS_STREAM_TYPE_FMT_CHANNELS));
 }
 
 
@@ -278,6 +470,10 @@ xmms_sample_convert_reset (xmms_sample_converter_t *conv)
 	if (conv->resample) {
 		conv->offset = 0;
 		memset (conv->state, 0, xmms_sample_frame_size_get (conv->from));
+		if (conv->history) {
+			memset (conv->history, 0, conv->history_frames * sizeof (gfloat) *
+			        xmms_stream_type_get_int (conv->from, XMMS_STREAM_TYPE_FMT_CHANNELS));
+		}
 	}
 }
 
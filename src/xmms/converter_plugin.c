@@ -39,6 +39,7 @@ xmms_converter_plugin_init (xmms_xform_t *xform)
 	xmms_sample_converter_t *conv;
 	xmms_stream_type_t *intype;
 	xmms_stream_type_t *to;
+	xmms_config_property_t *cv;
 	const GList *goal_hints;
 
 	intype = xmms_xform_intype_get (xform);
@@ -49,7 +50,9 @@ xmms_converter_plugin_init (xmms_xform_t *xform)
 		return FALSE;
 	}
 
-	conv = xmms_sample_converter_init (intype, to);
+	cv = xmms_xform_config_lookup (xform, "resample_quality");
+	conv = xmms_sample_converter_init (intype, to,
+	                                   xmms_sample_resample_quality_from_string (xmms_config_property_get_string (cv)));
 	if (!conv) {
 		return FALSE;
 	}
@@ -145,6 +148,12 @@ xmms_converter_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 
 	xmms_xform_plugin_methods_set (xform_plugin, &methods);
 
+	/* linear, low, medium or high */
+	xmms_xform_plugin_config_property_register (xform_plugin,
+	                                            "resample_quality",
+	                                            "medium",
+	                                            NULL, NULL);
+
 	/*
 	 * Handle any pcm data...
 	 * Well, we don't really..
@@ -0,0 +1,235 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2017 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/**
+ * @file
+ * Effect stage.
+ *
+ * Runs the process methods of a sequence of effect plugins over one
+ * float buffer per read, instead of chaining one xform per effect with
+ * a sample conversion in front of each.
+ */
+
+#include <string.h>
+#include <glib.h>
+
+#include <xmmspriv/xmms_xform.h>
+#include <xmms/xmms_sample.h>
+#include <xmms/xmms_log.h>
+
+typedef struct xmms_effect_stage_data_St {
+	/** the xforms whose process methods are run, in order */
+	GPtrArray *kernels;
+
+	xmms_sample_format_t format;
+	gint channels;
+
+	gfloat *buffer;
+	gint buffer_frames;
+} xmms_effect_stage_data_t;
+
+static gboolean
+xmms_effect_stage_init (xmms_xform_t *xform)
+{
+	xmms_effect_stage_data_t *data;
+
+	data = g_new0 (xmms_effect_stage_data_t, 1);
+	data->kernels = g_ptr_array_new_with_free_func (xmms_object_unref);
+	data->format = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_FORMAT);
+	data->channels = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_CHANNELS);
+
+	xmms_xform_private_data_set (xform, data);
+	xmms_xform_outdata_type_copy (xform);
+
+	return TRUE;
+}
+
+static void
+xmms_effect_stage_destroy (xmms_xform_t *xform)
+{
+	xmms_effect_stage_data_t *data;
+
+	data = xmms_xform_private_data_get (xform);
+	g_return_if_fail (data);
+
+	g_ptr_array_free (data->kernels, TRUE);
+	g_free (data->buffer);
+	g_free (data);
+}
+
+static void
+to_float (xmms_effect_stage_data_t *data, const xmms_sample_t *in, gint samples)
+{
+	gint i;
+
+	switch (data->format) {
+		case XMMS_SAMPLE_FORMAT_S16: {
+			const xmms_samples16_t *s = in;
+			for (i = 0; i < samples; i++) {
+				data->buffer[i] = s[i] * (1.0f / 32768.0f);
+			}
+			break;
+		}
+		case XMMS_SAMPLE_FORMAT_S32: {
+			const xmms_samples32_t *s = in;
+			for (i = 0; i < samples; i++) {
+				data->buffer[i] = s[i] * (1.0 / 2147483648.0);
+			}
+			break;
+		}
+		case XMMS_SAMPLE_FORMAT_FLOAT:
+			memcpy (data->buffer, in, samples * sizeof (gfloat));
+			break;
+		default:
+			g_assert_not_reached ();
+			break;
+	}
+}
+
+static void
+from_float (xmms_effect_stage_data_t *data, xmms_sample_t *out, gint samples)
+{
+	gint i;
+
+	switch (data->format) {
+		case XMMS_SAMPLE_FORMAT_S16: {
+			xmms_samples16_t *s = out;
+			for (i = 0; i < samples; i++) {
+				gfloat v = data->buffer[i] * 32768.0f;
+				s[i] = CLAMP (v, XMMS_SAMPLES16_MIN, XMMS_SAMPLES16_MAX);
+			}
+			break;
+		}
+		case XMMS_SAMPLE_FORMAT_S32: {
+			xmms_samples32_t *s = out;
+			for (i = 0; i < samples; i++) {
+				gdouble v = data->buffer[i] * 2147483648.0;
+				s[i] = CLAMP (v, XMMS_SAMPLES32_MIN, XMMS_SAMPLES32_MAX);
+			}
+			break;
+		}
+		case XMMS_SAMPLE_FORMAT_FLOAT:
+			memcpy (out, data->buffer, samples * sizeof (gfloat));
+			break;
+		default:
+			g_assert_not_reached ();
+			break;
+	}
+}
+
+static gint
+xmms_effect_stage_read (xmms_xform_t *xform, xmms_sample_t *buf, gint len,
+                        xmms_error_t *error)
+{
+	xmms_effect_stage_data_t *data;
+	gboolean active = FALSE;
+	gint read, frames, i;
+
+	data = xmms_xform_private_data_get (xform);
+	g_return_val_if_fail (data, -1);
+
+	read = xmms_xform_read (xform, buf, len, error);
+	if (read <= 0) {
+		return read;
+	}
+
+	/* the round trip through float is not lossless for S32, so
+	 * leave the samples alone when no effect would touch them */
+	for (i = 0; i < data->kernels->len && !active; i++) {
+		active = xmms_xform_this_active (g_ptr_array_index (data->kernels, i));
+	}
+
+	if (!active) {
+		return read;
+	}
+
+	frames = read / (xmms_sample_size_get (data->format) * data->channels);
+
+	if (frames > data->buffer_frames) {
+		data->buffer_frames = frames;
+		data->buffer = g_renew (gfloat, data->buffer, frames * data->channels);
+	}
+
+	to_float (data, buf, frames * data->channels);
+
+	for (i = 0; i < data->kernels->len; i++) {
+		xmms_xform_t *kernel = g_ptr_array_index (data->kernels, i);
+		xmms_xform_this_process (kernel, data->buffer, frames);
+	}
+
+	from_float (data, buf, frames * data->channels);
+
+	return read;
+}
+
+static gint64
+xmms_effect_stage_seek (xmms_xform_t *xform, gint64 samples,
+                        xmms_xform_seek_mode_t whence, xmms_error_t *error)
+{
+	return xmms_xform_seek (xform, samples, whence, error);
+}
+
+/**
+ * Append an initialised effect xform to an effect stage.  The stage
+ * keeps a reference to it and runs its process method on every read.
+ */
+void
+xmms_effect_stage_kernel_add (xmms_xform_t *stage, xmms_xform_t *kernel)
+{
+	xmms_effect_stage_data_t *data;
+
+	data = xmms_xform_private_data_get (stage);
+	g_return_if_fail (data);
+
+	g_ptr_array_add (data->kernels, xmms_object_ref (kernel));
+}
+
+static gboolean
+xmms_effect_stage_setup (xmms_xform_plugin_t *xform_plugin)
+{
+	static const xmms_sample_format_t formats[] = {
+		XMMS_SAMPLE_FORMAT_S16,
+		XMMS_SAMPLE_FORMAT_S32,
+		XMMS_SAMPLE_FORMAT_FLOAT
+	};
+	xmms_xform_methods_t methods;
+	gint i;
+
+	XMMS_XFORM_METHODS_INIT (methods);
+	methods.init = xmms_effect_stage_init;
+	methods.destroy = xmms_effect_stage_destroy;
+	methods.read = xmms_effect_stage_read;
+	methods.seek = xmms_effect_stage_seek;
+
+	xmms_xform_plugin_methods_set (xform_plugin, &methods);
+
+	for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+		xmms_xform_plugin_indata_add (xform_plugin,
+		                              XMMS_STREAM_TYPE_MIMETYPE,
+		                              "audio/pcm",
+		                              XMMS_STREAM_TYPE_FMT_FORMAT,
+		                              formats[i],
+		                              XMMS_STREAM_TYPE_END);
+	}
+
+	return TRUE;
+}
+
+XMMS_XFORM_BUILTIN_DEFINE (effects,
+                           "Effect stage",
+                           XMMS_VERSION,
+                           "Runs effect plugins over a shared float buffer",
+                           xmms_effect_stage_setup);
@@ -65,24 +65,45 @@ struct xmms_ipc_St {
  * A IPC client representation.
  */
 typedef struct xmms_ipc_client_St {
+	/** The client's own loop, NULL when served by the worker pool */
 	GMainLoop *ml;
+	/** The context the client's sources are attached to */
+	GMainContext *context;
 	GIOChannel *iochan;
 
 	xmms_ipc_transport_t *transport;
 	xmms_ipc_msg_t *read_msg;
 	xmms_ipc_t *ipc;
 
-	/* this lock protects out_msg, pendingsignals and broadcasts,
-	   which can be accessed from other threads than the
-	   client-thread */
+	/* this lock protects out_msg, write_source, in_msg, scheduled,
+	   paused, dead, pendingsignals, signalrate, signaltimer and broadcasts,
+	   which can be accessed from other threads than the client-thread */
 	GMutex lock;
 
 	/** Messages waiting to be written */
 	GQueue *out_msg;
+	GSource *write_source;
+
+	/** Messages read but not yet processed by the worker pool */
+	GQueue *in_msg;
+	/** TRUE while the client is queued in or served by the worker pool */
+	gboolean scheduled;
+	/** TRUE while the socket isn't read because in_msg is full */
+	gboolean paused;
+	/** TRUE once the client has disconnected */
+	gboolean dead;
+
+	gint ref;
 
 	guint pendingsignals[XMMS_IPC_SIGNAL_END];
 	GList *broadcasts[XMMS_IPC_SIGNAL_END];
 
+	/** Delivery rate the client asked for, and the value held back
+	    until the interval is over */
+	xmms_ipc_signal_rate_t signalrate[XMMS_IPC_SIGNAL_END];
+	/** Pending timers that deliver the held values */
+	GSource *signaltimer[XMMS_IPC_SIGNAL_END];
+
 	gint32 id;
 } xmms_ipc_client_t;
 
@@ -94,11 +115,28 @@ static GList *ipc_servers = NULL;
 
 static xmms_ipc_manager_t *ipc_manager = NULL;
 
+/* Shared by all clients when core.ipc_workers is above 0 */
+static GMainContext *ipc_io_context = NULL;
+static GMainLoop *ipc_io_loop = NULL;
+static GThread *ipc_io_thread = NULL;
+static GThreadPool *ipc_worker_pool = NULL;
+/* Set while the pool shuts down, queued messages are dropped then */
+static gint ipc_workers_stopping = FALSE;
+
+/* How many messages of a client may wait for a worker before its socket
+ * isn't read anymore, and how many are left when reading resumes */
+#define XMMS_IPC_CLIENT_QUEUE_MAX 64
+#define XMMS_IPC_CLIENT_QUEUE_RESUME (XMMS_IPC_CLIENT_QUEUE_MAX / 2)
+
 static GMutex ipc_object_pool_lock;
 static struct xmms_ipc_object_pool_t *ipc_object_pool = NULL;
 
 static void xmms_ipc_close (void);
 static void xmms_ipc_client_destroy (xmms_ipc_client_t *client);
+static xmms_ipc_client_t *xmms_ipc_client_ref (xmms_ipc_client_t *client);
+static void xmms_ipc_client_unref (xmms_ipc_client_t *client);
+static void xmms_ipc_client_disconnect (xmms_ipc_client_t *client);
+static void xmms_ipc_client_watch (xmms_ipc_client_t *client);
 
 static xmms_ipc_client_t *xmms_ipc_lookup_client (gint32 clientid);
 
@@ -106,6 +144,7 @@ static void xmms_ipc_register_signal (xmms_ipc_client_t *client, xmms_ipc_msg_t
 static void xmms_ipc_register_broadcast (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg, xmmsv_t *arguments);
 static gboolean xmms_ipc_client_msg_write (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg);
 static gboolean xmms_ipc_client_broadcast_write (guint broadcastid, xmms_ipc_client_t *cli, xmmsv_t *arg);
+static void xmms_ipc_client_signal_release (xmms_ipc_client_t *cli, guint signalid, gboolean flush);
 
 #include "ipc_manager_ipc.c"
 
@@ -121,8 +160,8 @@ static void
 xmms_ipc_register_signal (xmms_ipc_client_t *client,
                           xmms_ipc_msg_t *msg, xmmsv_t *arguments)
 {
-	xmmsv_t *arg;
-	gint32 signalid;
+	xmmsv_t *arg, *arg2;
+	gint32 signalid, interval = -1;
 	int r;
 
 	if (!arguments || !xmmsv_list_get (arguments, 0, &arg)) {
@@ -130,6 +169,15 @@ xmms_ipc_register_signal (xmms_ipc_client_t *client,
 		return;
 	}
 
+	/* an optional second argument sets the minimum interval in
+	 * milliseconds; restarting the signal without it keeps the
+	 * interval that was set before */
+	if (xmmsv_list_get (arguments, 1, &arg2) &&
+	    !xmmsv_get_int32 (arg2, &interval)) {
+		xmms_log_error ("Cannot extract signal interval from value");
+		return;
+	}
+
 	r = xmmsv_get_int32 (arg, &signalid);
 
 	if (!r) {
@@ -144,6 +192,11 @@ xmms_ipc_register_signal (xmms_ipc_client_t *client,
 
 	g_mutex_lock (&client->lock);
 	client->pendingsignals[signalid] = xmms_ipc_msg_get_cookie (msg);
+	if (interval >= 0) {
+		client->signalrate[signalid].interval = (gint64) interval * 1000;
+	}
+	/* a value held back while the signal was not pending */
+	xmms_ipc_client_signal_release (client, signalid, FALSE);
 	g_mutex_unlock (&client->lock);
 }
 
@@ -272,6 +325,74 @@ out:
 }
 
 
+/**
+ * Hand a message read from the client to the worker pool. Only one
+ * worker serves a client at a time, so its messages are processed
+ * in the order they were read.
+ *
+ * @return FALSE if the client has too many messages waiting, in which
+ * case its socket must not be read until a worker has caught up.
+ */
+static gboolean
+xmms_ipc_client_queue_msg (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg)
+{
+	gboolean more;
+
+	g_mutex_lock (&client->lock);
+	g_queue_push_tail (client->in_msg, msg);
+	if (!client->scheduled) {
+		client->scheduled = TRUE;
+		g_thread_pool_push (ipc_worker_pool, xmms_ipc_client_ref (client), NULL);
+	}
+	more = g_queue_get_length (client->in_msg) < XMMS_IPC_CLIENT_QUEUE_MAX;
+	client->paused = !more;
+	g_mutex_unlock (&client->lock);
+
+	return more;
+}
+
+/**
+ * Worker pool function, processes the messages queued for a client.
+ */
+static void
+xmms_ipc_client_process_queue (gpointer data, gpointer udata)
+{
+	xmms_ipc_client_t *client = data;
+	xmms_ipc_msg_t *msg;
+	gboolean resume;
+
+	while (TRUE) {
+		resume = FALSE;
+
+		g_mutex_lock (&client->lock);
+		if (g_atomic_int_get (&ipc_workers_stopping)) {
+			msg = NULL;
+		} else {
+			msg = g_queue_pop_head (client->in_msg);
+		}
+		if (!msg) {
+			client->scheduled = FALSE;
+		}
+		if (client->paused && !client->dead && msg &&
+		    g_queue_get_length (client->in_msg) <= XMMS_IPC_CLIENT_QUEUE_RESUME) {
+			client->paused = FALSE;
+			resume = TRUE;
+		}
+		g_mutex_unlock (&client->lock);
+
+		if (resume)
+			xmms_ipc_client_watch (client);
+
+		if (!msg)
+			break;
+
+		process_msg (client, msg);
+		xmms_ipc_msg_destroy (msg);
+	}
+
+	xmms_ipc_client_unref (client);
+}
+
 static gboolean
 xmms_ipc_client_read_cb (GIOChannel *iochan,
                          GIOCondition cond,
@@ -291,8 +412,14 @@ xmms_ipc_client_read_cb (GIOChannel *iochan,
 			if (xmms_ipc_msg_read_transport (client->read_msg, client->transport, &disconnect)) {
 				xmms_ipc_msg_t *msg = client->read_msg;
 				client->read_msg = NULL;
-				process_msg (client, msg);
-				xmms_ipc_msg_destroy (msg);
+				if (client->ml) {
+					process_msg (client, msg);
+					xmms_ipc_msg_destroy (msg);
+				} else if (!xmms_ipc_client_queue_msg (client, msg)) {
+					/* a worker watches the client again once it
+					 * has caught up */
+					return FALSE;
+				}
 			} else {
 				break;
 			}
@@ -305,17 +432,19 @@ xmms_ipc_client_read_cb (GIOChannel *iochan,
 			client->read_msg = NULL;
 		}
 		XMMS_DBG ("disconnect was true!");
-		g_main_loop_quit (client->ml);
-		return FALSE;
+	} else if (cond & G_IO_ERR) {
+		xmms_log_error ("Client got error, maybe connection died?");
+	} else {
+		return TRUE;
 	}
 
-	if (cond & G_IO_ERR) {
-		xmms_log_error ("Client got error, maybe connection died?");
+	if (client->ml) {
 		g_main_loop_quit (client->ml);
-		return FALSE;
+	} else {
+		xmms_ipc_client_disconnect (client);
 	}
 
-	return TRUE;
+	return FALSE;
 }
 
 static gboolean
@@ -356,34 +485,112 @@ xmms_ipc_client_write_cb (GIOChannel *iochan,
 		xmms_ipc_msg_destroy (msg);
 	}
 
+	/* a new source may already have been added for a later message */
+	g_mutex_lock (&client->lock);
+	if (client->write_source == g_main_current_source ()) {
+		g_source_unref (client->write_source);
+		client->write_source = NULL;
+	}
+	g_mutex_unlock (&client->lock);
+
 	return FALSE;
 }
 
-static gpointer
-xmms_ipc_client_thread (gpointer data)
+/**
+ * Watch the client's socket for incoming messages.
+ */
+static void
+xmms_ipc_client_watch (xmms_ipc_client_t *client)
 {
-	xmms_ipc_client_t *client = data;
 	GSource *source;
 
 	source = g_io_create_watch (client->iochan, G_IO_IN | G_IO_ERR | G_IO_HUP);
 	g_source_set_callback (source,
 	                       (GSourceFunc) xmms_ipc_client_read_cb,
-	                       (gpointer) client,
-	                       NULL);
-	g_source_attach (source, g_main_loop_get_context (client->ml));
+	                       xmms_ipc_client_ref (client),
+	                       (GDestroyNotify) xmms_ipc_client_unref);
+	g_source_attach (source, client->context);
 	g_source_unref (source);
+}
+
+/**
+ * Start serving a new client.
+ */
+static void
+xmms_ipc_client_attach (xmms_ipc_client_t *client)
+{
+	xmms_ipc_client_watch (client);
 
 	xmms_object_emit (XMMS_OBJECT (ipc_manager),
 	                  XMMS_IPC_SIGNAL_IPC_MANAGER_CLIENT_CONNECTED,
-	                  xmmsv_new_int(client->id));
+	                  xmmsv_new_int (client->id));
+}
 
-	g_main_loop_run (client->ml);
+/**
+ * Forget a client that has gone away. Replies to messages still
+ * being processed are dropped.
+ */
+static void
+xmms_ipc_client_disconnect (xmms_ipc_client_t *client)
+{
+	GSource *source, *timers[XMMS_IPC_SIGNAL_END];
+	guint i;
+
+	if (client->ipc) {
+		g_mutex_lock (&client->ipc->mutex_lock);
+		client->ipc->clients = g_list_remove (client->ipc->clients, client);
+		g_mutex_unlock (&client->ipc->mutex_lock);
+		client->ipc = NULL;
+	}
+
+	g_mutex_lock (&client->lock);
+	client->dead = TRUE;
+	source = client->write_source;
+	client->write_source = NULL;
+	for (i = 0; i < XMMS_IPC_SIGNAL_END; i++) {
+		timers[i] = client->signaltimer[i];
+		client->signaltimer[i] = NULL;
+	}
+	g_mutex_unlock (&client->lock);
+
+	if (source) {
+		g_source_destroy (source);
+		g_source_unref (source);
+	}
+
+	for (i = 0; i < XMMS_IPC_SIGNAL_END; i++) {
+		if (timers[i]) {
+			g_source_destroy (timers[i]);
+			g_source_unref (timers[i]);
+		}
+	}
 
 	xmms_object_emit (XMMS_OBJECT (ipc_manager),
 	                  XMMS_IPC_SIGNAL_IPC_MANAGER_CLIENT_DISCONNECTED,
-	                  xmmsv_new_int(client->id));
+	                  xmmsv_new_int (client->id));
+
+	/* drop the reference held by the connection */
+	xmms_ipc_client_unref (client);
+}
+
+static gpointer
+xmms_ipc_client_thread (gpointer data)
+{
+	xmms_ipc_client_t *client = data;
+
+	xmms_ipc_client_attach (client);
+
+	g_main_loop_run (client->ml);
 
-	xmms_ipc_client_destroy (client);
+	xmms_ipc_client_disconnect (client);
+
+	return NULL;
+}
+
+static gpointer
+xmms_ipc_io_thread (gpointer data)
+{
+	g_main_loop_run (ipc_io_loop);
 
 	return NULL;
 }
@@ -392,16 +599,18 @@ static xmms_ipc_client_t *
 xmms_ipc_client_new (xmms_ipc_t *ipc, xmms_ipc_transport_t *transport)
 {
 	xmms_ipc_client_t *client;
-	GMainContext *context;
 	int fd;
 
 	g_return_val_if_fail (transport, NULL);
 
 	client = g_new0 (xmms_ipc_client_t, 1);
 
-	context = g_main_context_new ();
-	client->ml = g_main_loop_new (context, FALSE);
-	g_main_context_unref (context);
+	if (ipc_worker_pool) {
+		client->context = g_main_context_ref (ipc_io_context);
+	} else {
+		client->context = g_main_context_new ();
+		client->ml = g_main_loop_new (client->context, FALSE);
+	}
 
 	fd = xmms_ipc_transport_fd_get (transport);
 	client->iochan = g_io_channel_unix_new (fd);
@@ -416,12 +625,29 @@ xmms_ipc_client_new (xmms_ipc_t *ipc, xmms_ipc_transport_t *transport)
 	client->transport = transport;
 	client->ipc = ipc;
 	client->out_msg = g_queue_new ();
+	client->in_msg = g_queue_new ();
 	g_mutex_init (&client->lock);
 	client->id = next_client_id++;
+	client->ref = 1;
 
 	return client;
 }
 
+static xmms_ipc_client_t *
+xmms_ipc_client_ref (xmms_ipc_client_t *client)
+{
+	g_atomic_int_inc (&client->ref);
+	return client;
+}
+
+static void
+xmms_ipc_client_unref (xmms_ipc_client_t *client)
+{
+	if (g_atomic_int_dec_and_test (&client->ref)) {
+		xmms_ipc_client_destroy (client);
+	}
+}
+
 static void
 xmms_ipc_client_destroy (xmms_ipc_client_t *client)
 {
@@ -429,13 +655,10 @@ xmms_ipc_client_destroy (xmms_ipc_client_t *client)
 
 	XMMS_DBG ("Destroying client!");
 
-	if (client->ipc) {
-		g_mutex_lock (&client->ipc->mutex_lock);
-		client->ipc->clients = g_list_remove (client->ipc->clients, client);
-		g_mutex_unlock (&client->ipc->mutex_lock);
+	if (client->ml) {
+		g_main_loop_unref (client->ml);
 	}
-
-	g_main_loop_unref (client->ml);
+	g_main_context_unref (client->context);
 	g_io_channel_unref (client->iochan);
 
 	xmms_ipc_transport_destroy (client->transport);
@@ -448,8 +671,16 @@ xmms_ipc_client_destroy (xmms_ipc_client_t *client)
 
 	g_queue_free (client->out_msg);
 
+	while (!g_queue_is_empty (client->in_msg)) {
+		xmms_ipc_msg_t *msg = g_queue_pop_head (client->in_msg);
+		xmms_ipc_msg_destroy (msg);
+	}
+
+	g_queue_free (client->in_msg);
+
 	for (i = 0; i < XMMS_IPC_SIGNAL_END; i++) {
 		g_list_free (client->broadcasts[i]);
+		xmms_ipc_signal_rate_clear (&client->signalrate[i]);
 	}
 
 	g_mutex_unlock (&client->lock);
@@ -492,6 +723,8 @@ xmms_ipc_send_broadcast (guint broadcastid, gint32 clientid, xmmsv_t *arg,
 	ret = xmms_ipc_client_broadcast_write (broadcastid, cli, arg);
 	g_mutex_unlock (&cli->lock);
 
+	xmms_ipc_client_unref (cli);
+
 	if (!ret) {
 		xmms_error_set (err, XMMS_ERROR_GENERIC, "failed to write broadcast");
 	}
@@ -518,6 +751,8 @@ xmms_ipc_send_message (gint32 clientid, xmms_ipc_msg_t *msg, xmms_error_t *err)
 	ret = xmms_ipc_client_msg_write (cli, msg);
 	g_mutex_unlock (&cli->lock);
 
+	xmms_ipc_client_unref (cli);
+
 	if (!ret) {
 		xmms_error_set (err, XMMS_ERROR_GENERIC, "failed to write message");
 	}
@@ -526,7 +761,8 @@ xmms_ipc_send_message (gint32 clientid, xmms_ipc_msg_t *msg, xmms_error_t *err)
 }
 
 /**
- * Look up a client based on its id.
+ * Look up a client based on its id. The returned client must be
+ * released with xmms_ipc_client_unref.
  */
 static xmms_ipc_client_t *
 xmms_ipc_lookup_client (gint32 id)
@@ -544,6 +780,7 @@ xmms_ipc_lookup_client (gint32 id)
 			cli = c->data;
 
 			if (cli->id == id) {
+				xmms_ipc_client_ref (cli);
 				g_mutex_unlock (&ipc->mutex_lock);
 				g_mutex_unlock (&ipc_servers_lock);
 				return cli;
@@ -568,22 +805,30 @@ xmms_ipc_client_msg_write (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg)
 	g_return_val_if_fail (client, FALSE);
 	g_return_val_if_fail (msg, FALSE);
 
+	if (client->dead) {
+		xmms_ipc_msg_destroy (msg);
+		return FALSE;
+	}
+
 	queue_empty = g_queue_is_empty (client->out_msg);
 	g_queue_push_tail (client->out_msg, msg);
 
 	/* If there's no write in progress, add a new callback */
 	if (queue_empty) {
-		GMainContext *context = g_main_loop_get_context (client->ml);
 		GSource *source = g_io_create_watch (client->iochan, G_IO_OUT);
 
 		g_source_set_callback (source,
 		                       (GSourceFunc) xmms_ipc_client_write_cb,
-		                       (gpointer) client,
-		                       NULL);
-		g_source_attach (source, context);
-		g_source_unref (source);
+		                       xmms_ipc_client_ref (client),
+		                       (GDestroyNotify) xmms_ipc_client_unref);
+		g_source_attach (source, client->context);
 
-		g_main_context_wakeup (context);
+		if (client->write_source) {
+			g_source_unref (client->write_source);
+		}
+		client->write_source = source;
+
+		g_main_context_wakeup (client->context);
 	}
 
 	return TRUE;
@@ -644,8 +889,13 @@ xmms_ipc_source_accept (GIOChannel *chan, GIOCondition cond, gpointer data)
 	g_mutex_unlock (&ipc->mutex_lock);
 
 	/* Now that the client has been registered in the ipc->clients list
-	 * we may safely start its thread.
+	 * we may safely start serving it.
 	 */
+	if (ipc_worker_pool) {
+		xmms_ipc_client_attach (client);
+		return TRUE;
+	}
+
 	client_thread = g_thread_new ("x2 client", xmms_ipc_client_thread, client);
 	/* let the thread free it's resources once it is finished */
 	g_thread_unref (client_thread);
@@ -704,13 +954,167 @@ xmms_ipc_has_pending (guint signalid)
 	return FALSE;
 }
 
+/**
+ * Offer a new value of a signal to a client that may have asked for
+ * it at a lower rate.
+ *
+ * @returns A reference to arg if it is to be sent now, or NULL if the
+ * interval is not over yet. In that case arg replaces any value held
+ * back before.
+ */
+xmmsv_t *
+xmms_ipc_signal_rate_offer (xmms_ipc_signal_rate_t *rate, xmmsv_t *arg,
+                            gint64 now)
+{
+	if (now - rate->last >= rate->interval) {
+		xmms_ipc_signal_rate_clear (rate);
+		rate->last = now;
+		return xmmsv_ref (arg);
+	}
+
+	xmmsv_ref (arg);
+	if (rate->held) {
+		xmmsv_unref (rate->held);
+	}
+	rate->held = arg;
+
+	return NULL;
+}
+
+/**
+ * Take the value held back by #xmms_ipc_signal_rate_offer, counting
+ * it as delivered at now.
+ *
+ * @returns The held value, owned by the caller, or NULL if none.
+ */
+xmmsv_t *
+xmms_ipc_signal_rate_take (xmms_ipc_signal_rate_t *rate, gint64 now)
+{
+	xmmsv_t *held = rate->held;
+
+	if (held) {
+		rate->held = NULL;
+		rate->last = now;
+	}
+
+	return held;
+}
+
+/**
+ * Drop the value held back, if any.
+ */
+void
+xmms_ipc_signal_rate_clear (xmms_ipc_signal_rate_t *rate)
+{
+	if (rate->held) {
+		xmmsv_unref (rate->held);
+		rate->held = NULL;
+	}
+}
+
+/**
+ * Send a signal to a client, using up its pending cookie.
+ * Should hold cli->lock.
+ */
+static void
+xmms_ipc_client_signal_write (xmms_ipc_client_t *cli, guint signalid,
+                              xmmsv_t *arg)
+{
+	xmms_ipc_msg_t *msg;
+
+	msg = xmms_ipc_msg_new (XMMS_IPC_OBJECT_SIGNAL, XMMS_IPC_COMMAND_SIGNAL);
+	xmms_ipc_msg_set_cookie (msg, cli->pendingsignals[signalid]);
+	xmms_ipc_handle_cmd_value (msg, arg);
+	xmms_ipc_client_msg_write (cli, msg);
+	cli->pendingsignals[signalid] = 0;
+}
+
+typedef struct xmms_ipc_signal_timer_St {
+	xmms_ipc_client_t *client;
+	guint signalid;
+} xmms_ipc_signal_timer_t;
+
+static void
+xmms_ipc_signal_timer_free (gpointer data)
+{
+	xmms_ipc_signal_timer_t *timer = data;
+
+	xmms_ipc_client_unref (timer->client);
+	g_free (timer);
+}
+
+static gboolean
+xmms_ipc_signal_timer_cb (gpointer data)
+{
+	xmms_ipc_signal_timer_t *timer = data;
+	xmms_ipc_client_t *cli = timer->client;
+
+	g_mutex_lock (&cli->lock);
+	if (cli->signaltimer[timer->signalid] == g_main_current_source ()) {
+		g_source_unref (cli->signaltimer[timer->signalid]);
+		cli->signaltimer[timer->signalid] = NULL;
+		xmms_ipc_client_signal_release (cli, timer->signalid, FALSE);
+	}
+	g_mutex_unlock (&cli->lock);
+
+	return FALSE;
+}
+
+/**
+ * Deliver the value held back for a signal once its interval is over.
+ * Should hold cli->lock.
+ *
+ * @param flush Deliver it right away, even if the interval is not over.
+ */
+static void
+xmms_ipc_client_signal_release (xmms_ipc_client_t *cli, guint signalid,
+                                gboolean flush)
+{
+	xmms_ipc_signal_rate_t *rate = &cli->signalrate[signalid];
+	xmms_ipc_signal_timer_t *timer;
+	xmmsv_t *held;
+	gint64 now;
+
+	/* without a pending cookie the value waits for the client to
+	 * restart the signal */
+	if (!rate->held || !cli->pendingsignals[signalid] || cli->dead) {
+		return;
+	}
+
+	now = g_get_monotonic_time ();
+
+	if (!flush && now - rate->last < rate->interval) {
+		if (!cli->signaltimer[signalid]) {
+			timer = g_new0 (xmms_ipc_signal_timer_t, 1);
+			timer->client = xmms_ipc_client_ref (cli);
+			timer->signalid = signalid;
+
+			/* round up so the timer never fires early */
+			cli->signaltimer[signalid] =
+				g_timeout_source_new ((rate->interval - (now - rate->last) + 999) / 1000);
+			g_source_set_callback (cli->signaltimer[signalid],
+			                       xmms_ipc_signal_timer_cb, timer,
+			                       xmms_ipc_signal_timer_free);
+			g_source_attach (cli->signaltimer[signalid], cli->context);
+		}
+		return;
+	}
+
+	held = xmms_ipc_signal_rate_take (rate, now);
+	xmms_ipc_client_signal_write (cli, signalid, held);
+	xmmsv_unref (held);
+}
+
 static void
 xmms_ipc_signal_cb (xmms_object_t *object, xmmsv_t *arg, gpointer userdata)
 {
 	GList *c, *s;
 	guint signalid = GPOINTER_TO_UINT (userdata);
 	xmms_ipc_t *ipc;
-	xmms_ipc_msg_t *msg;
+	xmmsv_t *val;
+	gint64 now;
+
+	now = g_get_monotonic_time ();
 
 	g_mutex_lock (&ipc_servers_lock);
 
@@ -720,12 +1124,17 @@ xmms_ipc_signal_cb (xmms_object_t *object, xmmsv_t *arg, gpointer userdata)
 		for (c = ipc->clients; c; c = g_list_next (c)) {
 			xmms_ipc_client_t *cli = c->data;
 			g_mutex_lock (&cli->lock);
+			/* A client that asked for a lower rate gets the latest
+			 * value once its interval has passed. */
 			if (cli->pendingsignals[signalid]) {
-				msg = xmms_ipc_msg_new (XMMS_IPC_OBJECT_SIGNAL, XMMS_IPC_COMMAND_SIGNAL);
-				xmms_ipc_msg_set_cookie (msg, cli->pendingsignals[signalid]);
-				xmms_ipc_handle_cmd_value (msg, arg);
-				xmms_ipc_client_msg_write (cli, msg);
-				cli->pendingsignals[signalid] = 0;
+				val = xmms_ipc_signal_rate_offer (&cli->signalrate[signalid],
+				                                  arg, now);
+				if (val) {
+					xmms_ipc_client_signal_write (cli, signalid, val);
+					xmmsv_unref (val);
+				} else {
+					xmms_ipc_client_signal_release (cli, signalid, FALSE);
+				}
 			}
 			g_mutex_unlock (&cli->lock);
 		}
@@ -736,6 +1145,33 @@ xmms_ipc_signal_cb (xmms_object_t *object, xmmsv_t *arg, gpointer userdata)
 
 }
 
+/**
+ * Deliver the values of signalid held back for clients that asked for
+ * it at a lower rate, without waiting for their intervals to end.
+ */
+void
+xmms_ipc_signal_flush (guint signalid)
+{
+	GList *c, *s;
+	xmms_ipc_t *ipc;
+
+	g_mutex_lock (&ipc_servers_lock);
+
+	for (s = ipc_servers; s && s->data; s = g_list_next (s)) {
+		ipc = s->data;
+		g_mutex_lock (&ipc->mutex_lock);
+		for (c = ipc->clients; c; c = g_list_next (c)) {
+			xmms_ipc_client_t *cli = c->data;
+			g_mutex_lock (&cli->lock);
+			xmms_ipc_client_signal_release (cli, signalid, TRUE);
+			g_mutex_unlock (&cli->lock);
+		}
+		g_mutex_unlock (&ipc->mutex_lock);
+	}
+
+	g_mutex_unlock (&ipc_servers_lock);
+}
+
 static void
 xmms_ipc_broadcast_cb (xmms_object_t *object, xmmsv_t *arg, gpointer userdata)
 {
@@ -767,6 +1203,50 @@ xmms_ipc_broadcast_cb (xmms_object_t *object, xmmsv_t *arg, gpointer userdata)
 	g_mutex_unlock (&ipc_servers_lock);
 }
 
+/**
+ * Send a broadcast once for each value in a list, but only to the
+ * clients that are not listening to the unless broadcast, which is
+ * expected to carry the same information in a single message.
+ */
+void
+xmms_ipc_broadcast_each (guint broadcastid, xmmsv_t *args, guint unless)
+{
+	GList *c, *s;
+	xmms_ipc_t *ipc;
+	xmms_ipc_msg_t *msg;
+	xmmsv_t *arg;
+	GList *l;
+	gint i;
+
+	g_return_if_fail (broadcastid < XMMS_IPC_SIGNAL_END);
+	g_return_if_fail (unless < XMMS_IPC_SIGNAL_END);
+
+	g_mutex_lock (&ipc_servers_lock);
+
+	for (s = ipc_servers; s && s->data; s = g_list_next (s)) {
+		ipc = s->data;
+		g_mutex_lock (&ipc->mutex_lock);
+		for (c = ipc->clients; c; c = g_list_next (c)) {
+			xmms_ipc_client_t *cli = c->data;
+
+			g_mutex_lock (&cli->lock);
+			if (cli->broadcasts[unless] == NULL) {
+				for (l = cli->broadcasts[broadcastid]; l; l = g_list_next (l)) {
+					for (i = 0; xmmsv_list_get (args, i, &arg); i++) {
+						msg = xmms_ipc_msg_new (XMMS_IPC_OBJECT_SIGNAL, XMMS_IPC_COMMAND_BROADCAST);
+						xmms_ipc_msg_set_cookie (msg, GPOINTER_TO_UINT (l->data));
+						xmms_ipc_handle_cmd_value (msg, arg);
+						xmms_ipc_client_msg_write (cli, msg);
+					}
+				}
+			}
+			g_mutex_unlock (&cli->lock);
+		}
+		g_mutex_unlock (&ipc->mutex_lock);
+	}
+	g_mutex_unlock (&ipc_servers_lock);
+}
+
 /**
  * Get the ipc_manager object.
  */
@@ -907,6 +1387,50 @@ xmms_ipc_shutdown_server (xmms_ipc_t *ipc)
 
 }
 
+/**
+ * Serve all clients from one I/O thread and a pool of workers instead
+ * of a thread per client.
+ */
+static void
+xmms_ipc_start_workers (gint workers)
+{
+	if (ipc_worker_pool || workers < 1)
+		return;
+
+	ipc_io_context = g_main_context_new ();
+	ipc_io_loop = g_main_loop_new (ipc_io_context, FALSE);
+	ipc_io_thread = g_thread_new ("x2 ipc io", xmms_ipc_io_thread, NULL);
+
+	g_atomic_int_set (&ipc_workers_stopping, FALSE);
+	ipc_worker_pool = g_thread_pool_new (xmms_ipc_client_process_queue, NULL,
+	                                     workers, TRUE, NULL);
+
+	XMMS_DBG ("Serving IPC clients with %d workers.", workers);
+}
+
+static void
+xmms_ipc_stop_workers (void)
+{
+	if (!ipc_worker_pool)
+		return;
+
+	/* stop reading first, so that nothing new gets queued */
+	g_main_loop_quit (ipc_io_loop);
+	g_thread_join (ipc_io_thread);
+	ipc_io_thread = NULL;
+
+	/* let the running commands finish, the queued ones are dropped
+	 * and their clients released */
+	g_atomic_int_set (&ipc_workers_stopping, TRUE);
+	g_thread_pool_free (ipc_worker_pool, FALSE, TRUE);
+	ipc_worker_pool = NULL;
+
+	g_main_loop_unref (ipc_io_loop);
+	ipc_io_loop = NULL;
+	g_main_context_unref (ipc_io_context);
+	ipc_io_context = NULL;
+}
+
 /**
  * Disable IPC
  */
@@ -916,6 +1440,8 @@ xmms_ipc_shutdown (void)
 	xmms_ipc_manager_unregister_ipc_commands ();
 	xmms_object_unref (ipc_manager);
 
+	/* the workers may still use the clients */
+	xmms_ipc_stop_workers ();
 	xmms_ipc_close ();
 	g_mutex_clear (&ipc_servers_lock);
 	g_mutex_clear (&ipc_object_pool_lock);
@@ -951,9 +1477,14 @@ xmms_ipc_setup_server (const gchar *path)
 	xmms_ipc_transport_t *transport;
 	xmms_ipc_t *ipc;
 	gchar **split;
+	xmms_config_property_t *cv;
 	gint i = 0, num_init = 0;
 	g_return_val_if_fail (path, FALSE);
 
+	/* 0 keeps the thread per client, takes effect on restart */
+	cv = xmms_config_property_register ("core.ipc_workers", "0", NULL, NULL);
+	xmms_ipc_start_workers (xmms_config_property_get_int (cv));
+
 	split = g_strsplit (path, ";", 0);
 
 	for (i = 0; split && split[i]; i++) {
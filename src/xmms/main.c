@@ -45,6 +45,8 @@
 #include <xmmspriv/xmms_ipc.h>
 #include <xmmspriv/xmms_log.h>
 #include <xmmspriv/xmms_xform_object.h>
+#include <xmmspriv/xmms_xform.h>
+#include <xmmspriv/xmms_xform_plugin.h>
 #include <xmmspriv/xmms_bindata.h>
 #include <xmmspriv/xmms_utils.h>
 #include <xmmspriv/xmms_visualization.h>
@@ -62,6 +64,7 @@
  */
 static void xmms_main_client_quit (xmms_object_t *object, xmms_error_t *error);
 static xmmsv_t *xmms_main_client_stats (xmms_object_t *object, xmms_error_t *error);
+static xmmsv_t *xmms_main_client_profile (xmms_object_t *object, xmms_error_t *error);
 static xmmsv_t *xmms_main_client_list_plugins (xmms_object_t *main, gint32 type, xmms_error_t *err);
 static gint64 xmms_main_client_hello (xmms_object_t *object, gint protocolver, const gchar *client, gint64 id, xmms_error_t *error);
 static void install_scripts (const gchar *into_dir);
@@ -100,6 +103,8 @@ struct xmms_main_St {
 	xmms_visualization_t *visualization_object;
 	xmms_courier_t *courier_object;
 	time_t starttime;
+	/** timeout emitting the profile broadcast, see core.profile_interval */
+	guint profile_source;
 };
 
 typedef struct xmms_main_St xmms_main_t;
@@ -217,20 +222,78 @@ xmms_main_client_stats (xmms_object_t *object, xmms_error_t *error)
 	xmms_main_t *mainobj = (xmms_main_t *) object;
 	gint uptime = time (NULL) - mainobj->starttime;
 	int64_t size, duration, playtime;
+	guint64 filler_reads, xform_reads, xform_plugin_reads;
+	guint chunk_size, vis_frames, vis_frames_dropped;
 
 	size = duration = playtime = 0;
 
 	query_total_playtime (mainobj, error, &playtime);
 	query_total_size_duration (mainobj, error, &size, &duration);
 
+	xmms_output_read_stats_get (mainobj->output_object, &filler_reads,
+	                            &xform_reads, &xform_plugin_reads,
+	                            &chunk_size);
+
+	xmms_visualization_stats_get (mainobj->visualization_object,
+	                              &vis_frames, &vis_frames_dropped);
+
 	return xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("version", XMMS_VERSION),
 	                         XMMSV_DICT_ENTRY_INT ("uptime", uptime),
 	                         XMMSV_DICT_ENTRY_INT ("size", size),
 	                         XMMSV_DICT_ENTRY_INT ("duration", duration),
 	                         XMMSV_DICT_ENTRY_INT ("playtime", playtime),
+	                         XMMSV_DICT_ENTRY_INT ("filler_reads", filler_reads),
+	                         XMMSV_DICT_ENTRY_INT ("xform_reads", xform_reads),
+	                         XMMSV_DICT_ENTRY_INT ("xform_plugin_reads", xform_plugin_reads),
+	                         XMMSV_DICT_ENTRY_INT ("filler_chunk_size", chunk_size),
+	                         XMMSV_DICT_ENTRY_INT ("vis_frames", vis_frames),
+	                         XMMSV_DICT_ENTRY_INT ("vis_frames_dropped", vis_frames_dropped),
+	                         XMMSV_DICT_ENTRY ("effects", xmms_xform_plugin_process_stats ()),
 	                         XMMSV_DICT_END);
 }
 
+/**
+ * This returns the profiling counters of the playback pipeline
+ */
+static xmmsv_t *
+xmms_main_client_profile (xmms_object_t *object, xmms_error_t *error)
+{
+	xmms_main_t *mainobj = (xmms_main_t *) object;
+
+	return xmms_output_profile_get (mainobj->output_object);
+}
+
+static gboolean
+emit_profile (gpointer data)
+{
+	xmms_main_t *mainobj = (xmms_main_t *) data;
+
+	xmms_object_emit (XMMS_OBJECT (mainobj),
+	                  XMMS_IPC_SIGNAL_MAIN_PROFILE,
+	                  xmms_output_profile_get (mainobj->output_object));
+
+	return TRUE;
+}
+
+static void
+change_profile_interval (xmms_object_t *object, xmmsv_t *_data, gpointer userdata)
+{
+	xmms_main_t *mainobj = (xmms_main_t *) userdata;
+	gint interval;
+
+	interval = xmms_config_property_get_int ((xmms_config_property_t *) object);
+
+	if (mainobj->profile_source) {
+		g_source_remove (mainobj->profile_source);
+		mainobj->profile_source = 0;
+	}
+
+	if (interval > 0) {
+		mainobj->profile_source = g_timeout_add_seconds (interval, emit_profile,
+		                                                 mainobj);
+	}
+}
+
 static gboolean
 xmms_main_client_list_foreach (xmms_plugin_t *plugin, gpointer data)
 {
@@ -384,6 +447,12 @@ xmms_main_destroy (xmms_object_t *object)
 	cv = xmms_config_lookup ("core.shutdownpath");
 	do_scriptdir (xmms_config_property_get_string (cv), "stop");
 
+	cv = xmms_config_lookup ("core.profile_interval");
+	xmms_config_property_callback_remove (cv, change_profile_interval, mainobj);
+	if (mainobj->profile_source) {
+		g_source_remove (mainobj->profile_source);
+	}
+
 	xmms_object_unref (mainobj->xform_object);
 	xmms_object_unref (mainobj->visualization_object);
 	xmms_object_unref (mainobj->output_object);
@@ -703,6 +772,11 @@ main (int argc, char **argv)
 
 	xmms_main_register_ipc_commands (XMMS_OBJECT (mainobj));
 
+	/* seconds between profile broadcasts, 0 to disable them */
+	cv = xmms_config_property_register ("core.profile_interval", "0",
+	                                    change_profile_interval, mainobj);
+	change_profile_interval (XMMS_OBJECT (cv), NULL, mainobj);
+
 	/* Save the time we started in order to count uptime */
 	mainobj->starttime = time (NULL);
 
@@ -26,6 +26,7 @@
 
 #include <xmms/xmms_log.h>
 #include <xmms/xmms_ipc.h>
+#include <xmms/xmms_config.h>
 #include <xmmspriv/xmms_mediainfo.h>
 #include <xmmspriv/xmms_medialib.h>
 #include <xmmspriv/xmms_xform.h>
@@ -40,18 +41,47 @@
   * When a item is added to the playlist the mediainfo reader will
   * start extracting the information from this entry and update it
   * if additional information is found.
+  *
+  * The work is shared by a number of worker threads
+  * (mediainfo.workers) that take unresolved entries from a common
+  * queue, and resolve mediainfo.batch_size of them per medialib
+  * session.
+  *
+  * Unless mediainfo.metadata_only is disabled, the chains are only
+  * set up as far as needed for the metadata, so decoders that follow
+  * a demuxer which already knows everything are never initialised.
   * @{
   */
 
+#define XMMS_MEDIAINFO_MAX_WORKERS 64
+
 struct xmms_mediainfo_reader_St {
 	xmms_object_t object;
 
-	GThread *thread;
+	GThread **threads;
+	guint num_threads;
+	guint batch_size;
+	gboolean metadata_only;
+
+	/** Protects everything below */
 	GMutex mutex;
 	GCond cond;
 
 	gboolean running;
 
+	/** Entries waiting to be resolved */
+	GQueue *queue;
+	/** Entries that are in the queue or being resolved */
+	GHashTable *pending;
+	/** The medialib changed since the queue was last filled */
+	gboolean dirty;
+	/** Set while a worker is filling the queue */
+	gboolean refilling;
+	/** Number of workers that are not idle */
+	guint busy;
+
+	GList *goal_format;
+
 	xmms_medialib_t *medialib;
 };
 
@@ -68,26 +98,56 @@ on_medialib_entry_added (xmms_object_t *object, xmmsv_t *val, gpointer udata)
 }
 
 /**
- * Start the mediainfo reader thread
+ * Start the mediainfo reader threads
  */
 xmms_mediainfo_reader_t *
 xmms_mediainfo_reader_start (xmms_medialib_t *medialib)
 {
 	xmms_mediainfo_reader_t *mrt;
+	xmms_config_property_t *cv;
+	xmms_stream_type_t *f;
+	gint workers, i;
 
 	mrt = xmms_object_new (xmms_mediainfo_reader_t,
 	                       xmms_mediainfo_reader_stop);
 
 	xmms_mediainfo_reader_register_ipc_commands (XMMS_OBJECT (mrt));
 
+	cv = xmms_config_property_register ("mediainfo.workers", "1", NULL, NULL);
+	workers = CLAMP (xmms_config_property_get_int (cv), 1,
+	                 XMMS_MEDIAINFO_MAX_WORKERS);
+
+	cv = xmms_config_property_register ("mediainfo.batch_size", "10", NULL, NULL);
+	mrt->batch_size = MAX (1, xmms_config_property_get_int (cv));
+
+	cv = xmms_config_property_register ("mediainfo.metadata_only", "1", NULL, NULL);
+	mrt->metadata_only = !!xmms_config_property_get_int (cv);
+
+	XMMS_DBG ("Starting %d mediainfo workers, %d entries per session",
+	          workers, mrt->batch_size);
+
+	f = _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
+	                           XMMS_STREAM_TYPE_MIMETYPE,
+	                           "audio/pcm",
+	                           XMMS_STREAM_TYPE_END);
+	mrt->goal_format = g_list_prepend (NULL, f);
+
 	g_mutex_init (&mrt->mutex);
 	g_cond_init (&mrt->cond);
+	mrt->queue = g_queue_new ();
+	mrt->pending = g_hash_table_new (g_direct_hash, g_direct_equal);
+	mrt->dirty = TRUE;
 	mrt->running = TRUE;
-	mrt->thread = g_thread_new ("x2 media info", xmms_mediainfo_reader_thread, mrt);
 
 	xmms_object_ref (medialib);
 	mrt->medialib = medialib;
 
+	mrt->num_threads = workers;
+	mrt->threads = g_new0 (GThread *, workers);
+	for (i = 0; i < workers; i++) {
+		mrt->threads[i] = g_thread_new ("x2 media info",
+		                                xmms_mediainfo_reader_thread, mrt);
+	}
 
 	xmms_object_connect (XMMS_OBJECT (mrt->medialib),
 	                     XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_ADDED,
@@ -97,31 +157,43 @@ xmms_mediainfo_reader_start (xmms_medialib_t *medialib)
 	                     XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_CHANGED,
 	                     on_medialib_entry_added, mrt);
 
+	xmms_object_connect (XMMS_OBJECT (mrt->medialib),
+	                     XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED,
+	                     on_medialib_entry_added, mrt);
+
 	return mrt;
 }
 
 /**
-  * Kill the mediainfo reader thread
+  * Kill the mediainfo reader threads
   */
 static void
 xmms_mediainfo_reader_stop (xmms_object_t *o)
 {
 	xmms_mediainfo_reader_t *mir = (xmms_mediainfo_reader_t *) o;
+	guint i;
 
 	XMMS_DBG ("Deactivating mediainfo object.");
 
 	g_mutex_lock (&mir->mutex);
 	mir->running = FALSE;
-	g_cond_signal (&mir->cond);
+	g_cond_broadcast (&mir->cond);
 	g_mutex_unlock (&mir->mutex);
 
 	xmms_mediainfo_reader_unregister_ipc_commands ();
 
-	g_thread_join (mir->thread);
+	for (i = 0; i < mir->num_threads; i++) {
+		g_thread_join (mir->threads[i]);
+	}
+	g_free (mir->threads);
 
 	g_cond_clear (&mir->cond);
 	g_mutex_clear (&mir->mutex);
 
+	xmms_object_disconnect (XMMS_OBJECT (mir->medialib),
+	                        XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED,
+	                        on_medialib_entry_added, mir);
+
 	xmms_object_disconnect (XMMS_OBJECT (mir->medialib),
 	                        XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_CHANGED,
 	                        on_medialib_entry_added, mir);
@@ -130,11 +202,17 @@ xmms_mediainfo_reader_stop (xmms_object_t *o)
 	                        XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_ADDED,
 	                        on_medialib_entry_added, mir);
 
+	g_queue_free (mir->queue);
+	g_hash_table_destroy (mir->pending);
+
+	xmms_object_unref (mir->goal_format->data);
+	g_list_free (mir->goal_format);
+
 	xmms_object_unref (mir->medialib);
 }
 
 /**
- * Wake the reader thread and start process the entries.
+ * Wake the reader threads and start process the entries.
  */
 
 void
@@ -143,95 +221,207 @@ xmms_mediainfo_reader_wakeup (xmms_mediainfo_reader_t *mr)
 	g_return_if_fail (mr);
 
 	g_mutex_lock (&mr->mutex);
-	g_cond_signal (&mr->cond);
+	mr->dirty = TRUE;
+	g_cond_broadcast (&mr->cond);
 	g_mutex_unlock (&mr->mutex);
 }
 
 /** @} */
 
-static gpointer
-xmms_mediainfo_reader_thread (gpointer data)
+/* Called with the mutex held, which is released while querying */
+static void
+xmms_mediainfo_reader_refill (xmms_mediainfo_reader_t *mrt)
 {
-	GList *goal_format;
+	GList *entries, *n;
+
+	mrt->dirty = FALSE;
+	mrt->refilling = TRUE;
+	g_mutex_unlock (&mrt->mutex);
+
+	entries = xmms_medialib_entries_not_resolved_get (mrt->medialib);
+
+	g_mutex_lock (&mrt->mutex);
+	mrt->refilling = FALSE;
+
+	for (n = entries; n; n = g_list_next (n)) {
+		if (!g_hash_table_lookup (mrt->pending, n->data)) {
+			g_hash_table_insert (mrt->pending, n->data, n->data);
+			g_queue_push_tail (mrt->queue, n->data);
+		}
+	}
+	g_list_free (entries);
+
+	/* wake up the others if there is work, or if they were waiting
+	 * for us to finish */
+	g_cond_broadcast (&mrt->cond);
+}
+
+/* Resolve one entry within the session, like the playback chain would */
+static void
+xmms_mediainfo_reader_resolve (xmms_mediainfo_reader_t *mrt,
+                               xmms_medialib_session_t *session,
+                               xmms_medialib_entry_t entry)
+{
+	xmmsc_medialib_entry_status_t prev_status;
+	xmms_xform_t *xform;
 	GTimeVal timeval;
-	xmms_stream_type_t *f;
-	guint num = 0;
 
-	xmms_mediainfo_reader_t *mrt = (xmms_mediainfo_reader_t *) data;
+	prev_status = xmms_medialib_entry_property_get_int (session, entry,
+	                                                    XMMS_MEDIALIB_ENTRY_PROPERTY_STATUS);
+
+	/* may have been resolved or removed since it was queued */
+	if (prev_status != XMMS_MEDIALIB_ENTRY_STATUS_NEW &&
+	    prev_status != XMMS_MEDIALIB_ENTRY_STATUS_REHASH) {
+		return;
+	}
+
+	if (mrt->metadata_only) {
+		xform = xmms_xform_chain_setup_metadata_session (mrt->medialib, session,
+		                                                 entry, mrt->goal_format);
+	} else {
+		xform = xmms_xform_chain_setup_session (mrt->medialib, session, entry,
+		                                        mrt->goal_format, TRUE);
+	}
+
+	if (!xform) {
+		if (prev_status == XMMS_MEDIALIB_ENTRY_STATUS_NEW) {
+			xmms_medialib_entry_remove (session, entry);
+		} else {
+			xmms_medialib_entry_status_set (session, entry,
+			                                XMMS_MEDIALIB_ENTRY_STATUS_NOT_AVAILABLE);
+		}
+	} else {
+		xmms_object_unref (xform);
+		g_get_current_time (&timeval);
+
+		xmms_medialib_entry_property_set_int (session, entry,
+		                                      XMMS_MEDIALIB_ENTRY_PROPERTY_ADDED,
+		                                      timeval.tv_sec);
+	}
+}
 
+static void
+xmms_mediainfo_reader_status (xmms_mediainfo_reader_t *mrt, gint status)
+{
 	xmms_object_emit (XMMS_OBJECT (mrt),
 	                  XMMS_IPC_SIGNAL_MEDIAINFO_READER_STATUS,
-	                  xmmsv_new_int (XMMS_MEDIAINFO_READER_STATUS_RUNNING));
+	                  xmmsv_new_int (status));
+}
 
-	f = _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
-	                           XMMS_STREAM_TYPE_MIMETYPE,
-	                           "audio/pcm",
-	                           XMMS_STREAM_TYPE_END);
-	goal_format = g_list_prepend (NULL, f);
+static gboolean
+xmms_mediainfo_reader_running (xmms_mediainfo_reader_t *mrt)
+{
+	gboolean running;
+
+	g_mutex_lock (&mrt->mutex);
+	running = mrt->running;
+	g_mutex_unlock (&mrt->mutex);
+
+	return running;
+}
+
+/* Signals are emitted with the mutex released, as the handlers may
+ * call back into the reader. */
+static gpointer
+xmms_mediainfo_reader_thread (gpointer data)
+{
+	xmms_mediainfo_reader_t *mrt = (xmms_mediainfo_reader_t *) data;
+	xmms_medialib_session_t *session;
+	xmms_medialib_entry_t entry;
+	GList *batch, *n;
+	guint count;
+	gboolean ok, first;
+
+	g_mutex_lock (&mrt->mutex);
+	first = mrt->busy++ == 0;
+	g_mutex_unlock (&mrt->mutex);
+
+	if (first) {
+		xmms_mediainfo_reader_status (mrt, XMMS_MEDIAINFO_READER_STATUS_RUNNING);
+	}
+
+	g_mutex_lock (&mrt->mutex);
 
 	while (mrt->running) {
-		xmmsc_medialib_entry_status_t prev_status;
-		xmms_medialib_entry_t entry;
-		xmms_medialib_session_t *session;
-		xmms_xform_t *xform;
-
-		session = xmms_medialib_session_begin (mrt->medialib);
-		entry = xmms_medialib_entry_not_resolved_get (session);
-		XMMS_DBG ("got %d as not resolved", entry);
-
-		if (!entry) {
-			xmms_medialib_session_abort (session);
-			xmms_object_emit (XMMS_OBJECT (mrt),
-			                  XMMS_IPC_SIGNAL_MEDIAINFO_READER_STATUS,
-			                  xmmsv_new_int (XMMS_MEDIAINFO_READER_STATUS_IDLE));
-
-			g_mutex_lock (&mrt->mutex);
-			g_cond_wait (&mrt->cond, &mrt->mutex);
-			g_mutex_unlock (&mrt->mutex);
-
-			num = 0;
-
-			xmms_object_emit (XMMS_OBJECT (mrt),
-			                  XMMS_IPC_SIGNAL_MEDIAINFO_READER_STATUS,
-			                  xmmsv_new_int (XMMS_MEDIAINFO_READER_STATUS_RUNNING));
+		if (g_queue_is_empty (mrt->queue) && mrt->dirty && !mrt->refilling) {
+			xmms_mediainfo_reader_refill (mrt);
 			continue;
 		}
 
-		prev_status = xmms_medialib_entry_property_get_int (session, entry,
-		                                                    XMMS_MEDIALIB_ENTRY_PROPERTY_STATUS);
+		if (g_queue_is_empty (mrt->queue)) {
+			/* the last one to run out of work reports idle */
+			if (--mrt->busy == 0) {
+				g_mutex_unlock (&mrt->mutex);
+				xmms_mediainfo_reader_status (mrt, XMMS_MEDIAINFO_READER_STATUS_IDLE);
+				g_mutex_lock (&mrt->mutex);
+			}
 
-		if (num == 0) {
-			xmms_object_emit (XMMS_OBJECT (mrt),
-			                  XMMS_IPC_SIGNAL_MEDIAINFO_READER_UNINDEXED,
-			                  xmmsv_new_int (xmms_medialib_num_not_resolved (session)));
-			num = 10;
-		} else {
-			num--;
+			/* the idle report may have raced with new work */
+			if (g_queue_is_empty (mrt->queue) && !mrt->dirty && mrt->running) {
+				g_cond_wait (&mrt->cond, &mrt->mutex);
+			}
+
+			if (mrt->busy++ == 0) {
+				g_mutex_unlock (&mrt->mutex);
+				xmms_mediainfo_reader_status (mrt, XMMS_MEDIAINFO_READER_STATUS_RUNNING);
+				g_mutex_lock (&mrt->mutex);
+			}
+			continue;
 		}
 
-		xform = xmms_xform_chain_setup_session (mrt->medialib, session, entry,
-		                                        goal_format, TRUE);
-
-		if (!xform) {
-			if (prev_status == XMMS_MEDIALIB_ENTRY_STATUS_NEW) {
-				xmms_medialib_entry_remove (session, entry);
-			} else {
-				xmms_medialib_entry_status_set (session, entry,
-				                                XMMS_MEDIALIB_ENTRY_STATUS_NOT_AVAILABLE);
+		batch = NULL;
+		for (count = 0; count < mrt->batch_size; count++) {
+			if (g_queue_is_empty (mrt->queue)) {
+				break;
 			}
+			batch = g_list_prepend (batch, g_queue_pop_head (mrt->queue));
+		}
+		batch = g_list_reverse (batch);
+
+		g_mutex_unlock (&mrt->mutex);
+
+		XMMS_DBG ("resolving %d entries starting at %d", count,
+		          GPOINTER_TO_INT (batch->data));
+
+		/* announce the whole batch with a single broadcast */
+		if (count > 1) {
+			session = xmms_medialib_session_begin_bulk (mrt->medialib);
 		} else {
-			xmms_object_unref (xform);
-			g_get_current_time (&timeval);
+			session = xmms_medialib_session_begin (mrt->medialib);
+		}
 
-			xmms_medialib_entry_property_set_int (session, entry,
-			                                      XMMS_MEDIALIB_ENTRY_PROPERTY_ADDED,
-			                                      timeval.tv_sec);
+		for (n = batch; n && xmms_mediainfo_reader_running (mrt); n = g_list_next (n)) {
+			entry = GPOINTER_TO_INT (n->data);
+			xmms_mediainfo_reader_resolve (mrt, session, entry);
 		}
-		xmms_medialib_session_commit (session);
+
+		ok = xmms_medialib_session_commit (session);
+
+		/* like before the workers, the number of entries in the
+		 * medialib that are still unresolved, queued or not */
+		xmms_object_emit (XMMS_OBJECT (mrt),
+		                  XMMS_IPC_SIGNAL_MEDIAINFO_READER_UNINDEXED,
+		                  xmmsv_new_int (xmms_medialib_num_not_resolved (mrt->medialib)));
+
+		g_mutex_lock (&mrt->mutex);
+
+		/* the entries are still unresolved, have them picked up again
+		 * by the next refill.
+		 */
+		if (!ok) {
+			XMMS_DBG ("Conflict when committing mediainfo, will retry");
+			mrt->dirty = TRUE;
+		}
+
+		for (n = batch; n; n = g_list_next (n)) {
+			g_hash_table_remove (mrt->pending, n->data);
+		}
+		g_list_free (batch);
 	}
 
-	g_list_free (goal_format);
-	xmms_object_unref (f);
+	mrt->busy--;
+
+	g_mutex_unlock (&mrt->mutex);
 
 	return NULL;
 }
@@ -55,6 +55,7 @@ static void xmms_medialib_client_set_property_string (xmms_medialib_t *medialib,
 static void xmms_medialib_client_set_property_int (xmms_medialib_t *medialib, xmms_medialib_entry_t entry, const gchar *source, const gchar *key, gint32 value, xmms_error_t *error);
 static void xmms_medialib_client_remove_property (xmms_medialib_t *medialib, xmms_medialib_entry_t entry, const gchar *source, const gchar *key, xmms_error_t *error);
 static xmmsv_t *xmms_medialib_client_get_info (xmms_medialib_t *medialib, xmms_medialib_entry_t entry, xmms_error_t *err);
+static xmmsv_t *xmms_medialib_client_get_info_batch (xmms_medialib_t *medialib, xmmsv_t *ids, xmmsv_t *keys, xmmsv_t *sources, xmms_error_t *err);
 static gint32 xmms_medialib_client_get_id (xmms_medialib_t *medialib, const gchar *url, xmms_error_t *error);
 
 static s4_t *xmms_medialib_database_open (const gchar *config_path, const gchar *indices[]);
@@ -80,8 +81,24 @@ struct xmms_medialib_St {
 	xmms_object_t object;
 	s4_t *s4;
 	s4_sourcepref_t *default_sp;
+	/** Number of entries added per session by import_path */
+	gint import_batch_size;
+
+	/** Protects unresolved and unresolved_iters */
+	GMutex unresolved_lock;
+	/** Ids of entries with status NEW or REHASH, in ascending order */
+	GSequence *unresolved;
+	/** Maps those ids to their place in unresolved */
+	GHashTable *unresolved_iters;
+
+	/** The id the next new entry gets, accessed atomically. Sessions
+	    store it in the database as they commit new entries. */
+	gint next_id;
 };
 
+static void xmms_medialib_unresolved_load (xmms_medialib_t *medialib);
+static gint32 xmms_medialib_highest_id (xmms_medialib_session_t *session);
+
 static void
 xmms_medialib_destroy (xmms_object_t *object)
 {
@@ -92,6 +109,10 @@ xmms_medialib_destroy (xmms_object_t *object)
 	s4_sourcepref_unref (mlib->default_sp);
 	s4_close (mlib->s4);
 
+	g_hash_table_destroy (mlib->unresolved_iters);
+	g_sequence_free (mlib->unresolved);
+	g_mutex_clear (&mlib->unresolved_lock);
+
 	xmms_medialib_unregister_ipc_commands ();
 }
 
@@ -106,6 +127,7 @@ xmms_medialib_destroy (xmms_object_t *object)
 xmms_medialib_t *
 xmms_medialib_init (void)
 {
+	xmms_medialib_session_t *session;
 	xmms_config_property_t *cfg;
 	xmms_medialib_t *medialib;
 	const gchar *medialib_path;
@@ -135,6 +157,22 @@ xmms_medialib_init (void)
 	medialib->s4 = xmms_medialib_database_open (medialib_path, indices);
 	medialib->default_sp = s4_sourcepref_create (xmmsv_default_source_pref);
 
+	cfg = xmms_config_property_register ("medialib.import_batch_size", "256",
+	                                     NULL, NULL);
+	medialib->import_batch_size = MAX (1, xmms_config_property_get_int (cfg));
+
+	g_mutex_init (&medialib->unresolved_lock);
+	medialib->unresolved = g_sequence_new (NULL);
+	medialib->unresolved_iters = g_hash_table_new (g_direct_hash, g_direct_equal);
+	xmms_medialib_unresolved_load (medialib);
+
+	/* databases written before the counter was stored only have
+	 * the ids of their entries to go by */
+	session = xmms_medialib_session_begin_ro (medialib);
+	medialib->next_id = MAX (xmms_medialib_session_get_next_id (session),
+	                         xmms_medialib_highest_id (session) + 1);
+	xmms_medialib_session_abort (session);
+
 	return medialib;
 }
 
@@ -520,12 +558,10 @@ highest_id_filter (const s4_val_t *value, s4_condition_t *cond)
 }
 
 /**
- * Return a fresh unused medialib id.
- *
- * The first id starts at 1 as 0 is considered reserved for other use.
+ * Return the highest id in use, or 0 if the medialib is empty.
  */
-static int32_t
-xmms_medialib_get_new_id (xmms_medialib_session_t *session)
+static gint32
+xmms_medialib_highest_id (xmms_medialib_session_t *session)
 {
 	gint32 highest = 0;
 	s4_fetchspec_t *fs;
@@ -545,7 +581,28 @@ xmms_medialib_get_new_id (xmms_medialib_session_t *session)
 	s4_cond_free (cond);
 	s4_fetchspec_free (fs);
 
-	return highest + 1;
+	return highest;
+}
+
+/**
+ * Return a fresh unused medialib id.
+ *
+ * The first id starts at 1 as 0 is considered reserved for other use.
+ * Ids are handed out from a counter, so concurrent sessions can't
+ * collide on an id. The counter is stored in the database when the
+ * session commits, so the id of a removed entry is not given out again
+ * after a restart either.
+ */
+static int32_t
+xmms_medialib_get_new_id (xmms_medialib_session_t *session)
+{
+	xmms_medialib_t *medialib = xmms_medialib_session_get_medialib (session);
+	gint32 id;
+
+	id = g_atomic_int_add (&medialib->next_id, 1);
+	xmms_medialib_session_track_new_id (session, id);
+
+	return id;
 }
 
 
@@ -679,7 +736,13 @@ xmms_medialib_client_rehash (xmms_medialib_t *medialib,
 	xmms_medialib_session_t *session;
 
 	do {
-		session = xmms_medialib_session_begin (medialib);
+		/* rehashing everything changes all entries */
+		if (entry == 0) {
+			session = xmms_medialib_session_begin_bulk (medialib);
+		} else {
+			session = xmms_medialib_session_begin (medialib);
+		}
+
 		if (xmms_medialib_check_id (session, entry)) {
 			xmms_medialib_entry_status_set (session, entry, XMMS_MEDIALIB_ENTRY_STATUS_REHASH);
 		} else if (entry == 0) {
@@ -717,10 +780,10 @@ xmms_medialib_client_rehash (xmms_medialib_t *medialib,
 /**
  * Recursively scan a directory for media files.
  *
- * @return a reverse sorted list of encoded urls
+ * @param urls list the encoded urls of the files are appended to
  */
 static gboolean
-process_dir (xmms_medialib_t *medialib, xmmsv_t *entries,
+process_dir (xmms_medialib_t *medialib, xmmsv_t *urls,
              const gchar *directory, xmms_error_t *error)
 {
 	xmmsv_list_iter_t *it;
@@ -741,19 +804,9 @@ process_dir (xmms_medialib_t *medialib, xmmsv_t *entries,
 		xmmsv_dict_entry_get_int (val, "isdir", &isdir);
 
 		if (isdir == 1) {
-			process_dir (medialib, entries, str, error);
+			process_dir (medialib, urls, str, error);
 		} else {
-			xmms_medialib_session_t *session;
-			xmms_medialib_entry_t entry;
-
-			do {
-				session = xmms_medialib_session_begin (medialib);
-				entry = xmms_medialib_entry_new_encoded (session, str, error);
-			} while (!xmms_medialib_session_commit (session));
-
-			if (entry) {
-				xmmsv_coll_idlist_append (entries, entry);
-			}
+			xmmsv_list_append_string (urls, str);
 		}
 
 		xmmsv_list_iter_remove (it);
@@ -764,6 +817,49 @@ process_dir (xmms_medialib_t *medialib, xmmsv_t *entries,
 	return TRUE;
 }
 
+/**
+ * Add encoded urls to the medialib, import_batch_size of them per
+ * session, so that a big import doesn't pay for a commit and a
+ * broadcast per file.
+ */
+static void
+add_urls (xmms_medialib_t *medialib, xmmsv_t *entries, xmmsv_t *urls,
+          xmms_error_t *error)
+{
+	xmms_medialib_session_t *session;
+	xmms_medialib_entry_t entry;
+	const gchar *str;
+	GArray *ids;
+	gint i, j, end, size;
+
+	ids = g_array_new (FALSE, FALSE, sizeof (xmms_medialib_entry_t));
+	size = xmmsv_list_get_size (urls);
+
+	for (i = 0; i < size; i = end) {
+		end = MIN (i + medialib->import_batch_size, size);
+
+		do {
+			g_array_set_size (ids, 0);
+
+			session = xmms_medialib_session_begin_bulk (medialib);
+			for (j = i; j < end; j++) {
+				xmmsv_list_get_string (urls, j, &str);
+				entry = xmms_medialib_entry_new_encoded (session, str, error);
+				if (entry) {
+					g_array_append_val (ids, entry);
+				}
+			}
+		} while (!xmms_medialib_session_commit (session));
+
+		for (j = 0; j < (gint) ids->len; j++) {
+			entry = g_array_index (ids, xmms_medialib_entry_t, j);
+			xmmsv_coll_idlist_append (entries, entry);
+		}
+	}
+
+	g_array_free (ids, TRUE);
+}
+
 /**
  * Recursively add files under a path to the media library.
  *
@@ -777,14 +873,19 @@ xmmsv_t *
 xmms_medialib_add_recursive (xmms_medialib_t *medialib, const gchar *path,
                              xmms_error_t *error)
 {
-	xmmsv_t *entries;
+	xmmsv_t *entries, *urls;
 
 	entries = xmmsv_new_coll (XMMS_COLLECTION_TYPE_IDLIST);
 
 	g_return_val_if_fail (medialib, entries);
 	g_return_val_if_fail (path, entries);
 
-	process_dir (medialib, entries, path, error);
+	urls = xmmsv_new_list ();
+
+	process_dir (medialib, urls, path, error);
+	add_urls (medialib, entries, urls, error);
+
+	xmmsv_unref (urls);
 
 	return entries;
 }
@@ -937,6 +1038,8 @@ xmms_medialib_tree_add_tuple (xmmsv_t *dict, const char *key,
  *
  * @param session The medialib session to be used for the transaction.
  * @param entry Entry to convert.
+ * @param keys Set of keys to include, or NULL for all.
+ * @param sources Set of sources to include, or NULL for all.
  *
  * @returns Newly allocated tree with newly allocated strings
  * make sure to free them all.
@@ -944,7 +1047,8 @@ xmms_medialib_tree_add_tuple (xmmsv_t *dict, const char *key,
 
 static xmmsv_t *
 xmms_medialib_entry_to_tree (xmms_medialib_session_t *session,
-                             xmms_medialib_entry_t entry)
+                             xmms_medialib_entry_t entry,
+                             GHashTable *keys, GHashTable *sources)
 {
 	s4_resultset_t *set;
 	s4_val_t *song_id;
@@ -968,6 +1072,12 @@ xmms_medialib_entry_to_tree (xmms_medialib_session_t *session,
 			const char *s;
 			gint32 i;
 
+			if ((keys && !g_hash_table_contains (keys, s4_result_get_key (res))) ||
+			    (sources && !g_hash_table_contains (sources, s4_result_get_src (res)))) {
+				res = s4_result_next (res);
+				continue;
+			}
+
 			val = s4_result_get_val (res);
 			if (s4_val_get_str (val, &s)) {
 				v_entry = xmmsv_new_string (s);
@@ -985,9 +1095,12 @@ xmms_medialib_entry_to_tree (xmms_medialib_session_t *session,
 
 	s4_resultset_free (set);
 
-	id = xmmsv_new_int (entry);
-	xmms_medialib_tree_add_tuple (ret, "id", "server", id);
-	xmmsv_unref (id);
+	if ((!keys || g_hash_table_contains (keys, "id")) &&
+	    (!sources || g_hash_table_contains (sources, "server"))) {
+		id = xmmsv_new_int (entry);
+		xmms_medialib_tree_add_tuple (ret, "id", "server", id);
+		xmmsv_unref (id);
+	}
 
 	return ret;
 }
@@ -1003,7 +1116,7 @@ xmms_medialib_client_get_info (xmms_medialib_t *medialib,
 	do {
 		session = xmms_medialib_session_begin_ro (medialib);
 		if (xmms_medialib_check_id (session, entry)) {
-			ret = xmms_medialib_entry_to_tree (session, entry);
+			ret = xmms_medialib_entry_to_tree (session, entry, NULL, NULL);
 		} else {
 			xmms_error_set (err, XMMS_ERROR_NOENT, "No such entry");
 		}
@@ -1012,6 +1125,85 @@ xmms_medialib_client_get_info (xmms_medialib_t *medialib,
 	return ret;
 }
 
+/**
+ * Build a set from a list of strings, NULL if the list is empty.
+ */
+static GHashTable *
+xmms_medialib_string_set_new (xmmsv_t *list)
+{
+	xmmsv_list_iter_t *it;
+	GHashTable *set;
+	const gchar *s;
+
+	if (!xmmsv_list_get_size (list)) {
+		return NULL;
+	}
+
+	set = g_hash_table_new (g_str_hash, g_str_equal);
+
+	xmmsv_get_list_iter (list, &it);
+	while (xmmsv_list_iter_entry_string (it, &s)) {
+		g_hash_table_add (set, (gpointer) s);
+		xmmsv_list_iter_next (it);
+	}
+
+	return set;
+}
+
+/**
+ * Like get_info for a list of entries, in a single read-only session,
+ * optionally restricted to some keys and sources.
+ */
+static xmmsv_t *
+xmms_medialib_client_get_info_batch (xmms_medialib_t *medialib,
+                                     xmmsv_t *ids, xmmsv_t *keys,
+                                     xmmsv_t *sources, xmms_error_t *err)
+{
+	xmms_medialib_session_t *session;
+	xmmsv_list_iter_t *it;
+	GHashTable *keyset, *sourceset;
+	xmmsv_t *ret = NULL;
+	gint32 entry;
+
+	keyset = xmms_medialib_string_set_new (keys);
+	sourceset = xmms_medialib_string_set_new (sources);
+
+	do {
+		if (ret) {
+			xmmsv_unref (ret);
+		}
+		ret = xmmsv_new_list ();
+
+		session = xmms_medialib_session_begin_ro (medialib);
+
+		xmmsv_get_list_iter (ids, &it);
+		while (xmmsv_list_iter_entry_int (it, &entry)) {
+			xmmsv_t *tree;
+
+			if (xmms_medialib_check_id (session, entry)) {
+				tree = xmms_medialib_entry_to_tree (session, entry,
+				                                    keyset, sourceset);
+			} else {
+				tree = xmmsv_new_none ();
+			}
+
+			xmmsv_list_append (ret, tree);
+			xmmsv_unref (tree);
+
+			xmmsv_list_iter_next (it);
+		}
+	} while (!xmms_medialib_session_commit (session));
+
+	if (keyset) {
+		g_hash_table_destroy (keyset);
+	}
+	if (sourceset) {
+		g_hash_table_destroy (sourceset);
+	}
+
+	return ret;
+}
+
 /**
  * Add a entry to the medialib. Calls #xmms_medialib_entry_new and then
  * wakes up the mediainfo_reader in order to resolve the metadata.
@@ -1216,7 +1408,7 @@ xmms_medialib_query_random_id (xmms_medialib_session_t *session,
 
 /**
  * @internal
- * Get the next unresolved entry. Used by the mediainfo reader..
+ * Query the entries with status NEW or REHASH from the database.
  */
 
 static s4_resultset_t *
@@ -1261,34 +1453,157 @@ not_resolved_set (xmms_medialib_session_t *session)
 	return ret;
 }
 
-xmms_medialib_entry_t
-xmms_medialib_entry_not_resolved_get (xmms_medialib_session_t *session)
+static gint
+compare_ids (gconstpointer a, gconstpointer b, gpointer udata)
+{
+	return GPOINTER_TO_INT (a) - GPOINTER_TO_INT (b);
+}
+
+/* Called with unresolved_lock held */
+static void
+xmms_medialib_unresolved_set (xmms_medialib_t *medialib,
+                              xmms_medialib_entry_t entry,
+                              gboolean unresolved)
 {
+	GSequenceIter *iter;
+	gpointer key = GINT_TO_POINTER (entry);
+
+	iter = g_hash_table_lookup (medialib->unresolved_iters, key);
+
+	if (unresolved && iter == NULL) {
+		iter = g_sequence_insert_sorted (medialib->unresolved, key,
+		                                 compare_ids, NULL);
+		g_hash_table_insert (medialib->unresolved_iters, key, iter);
+	} else if (!unresolved && iter != NULL) {
+		g_sequence_remove (iter);
+		g_hash_table_remove (medialib->unresolved_iters, key);
+	}
+}
+
+/**
+ * @internal
+ * Fill the unresolved set from the database, at startup.
+ */
+static void
+xmms_medialib_unresolved_load (xmms_medialib_t *medialib)
+{
+	xmms_medialib_session_t *session;
 	const s4_result_t *res;
 	s4_resultset_t *set;
-	gint32 ret = 0;
+	gint32 id;
+	gint i;
 
+	session = xmms_medialib_session_begin_ro (medialib);
 	set = not_resolved_set (session);
-	res = s4_resultset_get_result (set, 0, 0);
 
-	if (res != NULL) {
-		s4_val_get_int (s4_result_get_val (res), &ret);
+	g_mutex_lock (&medialib->unresolved_lock);
+	for (i = 0; i < s4_resultset_get_rowcount (set); i++) {
+		res = s4_resultset_get_result (set, i, 0);
+		if (res != NULL && s4_val_get_int (s4_result_get_val (res), &id)) {
+			xmms_medialib_unresolved_set (medialib, id, TRUE);
+		}
 	}
+	g_mutex_unlock (&medialib->unresolved_lock);
 
 	s4_resultset_free (set);
+	xmms_medialib_session_abort (session);
+}
+
+/**
+ * @internal
+ * Commit a session's transaction and apply its status changes to the
+ * unresolved set.
+ *
+ * The set stays locked from the commit until the changes are applied,
+ * so concurrent sessions touching the same entries update it in the
+ * order they were committed in.
+ *
+ * @param changes maps entry ids to whether they need resolving now.
+ * @returns the result of the commit, nothing is applied on failure.
+ */
+gboolean
+xmms_medialib_unresolved_commit (xmms_medialib_t *medialib,
+                                 s4_transaction_t *trans,
+                                 GHashTable *changes)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	gboolean ret;
+
+	g_mutex_lock (&medialib->unresolved_lock);
+
+	ret = s4_commit (trans);
+
+	if (ret) {
+		g_hash_table_iter_init (&iter, changes);
+		while (g_hash_table_iter_next (&iter, &key, &value)) {
+			xmms_medialib_unresolved_set (medialib, GPOINTER_TO_INT (key),
+			                              GPOINTER_TO_INT (value));
+		}
+	}
+
+	g_mutex_unlock (&medialib->unresolved_lock);
+
+	return ret;
+}
+
+/**
+ * @internal
+ * Get the next unresolved entry. Used by the mediainfo reader..
+ *
+ * Like the functions below this reflects committed sessions only.
+ */
+xmms_medialib_entry_t
+xmms_medialib_entry_not_resolved_get (xmms_medialib_t *medialib)
+{
+	GSequenceIter *iter;
+	gint32 ret = 0;
+
+	g_mutex_lock (&medialib->unresolved_lock);
+
+	iter = g_sequence_get_begin_iter (medialib->unresolved);
+	if (!g_sequence_iter_is_end (iter)) {
+		ret = GPOINTER_TO_INT (g_sequence_get (iter));
+	}
+
+	g_mutex_unlock (&medialib->unresolved_lock);
+
+	return ret;
+}
+
+/**
+ * Get all entries that still need to be resolved by the mediainfo reader.
+ *
+ * @returns a list of entry ids, in the same order as
+ *          #xmms_medialib_entry_not_resolved_get would return them.
+ */
+GList *
+xmms_medialib_entries_not_resolved_get (xmms_medialib_t *medialib)
+{
+	GSequenceIter *iter;
+	GList *ret = NULL;
+
+	g_mutex_lock (&medialib->unresolved_lock);
+
+	iter = g_sequence_get_end_iter (medialib->unresolved);
+	while (!g_sequence_iter_is_begin (iter)) {
+		iter = g_sequence_iter_prev (iter);
+		ret = g_list_prepend (ret, g_sequence_get (iter));
+	}
+
+	g_mutex_unlock (&medialib->unresolved_lock);
 
 	return ret;
 }
 
 guint
-xmms_medialib_num_not_resolved (xmms_medialib_session_t *session)
+xmms_medialib_num_not_resolved (xmms_medialib_t *medialib)
 {
-	s4_resultset_t *set;
-	gint ret = 0;
+	guint ret;
 
-	set = not_resolved_set (session);
-	ret = s4_resultset_get_rowcount (set);
-	s4_resultset_free (set);
+	g_mutex_lock (&medialib->unresolved_lock);
+	ret = g_hash_table_size (medialib->unresolved_iters);
+	g_mutex_unlock (&medialib->unresolved_lock);
 
 	return ret;
 }
@@ -74,7 +74,8 @@ idlist_filter (const s4_val_t *value, s4_condition_t *cond)
  * Creates a new resultset where the order is the same as in the idlist
  *
  * @param set The resultset to sort. It will be freed by this function
- * @param idlist The idlist to order by
+ * @param idlist The list of ids to order by, or an idlist collection
+ * whose packed ids are used directly
  * @return A new set with the same order as the idlist
  */
 static s4_resultset_t *
@@ -97,10 +98,23 @@ xmms_medialib_result_sort_idlist (s4_resultset_t *set, xmmsv_t *idlist)
 
 	ret = s4_resultset_create (s4_resultset_get_colcount (set));
 
-	for (i = 0; xmmsv_list_get_int (idlist, i, &ival); i++) {
-		row = g_hash_table_lookup (row_table, GINT_TO_POINTER (ival));
-		if (row != NULL) {
-			s4_resultset_add_row (ret, row);
+	if (xmmsv_is_type (idlist, XMMSV_TYPE_COLL)) {
+		const int64_t *ids;
+		gint count;
+
+		count = xmmsv_coll_idlist_get_ids (idlist, &ids);
+		for (i = 0; i < count; i++) {
+			row = g_hash_table_lookup (row_table, GINT_TO_POINTER ((gint32) ids[i]));
+			if (row != NULL) {
+				s4_resultset_add_row (ret, row);
+			}
+		}
+	} else {
+		for (i = 0; xmmsv_list_get_int (idlist, i, &ival); i++) {
+			row = g_hash_table_lookup (row_table, GINT_TO_POINTER (ival));
+			if (row != NULL) {
+				s4_resultset_add_row (ret, row);
+			}
 		}
 	}
 
@@ -430,13 +444,14 @@ idlist_condition (xmms_medialib_session_t *session,
                   xmmsv_t *order)
 {
 	GHashTable *id_table;
-	gint32 i, ival;
-	xmmsv_t *child_order, *idlist;
-
-	idlist = xmmsv_coll_idlist_get (coll);
+	const int64_t *ids;
+	gint32 i, count;
+	xmmsv_t *child_order;
 
+	/* Order by the collection itself rather than xmmsv_coll_idlist_get,
+	 * which would leave a per-id list attached to stored playlists. */
 	child_order = xmmsv_build_dict (XMMSV_DICT_ENTRY_INT ("type", SORT_TYPE_LIST),
-	                                XMMSV_DICT_ENTRY ("list", xmmsv_ref (idlist)),
+	                                XMMSV_DICT_ENTRY ("list", xmmsv_ref (coll)),
 	                                XMMSV_DICT_END);
 
 	xmmsv_list_append (order, child_order);
@@ -444,8 +459,9 @@ idlist_condition (xmms_medialib_session_t *session,
 
 	id_table = g_hash_table_new (NULL, NULL);
 
-	for (i = 0; xmmsv_coll_idlist_get_index (coll, i, &ival); i++) {
-		g_hash_table_insert (id_table, GINT_TO_POINTER (ival), GINT_TO_POINTER (1));
+	count = xmmsv_coll_idlist_get_ids (coll, &ids);
+	for (i = 0; i < count; i++) {
+		g_hash_table_insert (id_table, GINT_TO_POINTER ((gint32) ids[i]), GINT_TO_POINTER (1));
 	}
 
 	return create_idlist_filter (session, id_table);
@@ -15,26 +15,41 @@
  */
 
 #include <xmmspriv/xmms_medialib.h>
+#include <xmmspriv/xmms_ipc.h>
 #include <xmms/xmms_object.h>
 #include <string.h>
 
+/* The reserved entry holding the medialib's own state */
+#define XMMS_MEDIALIB_STATE_KEY "medialib"
+#define XMMS_MEDIALIB_STATE_ENTRY "state"
+#define XMMS_MEDIALIB_STATE_NEXT_ID "next_id"
+
 struct xmms_medialib_session_St {
 	xmms_medialib_t *medialib;
 	s4_transaction_t *trans;
 	GHashTable *added;
 	GHashTable *updated;
 	GHashTable *removed;
+	/** Entries whose status changed, mapped to whether they now need
+	    to be resolved */
+	GHashTable *unresolved;
 	xmmsv_t *vals;
+	gboolean bulk;
+	/** One past the highest id handed out to this session, or 0 */
+	gint32 next_id;
 };
 
 static void xmms_medialib_session_free (xmms_medialib_session_t *session);
 static void xmms_medialib_session_free_full (xmms_medialib_session_t *session);
 
 static GHashTable *xmms_medialib_session_get_table (GHashTable **table);
+static void xmms_medialib_session_track_status (xmms_medialib_session_t *session, xmms_medialib_entry_t entry, const gchar *key, const s4_val_t *value, const gchar *source);
+static void xmms_medialib_session_store_next_id (xmms_medialib_session_t *session);
 
 static void xmms_medialib_entry_send_added (xmms_medialib_t *medialib, xmms_medialib_entry_t entry);
 static void xmms_medialib_entry_send_update (xmms_medialib_t *medialib, xmms_medialib_entry_t entry);
 static void xmms_medialib_entry_send_removed (xmms_medialib_t *medialib, xmms_medialib_entry_t entry);
+static void xmms_medialib_entries_send_changed (xmms_medialib_t *medialib, GHashTable *added, GHashTable *updated);
 
 static xmms_medialib_session_t *
 xmms_medialib_session_begin_internal (xmms_medialib_t *medialib,
@@ -63,6 +78,25 @@ xmms_medialib_session_begin_ro (xmms_medialib_t *medialib)
 	return xmms_medialib_session_begin_internal (medialib, S4_TRANS_READONLY);
 }
 
+/**
+ * Begin a session meant to touch a lot of entries at once.
+ *
+ * On commit the added and changed entries are announced by a single
+ * entries_changed signal instead of one signal per entry. Clients that
+ * don't listen to entries_changed still get the entry_added and
+ * entry_changed broadcasts for each entry.
+ */
+xmms_medialib_session_t *
+xmms_medialib_session_begin_bulk (xmms_medialib_t *medialib)
+{
+	xmms_medialib_session_t *ret;
+
+	ret = xmms_medialib_session_begin_internal (medialib, 0);
+	ret->bulk = TRUE;
+
+	return ret;
+}
+
 void
 xmms_medialib_session_abort (xmms_medialib_session_t *session)
 {
@@ -75,13 +109,27 @@ xmms_medialib_session_commit (xmms_medialib_session_t *session)
 {
 	GHashTableIter iter;
 	gpointer key;
+	gboolean committed;
 
-	if (!s4_commit (session->trans)) {
+	if (session->next_id > 0) {
+		xmms_medialib_session_store_next_id (session);
+	}
+
+	/* status changes must reach the unresolved set in commit order */
+	if (session->unresolved != NULL) {
+		committed = xmms_medialib_unresolved_commit (session->medialib,
+		                                             session->trans,
+		                                             session->unresolved);
+	} else {
+		committed = s4_commit (session->trans);
+	}
+
+	if (!committed) {
 		xmms_medialib_session_free_full (session);
 		return FALSE;
 	}
 
-	if (session->added != NULL) {
+	if (session->added != NULL && !session->bulk) {
 		g_hash_table_iter_init (&iter, session->added);
 
 		while (g_hash_table_iter_next (&iter, &key, NULL)) {
@@ -98,13 +146,18 @@ xmms_medialib_session_commit (xmms_medialib_session_t *session)
 		while (g_hash_table_iter_next (&iter, &key, NULL)) {
 			xmms_medialib_entry_send_removed (session->medialib,
 			                                  GPOINTER_TO_INT (key));
+			if (session->added != NULL)
+				g_hash_table_remove (session->added, key);
 			if (session->updated != NULL)
 				g_hash_table_remove (session->updated, key);
 		}
 	}
 
-
-	if (session->updated != NULL) {
+	if (session->bulk) {
+		xmms_medialib_entries_send_changed (session->medialib,
+		                                    session->added,
+		                                    session->updated);
+	} else if (session->updated != NULL) {
 		g_hash_table_iter_init (&iter, session->updated);
 
 		while (g_hash_table_iter_next (&iter, &key, NULL)) {
@@ -124,6 +177,101 @@ xmms_medialib_session_get_source_preferences (xmms_medialib_session_t *session)
 	return xmms_medialib_get_source_preferences (session->medialib);
 }
 
+xmms_medialib_t *
+xmms_medialib_session_get_medialib (xmms_medialib_session_t *session)
+{
+	return session->medialib;
+}
+
+/**
+ * Remember that the session handed out a new id, so that the id
+ * counter in the database is moved past it on commit.
+ */
+void
+xmms_medialib_session_track_new_id (xmms_medialib_session_t *session,
+                                    gint32 id)
+{
+	session->next_id = MAX (session->next_id, id + 1);
+}
+
+/**
+ * Read the id counter stored in the database.
+ *
+ * The counter is kept on a reserved entry outside of the song_id
+ * namespace, so it never shows up in a query.
+ *
+ * @return The id the next new entry gets, or 0 if it was never stored.
+ */
+gint32
+xmms_medialib_session_get_next_id (xmms_medialib_session_t *session)
+{
+	const gchar *sources[2] = { "server", NULL };
+	const s4_result_t *res;
+	s4_condition_t *cond;
+	s4_fetchspec_t *spec;
+	s4_resultset_t *set;
+	s4_sourcepref_t *sp;
+	s4_val_t *state;
+	gint32 next_id = 0;
+
+	state = s4_val_new_string (XMMS_MEDIALIB_STATE_ENTRY);
+	sp = s4_sourcepref_create (sources);
+
+	cond = s4_cond_new_filter (S4_FILTER_EQUAL, XMMS_MEDIALIB_STATE_KEY, state,
+	                           sp, S4_CMP_BINARY, S4_COND_PARENT);
+
+	spec = s4_fetchspec_create ();
+	s4_fetchspec_add (spec, XMMS_MEDIALIB_STATE_NEXT_ID, sp, S4_FETCH_DATA);
+
+	set = s4_query (session->trans, spec, cond);
+	s4_cond_free (cond);
+	s4_fetchspec_free (spec);
+
+	res = s4_resultset_get_result (set, 0, 0);
+	if (res != NULL) {
+		s4_val_get_int (s4_result_get_val (res), &next_id);
+	}
+
+	s4_resultset_free (set);
+	s4_sourcepref_unref (sp);
+	s4_val_free (state);
+
+	return next_id;
+}
+
+/**
+ * Move the id counter in the database past the ids handed out to the
+ * session, as part of its transaction. Sessions committing in another
+ * order than they got their ids never move it back.
+ */
+static void
+xmms_medialib_session_store_next_id (xmms_medialib_session_t *session)
+{
+	s4_val_t *state, *value;
+	gint32 stored;
+
+	stored = xmms_medialib_session_get_next_id (session);
+	if (stored >= session->next_id) {
+		return;
+	}
+
+	state = s4_val_new_string (XMMS_MEDIALIB_STATE_ENTRY);
+
+	if (stored > 0) {
+		value = s4_val_new_int (stored);
+		s4_del (session->trans, XMMS_MEDIALIB_STATE_KEY, state,
+		        XMMS_MEDIALIB_STATE_NEXT_ID, value, "server");
+		s4_val_free (value);
+	}
+
+	value = s4_val_new_int (session->next_id);
+	s4_add (session->trans, XMMS_MEDIALIB_STATE_KEY, state,
+	        XMMS_MEDIALIB_STATE_NEXT_ID, value, "server");
+	s4_val_free (value);
+
+	s4_val_free (state);
+}
+
 s4_resultset_t *
 xmms_medialib_session_query (xmms_medialib_session_t *session,
                              s4_fetchspec_t *specification,
@@ -178,6 +326,8 @@ xmms_medialib_session_property_set (xmms_medialib_session_t *session,
 
 	s4_val_free (song_id);
 
+	xmms_medialib_session_track_status (session, entry, key, value, source);
+
 	if (strcmp (key, XMMS_MEDIALIB_ENTRY_PROPERTY_URL) == 0) {
 		events = xmms_medialib_session_get_table (&session->added);
 	} else {
@@ -207,6 +357,15 @@ xmms_medialib_session_property_unset (xmms_medialib_session_t *session,
 	                 key, value, source);
 	s4_val_free (song_id);
 
+	/* removing the url or the status takes the entry off the
+	 * unresolved set, whatever the old value */
+	xmms_medialib_session_track_status (session, entry, key, NULL, source);
+	if (strcmp (key, XMMS_MEDIALIB_ENTRY_PROPERTY_URL) == 0) {
+		xmms_medialib_session_track_status (session, entry,
+		                                    XMMS_MEDIALIB_ENTRY_PROPERTY_STATUS,
+		                                    NULL, source);
+	}
+
 	if (strcmp (key, XMMS_MEDIALIB_ENTRY_PROPERTY_URL) == 0) {
 		events = xmms_medialib_session_get_table (&session->removed);
 	} else {
@@ -220,6 +379,35 @@ xmms_medialib_session_property_unset (xmms_medialib_session_t *session,
 	return result;
 }
 
+/**
+ * Remember status changes made by the session, to be applied to the
+ * medialib's unresolved set once the session is committed. A NULL
+ * value means the status was removed.
+ */
+static void
+xmms_medialib_session_track_status (xmms_medialib_session_t *session,
+                                    xmms_medialib_entry_t entry,
+                                    const gchar *key, const s4_val_t *value,
+                                    const gchar *source)
+{
+	GHashTable *changes;
+	gint32 status = -1;
+
+	if (strcmp (key, XMMS_MEDIALIB_ENTRY_PROPERTY_STATUS) != 0 ||
+	    strcmp (source, "server") != 0) {
+		return;
+	}
+
+	if (value != NULL) {
+		s4_val_get_int (value, &status);
+	}
+
+	changes = xmms_medialib_session_get_table (&session->unresolved);
+	g_hash_table_insert (changes, GINT_TO_POINTER (entry),
+	                     GINT_TO_POINTER (status == XMMS_MEDIALIB_ENTRY_STATUS_NEW ||
+	                                      status == XMMS_MEDIALIB_ENTRY_STATUS_REHASH));
+}
+
 void
 xmms_medialib_session_track_garbage (xmms_medialib_session_t *session,
                                      xmmsv_t *data)
@@ -254,6 +442,8 @@ xmms_medialib_session_free (xmms_medialib_session_t *session)
 		g_hash_table_unref (session->updated);
 	if (session->removed != NULL)
 		g_hash_table_unref (session->removed);
+	if (session->unresolved != NULL)
+		g_hash_table_unref (session->unresolved);
 	if (session->vals != NULL)
 		xmmsv_unref (session->vals);
 
@@ -311,3 +501,57 @@ xmms_medialib_entry_send_removed (xmms_medialib_t *medialib, xmms_medialib_entry
 	                  XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_REMOVED,
 	                  xmmsv_new_int (entry));
 }
+
+/**
+ * Trigger a single entries_changed signal for all the entries added
+ * and updated by a bulk session. Clients that only listen to the per
+ * entry broadcasts get those instead.
+ *
+ * @param added Entries to signal an add for, or NULL.
+ * @param updated Entries to signal an update for, or NULL.
+ */
+static void
+xmms_medialib_entries_send_changed (xmms_medialib_t *medialib,
+                                    GHashTable *added, GHashTable *updated)
+{
+	GHashTableIter iter;
+	xmmsv_t *added_list, *changed_list;
+	gpointer key;
+
+	added_list = xmmsv_new_list ();
+	if (added != NULL) {
+		g_hash_table_iter_init (&iter, added);
+		while (g_hash_table_iter_next (&iter, &key, NULL)) {
+			xmmsv_list_append_int (added_list, GPOINTER_TO_INT (key));
+		}
+	}
+
+	changed_list = xmmsv_new_list ();
+	if (updated != NULL) {
+		g_hash_table_iter_init (&iter, updated);
+		while (g_hash_table_iter_next (&iter, &key, NULL)) {
+			if (added != NULL && g_hash_table_contains (added, key))
+				continue;
+			xmmsv_list_append_int (changed_list, GPOINTER_TO_INT (key));
+		}
+	}
+
+	if (xmmsv_list_get_size (added_list) > 0 ||
+	    xmmsv_list_get_size (changed_list) > 0) {
+		xmms_ipc_broadcast_each (XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_ADDED,
+		                         added_list,
+		                         XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED);
+		xmms_ipc_broadcast_each (XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_CHANGED,
+		                         changed_list,
+		                         XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED);
+
+		xmms_object_emit (XMMS_OBJECT (medialib),
+		                  XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED,
+		                  xmmsv_build_dict (XMMSV_DICT_ENTRY ("added", xmmsv_ref (added_list)),
+		                                    XMMSV_DICT_ENTRY ("changed", xmmsv_ref (changed_list)),
+		                                    XMMSV_DICT_END));
+	}
+
+	xmmsv_unref (changed_list);
+	xmmsv_unref (added_list);
+}
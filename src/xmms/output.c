@@ -28,7 +28,10 @@
 #include <xmmspriv/xmms_xform.h>
 #include <xmmspriv/xmms_medialib.h>
 #include <xmmspriv/xmms_outputplugin.h>
+#include <xmmspriv/xmms_converter.h>
+#include <xmmspriv/xmms_streamtype.h>
 #include <xmmspriv/xmms_thread_name.h>
+#include <xmmspriv/xmms_ipc.h>
 #include <xmms/xmms_sample.h>
 #include <xmms/xmms_log.h>
 #include <xmms/xmms_ipc.h>
@@ -36,6 +39,7 @@
 #include <xmms/xmms_config.h>
 
 #define VOLUME_MAX_CHANNELS 128
+#define XMMS_OUTPUT_HISTOGRAM_BUCKETS 8
 
 typedef struct xmms_volume_map_St {
 	const gchar **names;
@@ -77,8 +81,16 @@ static xmmsv_t *xmms_volume_map_to_dict (xmms_volume_map_t *vl);
 static gboolean xmms_output_status_set (xmms_output_t *output, gint status);
 static gboolean set_plugin (xmms_output_t *output, xmms_output_plugin_t *plugin);
 
+static void xmms_output_sinks_init (xmms_output_t *output, const gchar *specs, gint size);
+static void xmms_output_sinks_song_changed (xmms_output_t *output, xmms_stream_type_t *type, gboolean flush);
+static void xmms_output_sinks_seek (xmms_output_t *output);
+static void xmms_output_sinks_write (xmms_output_t *output, guint8 *data, guint len);
+static void xmms_output_sinks_status_set (xmms_output_t *output, gint status);
+static void xmms_output_sink_eos (xmms_output_t *sink);
+
 static void xmms_output_format_list_free_elem (gpointer data, gpointer user_data);
 static void xmms_output_format_list_clear (xmms_output_t *output);
+static GList *xmms_output_format_list_copy (xmms_output_t *output);
 xmms_medialib_entry_t xmms_output_current_id (xmms_output_t *output);
 
 #include "output_ipc.c"
@@ -98,7 +110,15 @@ xmms_medialib_entry_t xmms_output_current_id (xmms_output_t *output);
  *
  * locking order: status_mutex > write_mutex
  *                filler_mutex
- *                playtime_mutex is leaflock.
+ *
+ * played and played_time are written by the output thread only and
+ * read with atomic operations from the others.
+ *
+ * Sinks are outputs of their own, with a plugin and buffer but no
+ * filler. The primary's filler copies everything it decodes into their
+ * buffers, converted to a format their plugin takes, and their plugins
+ * read from there at their own pace. A sink's filler_mutex nests inside
+ * the primary's.
  */
 
 struct xmms_output_St {
@@ -108,9 +128,12 @@ struct xmms_output_St {
 	gpointer plugin_data;
 
 	/* */
-	GMutex playtime_mutex;
-	guint played;
-	guint played_time;
+	gint played;
+	gint played_time;
+	/** Output plugin latency in bytes, and the value of played when it
+	    was last asked for. latency is also read by the filler. */
+	guint latency;
+	guint latency_played;
 	xmms_medialib_entry_t current_entry;
 	guint toskip;
 
@@ -125,6 +148,39 @@ struct xmms_output_St {
 	guint32 filler_seek;
 	gint filler_skip;
 
+	/** How much the filler asks the chain for at a time. Grows while
+	    the chain delivers full reads, see output.chunk_size, up to
+	    half the plugin latency and never beyond half the buffer */
+	guint filler_chunk;
+	guint filler_chunk_min;
+	guint filler_chunk_max;
+
+	/** Reads done by the filler, and by the xforms of finished chains */
+	guint64 filler_reads;
+	guint64 xform_reads;
+	guint64 xform_plugin_reads;
+
+	/** The chain the filler is reading, for profiling */
+	xmms_xform_t *filler_chain;
+
+	/* The chain for the next entry is set up by the preroll thread
+	 * while the current one plays, see output.preroll */
+	GThread *preroll_thread;
+	GMutex preroll_mutex;
+	GCond preroll_cond;
+	gboolean preroll_running;
+	/** Entry to preroll next, and the one being set up right now */
+	xmms_medialib_entry_t preroll_wanted;
+	xmms_medialib_entry_t preroll_pending;
+	/** The finished chain, and what the first read on it returned */
+	xmms_medialib_entry_t preroll_entry;
+	xmms_xform_t *preroll_chain;
+	guint8 *preroll_data;
+	gint preroll_len;
+	/** Bumped when the output plugin, and with it the formats the
+	    chain must end in, changes */
+	guint preroll_formats;
+
 	/** Internal status, tells which state the
 	    output really is in */
 	GMutex status_mutex;
@@ -149,8 +205,36 @@ struct xmms_output_St {
 	 */
 	gint32 buffer_underruns;
 
+	/**
+	 * Fill level of the buffer at each read by the output plugin, and
+	 * how much of the read was missing on underruns, in eighths.
+	 * Only updated by the thread driving the output plugin.
+	 */
+	guint64 fill_histogram[XMMS_OUTPUT_HISTOGRAM_BUCKETS];
+	guint64 underrun_histogram[XMMS_OUTPUT_HISTOGRAM_BUCKETS];
+
 	GThread *monitor_volume_thread;
 	gboolean monitor_volume_running;
+
+	/** Outputs fed from this one's filler, see output.sinks */
+	GList *sinks;
+
+	/** For a sink: the output whose filler feeds it, and whether that
+	    filler waits for room in the buffer instead of dropping data */
+	xmms_output_t *primary;
+	gboolean sink_block;
+	/** Conversion from the current chain's format, and the frame size
+	    after it; only touched by the primary's filler. 0 while the sink
+	    can't take the current song */
+	xmms_sample_converter_t *sink_converter;
+	guint sink_frame_size;
+	/** Bytes dropped because the sink was too slow */
+	guint64 sink_dropped;
+	/** The converters only take whole frames, the primary keeps the
+	    start of a frame split between two reads here */
+	guint8 *sink_carry;
+	guint sink_carry_len;
+	guint sink_in_frame_size;
 };
 
 /** @} */
@@ -204,6 +288,22 @@ xmms_output_format_list_free_elem (gpointer data, gpointer user_data)
 	xmms_object_unref (f);
 }
 
+/* A copy of the supported formats, taken under status_mutex as the
+ * plugin may be switched from another thread. */
+static GList *
+xmms_output_format_list_copy (xmms_output_t *output)
+{
+	GList *n, *copy = NULL;
+
+	g_mutex_lock (&output->status_mutex);
+	for (n = output->format_list; n; n = g_list_next (n)) {
+		copy = g_list_prepend (copy, xmms_object_ref (n->data));
+	}
+	g_mutex_unlock (&output->status_mutex);
+
+	return g_list_reverse (copy);
+}
+
 static void
 xmms_output_format_list_clear(xmms_output_t *output)
 {
@@ -221,34 +321,40 @@ xmms_output_format_list_clear(xmms_output_t *output)
 static void
 update_playtime (xmms_output_t *output, int advance)
 {
-	guint buffersize = 0;
-
-	g_mutex_lock (&output->playtime_mutex);
-	output->played += advance;
-	g_mutex_unlock (&output->playtime_mutex);
+	guint played, latency, ms, old;
 
-	buffersize = xmms_output_plugin_method_latency_get (output->plugin, output);
-
-	if (output->played < buffersize) {
-		buffersize = output->played;
+	/* only the main output tells clients how far along it is */
+	if (output->primary) {
+		return;
 	}
 
-	g_mutex_lock (&output->playtime_mutex);
+	played = g_atomic_int_add (&output->played, advance) + advance;
 
-	if (output->format) {
-		guint ms = xmms_sample_bytes_to_ms (output->format,
-		                                    output->played - buffersize);
-		if ((ms / 100) != (output->played_time / 100)) {
-			xmms_object_emit (XMMS_OBJECT (output),
-			                  XMMS_IPC_SIGNAL_PLAYBACK_PLAYTIME,
-			                  xmmsv_new_int (ms));
-		}
-		output->played_time = ms;
+	if (!output->format) {
+		return;
+	}
 
+	/* The latency barely moves between two writes, so only ask the
+	 * plugin again once another 100 ms have been played, or when
+	 * played went backwards after a seek or song change. */
+	if (played < output->latency_played ||
+	    played - output->latency_played >= xmms_sample_ms_to_bytes (output->format, 100)) {
+		g_atomic_int_set (&output->latency,
+		                  xmms_output_plugin_method_latency_get (output->plugin, output));
+		output->latency_played = played;
 	}
 
-	g_mutex_unlock (&output->playtime_mutex);
+	latency = MIN (output->latency, played);
+
+	ms = xmms_sample_bytes_to_ms (output->format, played - latency);
+	old = g_atomic_int_get (&output->played_time);
+	g_atomic_int_set (&output->played_time, ms);
 
+	if ((ms / 100) != (old / 100)) {
+		xmms_object_emit (XMMS_OBJECT (output),
+		                  XMMS_IPC_SIGNAL_PLAYBACK_PLAYTIME,
+		                  xmmsv_new_int (ms));
+	}
 }
 
 void
@@ -258,6 +364,10 @@ xmms_output_set_error (xmms_output_t *output, xmms_error_t *error)
 
 	xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
 
+	if (output->primary) {
+		xmms_output_sink_eos (output);
+	}
+
 	if (error) {
 		xmms_log_error ("Output plugin %s reported error, '%s'",
 		                xmms_plugin_shortname_get ((xmms_plugin_t *)output->plugin),
@@ -291,7 +401,7 @@ song_changed (void *data)
 
 	XMMS_DBG ("Running hotspot! Song changed!! %d", entry);
 
-	arg->output->played = 0;
+	g_atomic_int_set (&arg->output->played, 0);
 	arg->output->current_entry = entry;
 
 	type = xmms_xform_outtype_get (arg->chain);
@@ -326,18 +436,297 @@ seek_done (void *data)
 {
 	xmms_output_t *output = (xmms_output_t *)data;
 
-	g_mutex_lock (&output->playtime_mutex);
-	output->played = output->filler_seek * xmms_sample_frame_size_get (output->format);
+	g_atomic_int_set (&output->played,
+	                  output->filler_seek * xmms_sample_frame_size_get (output->format));
 	output->toskip = output->filler_skip * xmms_sample_frame_size_get (output->format);
-	g_mutex_unlock (&output->playtime_mutex);
 
 	xmms_output_flush (output);
 	return TRUE;
 }
 
+typedef struct {
+	xmms_output_t *sink;
+	xmms_stream_type_t *type;
+	gboolean flush;
+} xmms_output_sink_changed_arg_t;
+
+static void
+sink_changed_arg_free (void *data)
+{
+	xmms_output_sink_changed_arg_t *arg = (xmms_output_sink_changed_arg_t *)data;
+	xmms_object_unref (arg->type);
+	g_free (arg);
+}
+
+static gboolean
+sink_changed (void *data)
+{
+	/* executes in the thread driving the sink */
+	xmms_output_sink_changed_arg_t *arg = (xmms_output_sink_changed_arg_t *)data;
+
+	if (!xmms_output_format_set (arg->sink, arg->type)) {
+		xmms_log_error ("Output sink %s refused the format, stopping it",
+		                xmms_plugin_shortname_get ((xmms_plugin_t *) arg->sink->plugin));
+		xmms_output_status_set (arg->sink, XMMS_PLAYBACK_STATUS_STOP);
+		/* sinks use a locking buffer, the reader holds its filler_mutex */
+		xmms_ringbuf_set_eos (arg->sink->filler_buffer, TRUE);
+		return FALSE;
+	}
+
+	if (arg->flush)
+		xmms_output_flush (arg->sink);
+
+	return TRUE;
+}
+
+static gboolean
+sink_seek_done (void *data)
+{
+	xmms_output_flush ((xmms_output_t *)data);
+	return TRUE;
+}
+
+/**
+ * Set up the sinks for the song the filler starts on: pick the format
+ * each sink's plugin takes that is closest to the chain's, and queue
+ * the format change at the current end of their buffers.
+ *
+ * Called by the filler with the filler_mutex held.
+ */
+static void
+xmms_output_sinks_song_changed (xmms_output_t *output, xmms_stream_type_t *type,
+                                gboolean flush)
+{
+	xmms_output_sink_changed_arg_t *arg;
+	xmms_sample_resample_quality_t quality;
+	xmms_stream_type_t *to;
+	GList *n;
+
+	quality = xmms_sample_resample_quality_from_string (
+		xmms_config_property_get_string (xmms_config_lookup ("output.sink_resample_quality")));
+
+	if (output->sinks) {
+		output->sink_in_frame_size = xmms_sample_frame_size_get (type);
+		output->sink_carry = g_realloc (output->sink_carry, output->sink_in_frame_size);
+		output->sink_carry_len = 0;
+	}
+
+	for (n = output->sinks; n; n = g_list_next (n)) {
+		xmms_output_t *sink = n->data;
+
+		if (sink->sink_converter) {
+			xmms_object_unref (sink->sink_converter);
+			sink->sink_converter = NULL;
+		}
+		sink->sink_frame_size = 0;
+
+		to = xmms_stream_type_coerce (type, sink->format_list);
+		if (!to) {
+			xmms_log_error ("Output sink %s can't play this song",
+			                xmms_plugin_shortname_get ((xmms_plugin_t *) sink->plugin));
+			continue;
+		}
+
+		if (!xmms_stream_type_match (type, to)) {
+			sink->sink_converter = xmms_sample_converter_init (type, to, quality);
+			if (!sink->sink_converter) {
+				xmms_log_error ("Could not convert to the format of output sink %s",
+				                xmms_plugin_shortname_get ((xmms_plugin_t *) sink->plugin));
+				xmms_object_unref (to);
+				continue;
+			}
+		}
+
+		sink->sink_frame_size = xmms_sample_frame_size_get (to);
+
+		arg = g_new0 (xmms_output_sink_changed_arg_t, 1);
+		arg->sink = sink;
+		arg->type = to;
+		arg->flush = flush;
+
+		g_mutex_lock (&sink->filler_mutex);
+		xmms_ringbuf_hotspot_set (sink->filler_buffer, sink_changed, sink_changed_arg_free, arg);
+		g_mutex_unlock (&sink->filler_mutex);
+	}
+}
+
+/**
+ * Throw away what the sinks have buffered after the filler seeked.
+ * Called by the filler with the filler_mutex held.
+ */
+static void
+xmms_output_sinks_seek (xmms_output_t *output)
+{
+	GList *n;
+
+	output->sink_carry_len = 0;
+
+	for (n = output->sinks; n; n = g_list_next (n)) {
+		xmms_output_t *sink = n->data;
+
+		if (sink->sink_converter) {
+			xmms_sample_convert_reset (sink->sink_converter);
+		}
+
+		g_mutex_lock (&sink->filler_mutex);
+		xmms_ringbuf_clear (sink->filler_buffer);
+		xmms_ringbuf_hotspot_set (sink->filler_buffer, sink_seek_done, NULL, sink);
+		g_mutex_unlock (&sink->filler_mutex);
+	}
+}
+
+/**
+ * Queue data for a sink according to its policy. A blocking sink
+ * waits for room in the buffer, until the buffer is marked eos; the
+ * others get the whole frames that fit and the rest is counted in
+ * @a dropped.
+ *
+ * @returns the number of bytes queued.
+ */
+guint
+xmms_output_sink_queue (xmms_ringbuf_t *ringbuf, GMutex *mutex, gboolean block,
+                        guint frame_size, gconstpointer data, guint len,
+                        guint64 *dropped)
+{
+	guint avail, ret = 0;
+
+	g_return_val_if_fail (ringbuf, 0);
+	g_return_val_if_fail (mutex, 0);
+	g_return_val_if_fail (frame_size, 0);
+
+	g_mutex_lock (mutex);
+
+	if (block) {
+		ret = xmms_ringbuf_write_wait (ringbuf, data, len, mutex);
+	} else {
+		avail = xmms_ringbuf_bytes_free (ringbuf);
+		if (avail < len) {
+			avail -= avail % frame_size;
+			*dropped += len - avail;
+			len = avail;
+		}
+		if (len) {
+			ret = xmms_ringbuf_write (ringbuf, data, len);
+		}
+	}
+
+	g_mutex_unlock (mutex);
+
+	return ret;
+}
+
+static void
+xmms_output_sink_write (xmms_output_t *sink, guint8 *data, guint len)
+{
+	xmms_sample_t *out;
+	guint outlen;
+	gint status;
+
+	if (!sink->sink_frame_size) {
+		return;
+	}
+
+	g_mutex_lock (&sink->status_mutex);
+	status = sink->status;
+	g_mutex_unlock (&sink->status_mutex);
+
+	if (status == XMMS_PLAYBACK_STATUS_STOP) {
+		return;
+	}
+
+	out = data;
+	outlen = len;
+	if (sink->sink_converter) {
+		xmms_sample_convert (sink->sink_converter, data, len, &out, &outlen);
+		if (!outlen) {
+			return;
+		}
+	}
+
+	xmms_output_sink_queue (sink->filler_buffer, &sink->filler_mutex,
+	                        sink->sink_block, sink->sink_frame_size,
+	                        out, outlen, &sink->sink_dropped);
+}
+
+/**
+ * Hand decoded data to the sinks. A sink that can't keep up either
+ * holds up the filler or loses the frames that don't fit, depending
+ * on its policy in output.sinks.
+ *
+ * Reads from the chain don't have to end on a frame boundary, so a
+ * partial frame at the end is kept back until the next call.
+ *
+ * Called by the filler without the filler_mutex held.
+ */
+static void
+xmms_output_sinks_write (xmms_output_t *output, guint8 *data, guint len)
+{
+	guint frame_size = output->sink_in_frame_size;
+	guint cnt;
+	GList *n;
+
+	if (!frame_size) {
+		return;
+	}
+
+	if (output->sink_carry_len) {
+		cnt = MIN (len, frame_size - output->sink_carry_len);
+		memcpy (output->sink_carry + output->sink_carry_len, data, cnt);
+		output->sink_carry_len += cnt;
+		data += cnt;
+		len -= cnt;
+
+		if (output->sink_carry_len < frame_size) {
+			return;
+		}
+
+		for (n = output->sinks; n; n = g_list_next (n)) {
+			xmms_output_sink_write (n->data, output->sink_carry, frame_size);
+		}
+		output->sink_carry_len = 0;
+	}
+
+	cnt = len - len % frame_size;
+	if (cnt) {
+		for (n = output->sinks; n; n = g_list_next (n)) {
+			xmms_output_sink_write (n->data, data, cnt);
+		}
+	}
+
+	memcpy (output->sink_carry, data + cnt, len - cnt);
+	output->sink_carry_len = len - cnt;
+}
+
+/**
+ * Mark the end of a stopped sink's buffer. This wakes up the filler if
+ * it waits for room in it, and the sink's plugin if it waits for data.
+ */
+static void
+xmms_output_sink_eos (xmms_output_t *sink)
+{
+	g_mutex_lock (&sink->filler_mutex);
+	xmms_ringbuf_set_eos (sink->filler_buffer, TRUE);
+	g_mutex_unlock (&sink->filler_mutex);
+}
+
+static void
+xmms_output_sinks_status_set (xmms_output_t *output, gint status)
+{
+	GList *n;
+
+	for (n = output->sinks; n; n = g_list_next (n)) {
+		xmms_output_status_set (n->data, status);
+		if (status == XMMS_PLAYBACK_STATUS_STOP) {
+			xmms_output_sink_eos (n->data);
+		}
+	}
+}
+
 static void
 xmms_output_filler_state_nolock (xmms_output_t *output, xmms_output_filler_state_t state)
 {
+	GList *n;
+
 	output->filler_state = state;
 	g_cond_signal (&output->filler_state_cond);
 	if (state == FILLER_QUIT || state == FILLER_STOP || state == FILLER_KILL) {
@@ -346,6 +735,19 @@ xmms_output_filler_state_nolock (xmms_output_t *output, xmms_output_filler_state
 	if (state != FILLER_STOP) {
 		xmms_ringbuf_set_eos (output->filler_buffer, FALSE);
 	}
+
+	for (n = output->sinks; n; n = g_list_next (n)) {
+		xmms_output_t *sink = n->data;
+
+		g_mutex_lock (&sink->filler_mutex);
+		if (state == FILLER_QUIT || state == FILLER_STOP || state == FILLER_KILL) {
+			xmms_ringbuf_clear (sink->filler_buffer);
+		}
+		if (state != FILLER_STOP) {
+			xmms_ringbuf_set_eos (sink->filler_buffer, FALSE);
+		}
+		g_mutex_unlock (&sink->filler_mutex);
+	}
 }
 
 static void
@@ -365,14 +767,224 @@ xmms_output_filler_seek_state (xmms_output_t *output, guint32 samples)
 	g_mutex_unlock (&output->filler_mutex);
 }
 
+static void
+xmms_output_filler_chain_release (xmms_output_t *output, xmms_xform_t *chain)
+{
+	guint64 reads, plugin_reads;
+
+	xmms_xform_chain_read_calls (chain, &reads, &plugin_reads);
+	XMMS_DBG ("Chain for entry %d done after %" G_GUINT64_FORMAT " reads (%"
+	          G_GUINT64_FORMAT " by plugins)",
+	          xmms_xform_entry_get (chain), reads, plugin_reads);
+
+	output->xform_reads += reads;
+	output->xform_plugin_reads += plugin_reads;
+
+	if (output->filler_chain == chain) {
+		output->filler_chain = NULL;
+	}
+
+	xmms_object_unref (chain);
+}
+
+static void
+xmms_output_preroll_reset_nolock (xmms_output_t *output)
+{
+	if (output->preroll_chain) {
+		xmms_object_unref (output->preroll_chain);
+		output->preroll_chain = NULL;
+	}
+	g_free (output->preroll_data);
+	output->preroll_data = NULL;
+	output->preroll_len = 0;
+	output->preroll_entry = 0;
+}
+
+/**
+ * Ask the preroll thread to set up the chain for the entry following
+ * the current one, unless that is already done or in progress.
+ */
+static void
+xmms_output_preroll_request (xmms_output_t *output)
+{
+	xmms_medialib_entry_t next;
+
+	if (!output->preroll_thread) {
+		return;
+	}
+
+	next = xmms_playlist_next_entry (output->playlist);
+
+	g_mutex_lock (&output->preroll_mutex);
+	if (next != output->preroll_entry && next != output->preroll_pending) {
+		xmms_output_preroll_reset_nolock (output);
+		output->preroll_wanted = next;
+		g_cond_signal (&output->preroll_cond);
+	}
+	g_mutex_unlock (&output->preroll_mutex);
+}
+
+/**
+ * Drop the prerolled chain after the plugin was switched, it was set up
+ * for the formats of the old one. The entry is prerolled again.
+ */
+static void
+xmms_output_preroll_invalidate (xmms_output_t *output)
+{
+	xmms_medialib_entry_t entry;
+
+	if (!output->preroll_thread) {
+		return;
+	}
+
+	g_mutex_lock (&output->preroll_mutex);
+	entry = output->preroll_entry ? output->preroll_entry : output->preroll_pending;
+	xmms_output_preroll_reset_nolock (output);
+	output->preroll_formats++;
+	if (entry && !output->preroll_wanted) {
+		output->preroll_wanted = entry;
+		g_cond_signal (&output->preroll_cond);
+	}
+	g_mutex_unlock (&output->preroll_mutex);
+}
+
+/**
+ * Take the prerolled chain if it was set up for @a entry.
+ *
+ * @param data the data from the first read on the chain, to be freed
+ * @param len the length of @a data
+ * @returns the chain or NULL if there is none for @a entry.
+ */
+static xmms_xform_t *
+xmms_output_preroll_take (xmms_output_t *output, xmms_medialib_entry_t entry,
+                          guint8 **data, gint *len)
+{
+	xmms_xform_t *chain = NULL;
+
+	if (!output->preroll_thread) {
+		return NULL;
+	}
+
+	g_mutex_lock (&output->preroll_mutex);
+	if (output->preroll_chain && output->preroll_entry == entry) {
+		chain = output->preroll_chain;
+		*data = output->preroll_data;
+		*len = output->preroll_len;
+
+		output->preroll_chain = NULL;
+		output->preroll_data = NULL;
+		output->preroll_len = 0;
+		output->preroll_entry = 0;
+	}
+	g_mutex_unlock (&output->preroll_mutex);
+
+	return chain;
+}
+
+static gpointer
+xmms_output_preroll_thread (gpointer arg)
+{
+	xmms_output_t *output = (xmms_output_t *) arg;
+	xmms_medialib_entry_t entry;
+	xmms_xform_t *chain;
+	xmms_error_t err;
+	GList *formats;
+	guint8 *buf;
+	guint generation;
+	gint len;
+
+	g_mutex_lock (&output->preroll_mutex);
+	while (output->preroll_running) {
+		if (!output->preroll_wanted) {
+			g_cond_wait (&output->preroll_cond, &output->preroll_mutex);
+			continue;
+		}
+
+		entry = output->preroll_wanted;
+		output->preroll_wanted = 0;
+		output->preroll_pending = entry;
+		generation = output->preroll_formats;
+		g_mutex_unlock (&output->preroll_mutex);
+
+		XMMS_DBG ("Prerolling entry %d", entry);
+
+		buf = NULL;
+		len = 0;
+
+		/* the plugin may be switched meanwhile, work on our own copy */
+		formats = xmms_output_format_list_copy (output);
+		chain = xmms_xform_chain_setup (output->medialib, entry, formats, FALSE);
+		g_list_free_full (formats, xmms_object_unref);
+		if (chain) {
+			/* get the decoder going as well, the first read is often
+			 * the expensive one.
+			 */
+			xmms_error_reset (&err);
+			buf = g_malloc (output->filler_chunk_min);
+			len = xmms_xform_this_read (chain, buf, output->filler_chunk_min, &err);
+			if (len <= 0) {
+				xmms_object_unref (chain);
+				chain = NULL;
+				g_free (buf);
+				buf = NULL;
+			}
+		}
+
+		g_mutex_lock (&output->preroll_mutex);
+		output->preroll_pending = 0;
+
+		if (chain && !output->preroll_wanted &&
+		    generation == output->preroll_formats) {
+			xmms_output_preroll_reset_nolock (output);
+			output->preroll_entry = entry;
+			output->preroll_chain = chain;
+			output->preroll_data = buf;
+			output->preroll_len = len;
+		} else if (chain) {
+			/* superseded, or set up for the formats of a plugin
+			 * that was switched away from while we were working on it */
+			xmms_object_unref (chain);
+			g_free (buf);
+		}
+	}
+
+	xmms_output_preroll_reset_nolock (output);
+	g_mutex_unlock (&output->preroll_mutex);
+
+	return NULL;
+}
+
+/*
+ * The largest chunk the filler may ask for. Reading a chunk should not
+ * take longer than playing what the plugin has queued, so chunks are
+ * kept to half its latency. Plugins that don't report a latency are
+ * only bounded by the buffer.
+ */
+static guint
+xmms_output_filler_chunk_max (xmms_output_t *output)
+{
+	guint latency;
+
+	latency = g_atomic_int_get (&output->latency);
+	if (!latency) {
+		return output->filler_chunk_max;
+	}
+
+	return CLAMP (latency / 2, output->filler_chunk_min,
+	              output->filler_chunk_max);
+}
+
 static void *
 xmms_output_filler (void *arg)
 {
 	xmms_output_t *output = (xmms_output_t *)arg;
 	xmms_xform_t *chain = NULL;
 	gboolean last_was_kill = FALSE;
-	char buf[4096];
+	guint8 *buf, *preroll_data;
+	gint preroll_len;
+	guint len, chunk_max;
 	xmms_error_t err;
+	GList *n;
 	gint ret;
 
 	xmms_error_reset (&err);
@@ -381,17 +993,20 @@ xmms_output_filler (void *arg)
 	while (output->filler_state != FILLER_QUIT) {
 		if (output->filler_state == FILLER_STOP) {
 			if (chain) {
-				xmms_object_unref (chain);
+				xmms_output_filler_chain_release (output, chain);
 				chain = NULL;
 			}
 			xmms_ringbuf_set_eos (output->filler_buffer, TRUE);
+			for (n = output->sinks; n; n = g_list_next (n)) {
+				xmms_ringbuf_set_eos (((xmms_output_t *) n->data)->filler_buffer, TRUE);
+			}
 			g_cond_wait (&output->filler_state_cond, &output->filler_mutex);
 			last_was_kill = FALSE;
 			continue;
 		}
 		if (output->filler_state == FILLER_KILL) {
 			if (chain) {
-				xmms_object_unref (chain);
+				xmms_output_filler_chain_release (output, chain);
 				chain = NULL;
 				output->filler_state = FILLER_RUN;
 				last_was_kill = TRUE;
@@ -424,7 +1039,9 @@ xmms_output_filler (void *arg)
 
 				xmms_ringbuf_clear (output->filler_buffer);
 				xmms_ringbuf_hotspot_set (output->filler_buffer, seek_done, NULL, output);
+				xmms_output_sinks_seek (output);
 			}
+			output->filler_chunk = output->filler_chunk_min;
 			output->filler_state = FILLER_RUN;
 		}
 
@@ -442,7 +1059,16 @@ xmms_output_filler (void *arg)
 				continue;
 			}
 
-			chain = xmms_xform_chain_setup (output->medialib, entry, output->format_list, FALSE);
+			preroll_data = NULL;
+			preroll_len = 0;
+
+			chain = xmms_output_preroll_take (output, entry, &preroll_data, &preroll_len);
+			if (chain) {
+				XMMS_DBG ("Using prerolled chain for entry %d", entry);
+			} else {
+				chain = xmms_xform_chain_setup (output->medialib, entry, output->format_list, FALSE);
+			}
+
 			if (!chain) {
 				xmms_medialib_session_t *session;
 
@@ -463,6 +1089,8 @@ xmms_output_filler (void *arg)
 				continue;
 			}
 
+			xmms_output_preroll_request (output);
+
 			hsarg = g_new0 (xmms_output_song_changed_arg_t, 1);
 			hsarg->output = output;
 			hsarg->chain = chain;
@@ -472,37 +1100,93 @@ xmms_output_filler (void *arg)
 			last_was_kill = FALSE;
 
 			g_mutex_lock (&output->filler_mutex);
+			xmms_output_sinks_song_changed (output, xmms_xform_outtype_get (chain),
+			                                hsarg->flush);
 			xmms_ringbuf_hotspot_set (output->filler_buffer, song_changed, song_changed_arg_free, hsarg);
+			output->filler_chunk = output->filler_chunk_min;
+			output->filler_chain = chain;
+
+			if (preroll_len > 0) {
+				gint skip = MIN (preroll_len, output->toskip);
+
+				output->toskip -= skip;
+				if (preroll_len > skip) {
+					xmms_ringbuf_write_wait (output->filler_buffer,
+					                         preroll_data + skip,
+					                         preroll_len - skip,
+					                         &output->filler_mutex);
+					if (output->sinks) {
+						g_mutex_unlock (&output->filler_mutex);
+						xmms_output_sinks_write (output, preroll_data + skip,
+						                         preroll_len - skip);
+						g_mutex_lock (&output->filler_mutex);
+					}
+				}
+			}
+			g_free (preroll_data);
 		}
 
-		xmms_ringbuf_wait_free (output->filler_buffer, sizeof (buf), &output->filler_mutex);
+		xmms_ringbuf_wait_free (output->filler_buffer, output->filler_chunk, &output->filler_mutex);
 
 		if (output->filler_state != FILLER_RUN) {
 			XMMS_DBG ("State changed while waiting...");
 			continue;
 		}
+
+		/* decode straight into the ringbuffer, the commit is dropped
+		 * if someone clears it while we're not holding the lock.
+		 */
+		len = output->filler_chunk;
+		buf = xmms_ringbuf_write_reserve (output->filler_buffer, &len);
+		if (!buf) {
+			continue;
+		}
 		g_mutex_unlock (&output->filler_mutex);
 
-		ret = xmms_xform_this_read (chain, buf, sizeof (buf), &err);
+		ret = xmms_xform_this_read (chain, buf, len, &err);
 
 		g_mutex_lock (&output->filler_mutex);
 
+		output->filler_reads++;
+
+		/* walking the chain costs the same for any size, so ask for more
+		 * while it keeps up, and back off when it returns short reads
+		 * which happens when approaching hotspots in the chain.
+		 */
+		chunk_max = xmms_output_filler_chunk_max (output);
+		if (ret == (gint) len && len == output->filler_chunk) {
+			output->filler_chunk = MIN (output->filler_chunk * 2, chunk_max);
+		} else if (ret > 0 && ret < (gint) len / 2) {
+			output->filler_chunk = MAX (output->filler_chunk / 2,
+			                            output->filler_chunk_min);
+		}
+		output->filler_chunk = MIN (output->filler_chunk, chunk_max);
+
 		if (ret > 0) {
 			gint skip = MIN (ret, output->toskip);
 
 			output->toskip -= skip;
 			if (ret > skip) {
-				xmms_ringbuf_write_wait (output->filler_buffer,
-				                         buf + skip,
-				                         ret - skip,
-				                         &output->filler_mutex);
+				if (skip) {
+					memmove (buf, buf + skip, ret - skip);
+				}
+				xmms_ringbuf_write_commit (output->filler_buffer, ret - skip);
+
+				/* the data stays put until we write again, but if the
+				 * buffers were cleared while we were reading it is stale.
+				 */
+				if (output->sinks && output->filler_state == FILLER_RUN) {
+					g_mutex_unlock (&output->filler_mutex);
+					xmms_output_sinks_write (output, buf, ret - skip);
+					g_mutex_lock (&output->filler_mutex);
+				}
 			}
 		} else {
 			if (ret == -1) {
 				/* print error */
 				xmms_error_reset (&err);
 			}
-			xmms_object_unref (chain);
+			xmms_output_filler_chain_release (output, chain);
 			chain = NULL;
 			if (!xmms_playlist_advance (output->playlist)) {
 				XMMS_DBG ("End of playlist");
@@ -513,13 +1197,42 @@ xmms_output_filler (void *arg)
 	}
 
 	if (chain)
-		xmms_object_unref (chain);
+		xmms_output_filler_chain_release (output, chain);
 
 	g_mutex_unlock (&output->filler_mutex);
 
 	return NULL;
 }
 
+static void
+record_fill (xmms_output_t *output, guint used)
+{
+	guint64 bucket;
+
+	bucket = (guint64) used * XMMS_OUTPUT_HISTOGRAM_BUCKETS /
+	         xmms_ringbuf_size (output->filler_buffer);
+	output->fill_histogram[MIN (bucket, XMMS_OUTPUT_HISTOGRAM_BUCKETS - 1)]++;
+}
+
+static void
+check_underrun (xmms_output_t *output, gint got, gint wanted)
+{
+	gint bucket;
+
+	bucket = (wanted - got) * XMMS_OUTPUT_HISTOGRAM_BUCKETS / wanted;
+	output->underrun_histogram[MIN (bucket, XMMS_OUTPUT_HISTOGRAM_BUCKETS - 1)]++;
+
+	XMMS_DBG ("Underrun %d of %d (%d)", got, wanted, xmms_sample_frame_size_get (output->format));
+
+	if ((got % xmms_sample_frame_size_get (output->format)) != 0) {
+		xmms_log_error ("***********************************");
+		xmms_log_error ("* Read non-multiple of sample size,");
+		xmms_log_error ("*  you probably hear noise now :)");
+		xmms_log_error ("***********************************");
+	}
+	output->buffer_underruns++;
+}
+
 gint
 xmms_output_read (xmms_output_t *output, char *buffer, gint len)
 {
@@ -531,35 +1244,135 @@ xmms_output_read (xmms_output_t *output, char *buffer, gint len)
 	g_return_val_if_fail (output, -1);
 	g_return_val_if_fail (buffer, -1);
 
-	g_mutex_lock (&output->filler_mutex);
-	xmms_ringbuf_wait_used (output->filler_buffer, len, &output->filler_mutex);
-	ret = xmms_ringbuf_read (output->filler_buffer, buffer, len);
-	if (ret == 0 && xmms_ringbuf_iseos (output->filler_buffer)) {
-		xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
+	if (xmms_ringbuf_is_lockfree (output->filler_buffer)) {
+		/* hotspots take the filler_mutex themselves */
+		xmms_ringbuf_wait_used (output->filler_buffer, len, NULL);
+		record_fill (output, xmms_ringbuf_bytes_used (output->filler_buffer));
+		ret = xmms_ringbuf_read (output->filler_buffer, buffer, len);
+		if (ret == 0 && xmms_ringbuf_iseos (output->filler_buffer)) {
+			xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
+			return -1;
+		}
+	} else {
+		g_mutex_lock (&output->filler_mutex);
+		xmms_ringbuf_wait_used (output->filler_buffer, len, &output->filler_mutex);
+		record_fill (output, xmms_ringbuf_bytes_used (output->filler_buffer));
+		ret = xmms_ringbuf_read (output->filler_buffer, buffer, len);
+		if (ret == 0 && xmms_ringbuf_iseos (output->filler_buffer)) {
+			xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
+			g_mutex_unlock (&output->filler_mutex);
+			return -1;
+		}
 		g_mutex_unlock (&output->filler_mutex);
-		return -1;
 	}
-	g_mutex_unlock (&output->filler_mutex);
 
 	update_playtime (output, ret);
 
 	if (ret < len) {
-		XMMS_DBG ("Underrun %d of %d (%d)", ret, len, xmms_sample_frame_size_get (output->format));
+		check_underrun (output, ret, len);
+	}
+
+	output->bytes_written += ret;
+
+	return ret;
+}
+
+/**
+ * Like #xmms_output_read but hands out a pointer into the output buffer
+ * instead of copying the data. Only whole frames that are contiguous in
+ * the buffer are handed out, so this may return 0 while there still is
+ * data to read, use #xmms_output_read in that case.
+ *
+ * The data has to be released with #xmms_output_read_commit before
+ * reading again.
+ *
+ * @returns number of bytes available at @a buffer, or -1 on end of stream.
+ */
+gint
+xmms_output_read_reserve (xmms_output_t *output, gconstpointer *buffer, gint len)
+{
+	gboolean lockfree;
+	guint used, ret;
+	gint frame_size;
+
+	g_return_val_if_fail (output, -1);
+	g_return_val_if_fail (buffer, -1);
+
+	lockfree = xmms_ringbuf_is_lockfree (output->filler_buffer);
+
+	if (!lockfree) {
+		g_mutex_lock (&output->filler_mutex);
+	}
+
+	xmms_ringbuf_wait_used (output->filler_buffer, len,
+	                        lockfree ? NULL : &output->filler_mutex);
+
+	used = xmms_ringbuf_bytes_used (output->filler_buffer);
+	record_fill (output, used);
+	ret = len;
+	*buffer = xmms_ringbuf_read_reserve (output->filler_buffer, &ret);
+
+	if (!*buffer && xmms_ringbuf_iseos (output->filler_buffer)) {
+		xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
+		if (!lockfree) {
+			g_mutex_unlock (&output->filler_mutex);
+		}
+		return -1;
+	}
 
-		if ((ret % xmms_sample_frame_size_get (output->format)) != 0) {
-			xmms_log_error ("***********************************");
-			xmms_log_error ("* Read non-multiple of sample size,");
-			xmms_log_error ("*  you probably hear noise now :)");
-			xmms_log_error ("***********************************");
+	if (*buffer && output->format) {
+		frame_size = xmms_sample_frame_size_get (output->format);
+		ret -= ret % frame_size;
+		if (!ret) {
+			xmms_ringbuf_read_commit (output->filler_buffer, 0);
+			*buffer = NULL;
 		}
-		output->buffer_underruns++;
 	}
 
-	output->bytes_written += ret;
+	if (!lockfree) {
+		g_mutex_unlock (&output->filler_mutex);
+	}
+
+	if (!*buffer) {
+		return 0;
+	}
+
+	if (used < (guint) len) {
+		check_underrun (output, used, len);
+	}
 
 	return ret;
 }
 
+/**
+ * Release data handed out by #xmms_output_read_reserve.
+ *
+ * @param len number of bytes actually consumed.
+ */
+void
+xmms_output_read_commit (xmms_output_t *output, gint len)
+{
+	gboolean lockfree;
+
+	g_return_if_fail (output);
+
+	lockfree = xmms_ringbuf_is_lockfree (output->filler_buffer);
+
+	if (!lockfree) {
+		g_mutex_lock (&output->filler_mutex);
+	}
+
+	xmms_ringbuf_read_commit (output->filler_buffer, len);
+
+	if (!lockfree) {
+		g_mutex_unlock (&output->filler_mutex);
+	}
+
+	update_playtime (output, len);
+
+	output->bytes_written += len;
+}
+
 gint
 xmms_output_bytes_available (xmms_output_t *output)
 {
@@ -580,6 +1393,98 @@ xmms_output_config_lookup (xmms_output_t *output, const gchar *path)
 	return xmms_plugin_config_lookup ((xmms_plugin_t *)output->plugin, path);
 }
 
+/**
+ * Get the read counters of the filler.
+ *
+ * @param filler_reads number of reads the filler did on its chains
+ * @param xform_reads number of reads done by xforms in finished chains
+ * @param xform_plugin_reads how many of those reached the plugins
+ * @param chunk_size current filler chunk size
+ */
+void
+xmms_output_read_stats_get (xmms_output_t *output, guint64 *filler_reads,
+                            guint64 *xform_reads, guint64 *xform_plugin_reads,
+                            guint *chunk_size)
+{
+	g_return_if_fail (output);
+
+	g_mutex_lock (&output->filler_mutex);
+	*filler_reads = output->filler_reads;
+	*xform_reads = output->xform_reads;
+	*xform_plugin_reads = output->xform_plugin_reads;
+	*chunk_size = output->filler_chunk;
+	g_mutex_unlock (&output->filler_mutex);
+}
+
+static xmmsv_t *
+histogram_to_list (const guint64 *histogram)
+{
+	xmmsv_t *list;
+	gint i;
+
+	list = xmmsv_new_list ();
+	for (i = 0; i < XMMS_OUTPUT_HISTOGRAM_BUCKETS; i++) {
+		xmmsv_list_append_int (list, histogram[i]);
+	}
+
+	return list;
+}
+
+/**
+ * Get the profiling counters of the playback pipeline: those of each
+ * xform in the chain being read by the filler, and the fill level and
+ * underrun histograms of the output buffer.
+ */
+xmmsv_t *
+xmms_output_profile_get (xmms_output_t *output)
+{
+	xmmsv_t *chain, *sinks, *dict;
+	guint used;
+	GList *n;
+
+	g_return_val_if_fail (output, NULL);
+
+	sinks = xmmsv_new_list ();
+	for (n = output->sinks; n; n = g_list_next (n)) {
+		xmms_output_t *sink = n->data;
+		guint64 dropped;
+		guint sink_used;
+
+		g_mutex_lock (&sink->filler_mutex);
+		sink_used = xmms_ringbuf_bytes_used (sink->filler_buffer);
+		dropped = sink->sink_dropped;
+		g_mutex_unlock (&sink->filler_mutex);
+
+		dict = xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("plugin", xmms_plugin_shortname_get ((xmms_plugin_t *) sink->plugin)),
+		                         XMMSV_DICT_ENTRY_INT ("buffer_used", sink_used),
+		                         XMMSV_DICT_ENTRY_INT ("dropped", dropped),
+		                         XMMSV_DICT_ENTRY_INT ("underruns", sink->buffer_underruns),
+		                         XMMSV_DICT_ENTRY_INT ("latency", xmms_output_latency (sink)),
+		                         XMMSV_DICT_END);
+		xmmsv_list_append (sinks, dict);
+		xmmsv_unref (dict);
+	}
+
+	/* chains are only released with the filler_mutex held */
+	g_mutex_lock (&output->filler_mutex);
+	used = xmms_ringbuf_bytes_used (output->filler_buffer);
+	if (output->filler_chain) {
+		chain = xmms_xform_chain_profile (output->filler_chain);
+	} else {
+		chain = xmmsv_new_list ();
+	}
+	g_mutex_unlock (&output->filler_mutex);
+
+	return xmmsv_build_dict (XMMSV_DICT_ENTRY ("chain", chain),
+	                         XMMSV_DICT_ENTRY_INT ("buffer_size", xmms_ringbuf_size (output->filler_buffer)),
+	                         XMMSV_DICT_ENTRY_INT ("buffer_used", used),
+	                         XMMSV_DICT_ENTRY ("fill_histogram", histogram_to_list (output->fill_histogram)),
+	                         XMMSV_DICT_ENTRY_INT ("underruns", output->buffer_underruns),
+	                         XMMSV_DICT_ENTRY ("underrun_histogram", histogram_to_list (output->underrun_histogram)),
+	                         XMMSV_DICT_ENTRY ("sinks", sinks),
+	                         XMMSV_DICT_END);
+}
+
 xmms_medialib_entry_t
 xmms_output_current_id (xmms_output_t *output)
 {
@@ -606,12 +1511,10 @@ xmms_playback_client_seek_ms (xmms_output_t *output, gint32 ms, gint32 whence, x
 	g_return_if_fail (output);
 
 	if (whence == XMMS_PLAYBACK_SEEK_CUR) {
-		g_mutex_lock (&output->playtime_mutex);
-		ms += output->played_time;
+		ms += g_atomic_int_get (&output->played_time);
 		if (ms < 0) {
 			ms = 0;
 		}
-		g_mutex_unlock (&output->playtime_mutex);
 	}
 
 	if (output->format) {
@@ -626,12 +1529,10 @@ static void
 xmms_playback_client_seek_samples (xmms_output_t *output, gint32 samples, gint32 whence, xmms_error_t *error)
 {
 	if (whence == XMMS_PLAYBACK_SEEK_CUR) {
-		g_mutex_lock (&output->playtime_mutex);
-		samples += output->played / xmms_sample_frame_size_get (output->format);
+		samples += (guint) g_atomic_int_get (&output->played) / xmms_sample_frame_size_get (output->format);
 		if (samples < 0) {
 			samples = 0;
 		}
-		g_mutex_unlock (&output->playtime_mutex);
 	}
 
 	/* "just" tell filler */
@@ -657,6 +1558,7 @@ xmms_playback_client_stop (xmms_output_t *output, xmms_error_t *err)
 	g_return_if_fail (output);
 
 	xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
+	xmms_output_sinks_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
 
 	xmms_output_filler_state (output, FILLER_STOP);
 }
@@ -774,14 +1676,9 @@ xmms_playback_client_volume_get (xmms_output_t *output, xmms_error_t *error)
 static gint32
 xmms_playback_client_playtime (xmms_output_t *output, xmms_error_t *error)
 {
-	guint32 ret;
 	g_return_val_if_fail (output, 0);
 
-	g_mutex_lock (&output->playtime_mutex);
-	ret = output->played_time;
-	g_mutex_unlock (&output->playtime_mutex);
-
-	return ret;
+	return g_atomic_int_get (&output->played_time);
 }
 
 /* returns the current latency: time left in ms until the data currently read
@@ -840,14 +1737,26 @@ xmms_output_status_set (xmms_output_t *output, gint status)
 				ret = FALSE;
 			}
 
-			xmms_object_emit (XMMS_OBJECT (output),
-			                  XMMS_IPC_SIGNAL_PLAYBACK_STATUS,
-			                  xmmsv_new_int (output->status));
+			if (!output->primary) {
+				/* clients that rate-limit the playtime should see
+				 * where playback was when the status changed */
+				xmms_ipc_signal_flush (XMMS_IPC_SIGNAL_PLAYBACK_PLAYTIME);
+				xmms_object_emit (XMMS_OBJECT (output),
+				                  XMMS_IPC_SIGNAL_PLAYBACK_STATUS,
+				                  xmmsv_new_int (output->status));
+			}
 		}
 	}
 
 	g_mutex_unlock (&output->status_mutex);
 
+	/* sinks stop on their own once they have played what they got,
+	 * unless playback is stopped, see xmms_playback_client_stop.
+	 */
+	if (ret && status != XMMS_PLAYBACK_STATUS_STOP) {
+		xmms_output_sinks_status_set (output, status);
+	}
+
 	return ret;
 }
 
@@ -867,6 +1776,21 @@ xmms_output_destroy (xmms_object_t *object)
 	xmms_output_filler_state (output, FILLER_QUIT);
 	g_thread_join (output->filler_thread);
 
+	g_list_free_full (output->sinks, xmms_object_unref);
+	output->sinks = NULL;
+	g_free (output->sink_carry);
+
+	if (output->preroll_thread) {
+		g_mutex_lock (&output->preroll_mutex);
+		output->preroll_running = FALSE;
+		g_cond_signal (&output->preroll_cond);
+		g_mutex_unlock (&output->preroll_mutex);
+		g_thread_join (output->preroll_thread);
+		output->preroll_thread = NULL;
+	}
+	g_mutex_clear (&output->preroll_mutex);
+	g_cond_clear (&output->preroll_cond);
+
 	if (output->plugin) {
 		xmms_output_plugin_method_destroy (output->plugin, output);
 		xmms_object_unref (output->plugin);
@@ -877,7 +1801,6 @@ xmms_output_destroy (xmms_object_t *object)
 	xmms_object_unref (output->medialib);
 
 	g_mutex_clear (&output->status_mutex);
-	g_mutex_clear (&output->playtime_mutex);
 	g_mutex_clear (&output->filler_mutex);
 	g_cond_clear (&output->filler_state_cond);
 	xmms_ringbuf_destroy (output->filler_buffer);
@@ -885,6 +1808,133 @@ xmms_output_destroy (xmms_object_t *object)
 	xmms_playback_unregister_ipc_commands ();
 }
 
+static gint
+xmms_output_sink_plugin_cmp (gconstpointer a, gconstpointer b)
+{
+	const xmms_output_t *sink = a;
+
+	return sink->plugin == b ? 0 : 1;
+}
+
+static void
+xmms_output_sink_destroy (xmms_object_t *object)
+{
+	xmms_output_t *sink = (xmms_output_t *)object;
+
+	if (sink->plugin) {
+		xmms_output_status_set (sink, XMMS_PLAYBACK_STATUS_STOP);
+		xmms_output_sink_eos (sink);
+		xmms_output_plugin_method_destroy (sink->plugin, sink);
+		xmms_object_unref (sink->plugin);
+	}
+	xmms_output_format_list_clear (sink);
+
+	if (sink->format) {
+		xmms_object_unref (sink->format);
+	}
+	if (sink->sink_converter) {
+		xmms_object_unref (sink->sink_converter);
+	}
+
+	g_mutex_clear (&sink->status_mutex);
+	g_mutex_clear (&sink->filler_mutex);
+	xmms_ringbuf_destroy (sink->filler_buffer);
+}
+
+/**
+ * Create a sink from an output.sinks entry, "plugin" or
+ * "plugin:policy" where the policy is drop (the default) or block.
+ * @a sinks are the ones created so far.
+ */
+static xmms_output_t *
+xmms_output_sink_new (xmms_output_t *output, GList *sinks, const gchar *spec, gint size)
+{
+	xmms_output_plugin_t *plugin;
+	xmms_output_t *sink;
+	gchar **parts;
+	gboolean block = FALSE;
+
+	parts = g_strsplit (spec, ":", 2);
+	g_strstrip (parts[0]);
+
+	if (parts[1]) {
+		g_strstrip (parts[1]);
+		if (g_ascii_strcasecmp (parts[1], "block") == 0) {
+			block = TRUE;
+		} else if (g_ascii_strcasecmp (parts[1], "drop") != 0) {
+			xmms_log_error ("Unknown policy '%s' for output sink %s, dropping data",
+			                parts[1], parts[0]);
+		}
+	}
+
+	plugin = (xmms_output_plugin_t *) xmms_plugin_find (XMMS_PLUGIN_TYPE_OUTPUT, parts[0]);
+	if (!plugin) {
+		xmms_log_error ("No output plugin named %s for output sink", parts[0]);
+		g_strfreev (parts);
+		return NULL;
+	}
+
+	/* the plugin drives a single output */
+	if (plugin == output->plugin ||
+	    g_list_find_custom (sinks, plugin, xmms_output_sink_plugin_cmp)) {
+		xmms_log_error ("Output plugin %s is already in use", parts[0]);
+		xmms_object_unref (plugin);
+		g_strfreev (parts);
+		return NULL;
+	}
+
+	sink = xmms_object_new (xmms_output_t, xmms_output_sink_destroy);
+	sink->primary = output;
+	sink->sink_block = block;
+	sink->status = XMMS_PLAYBACK_STATUS_STOP;
+
+	g_mutex_init (&sink->status_mutex);
+	g_mutex_init (&sink->filler_mutex);
+	sink->filler_buffer = xmms_ringbuf_new (size);
+
+	if (!set_plugin (sink, plugin)) {
+		xmms_log_error ("Could not initialize output sink %s", parts[0]);
+		xmms_object_unref (plugin);
+		xmms_object_unref (sink);
+		g_strfreev (parts);
+		return NULL;
+	}
+
+	XMMS_DBG ("Using output sink %s, %s when full", parts[0],
+	          block ? "blocking" : "dropping");
+
+	g_strfreev (parts);
+
+	return sink;
+}
+
+static void
+xmms_output_sinks_init (xmms_output_t *output, const gchar *specs, gint size)
+{
+	xmms_output_t *sink;
+	GList *sinks = NULL;
+	gchar **list;
+	gint i;
+
+	list = g_strsplit (specs, ",", 0);
+	for (i = 0; list[i]; i++) {
+		if (!*g_strstrip (list[i])) {
+			continue;
+		}
+
+		sink = xmms_output_sink_new (output, sinks, list[i], size);
+		if (sink) {
+			sinks = g_list_append (sinks, sink);
+		}
+	}
+	g_strfreev (list);
+
+	/* the filler is already running, the list doesn't change after this */
+	g_mutex_lock (&output->filler_mutex);
+	output->sinks = sinks;
+	g_mutex_unlock (&output->filler_mutex);
+}
+
 /**
  * Switch to another output plugin.
  * @param output output pointer
@@ -900,6 +1950,12 @@ xmms_output_plugin_switch (xmms_output_t *output, xmms_output_plugin_t *new_plug
 	g_return_val_if_fail (output, FALSE);
 	g_return_val_if_fail (new_plugin, FALSE);
 
+	if (g_list_find_custom (output->sinks, new_plugin, xmms_output_sink_plugin_cmp)) {
+		xmms_log_error ("%s is already used by an output sink",
+		                xmms_plugin_shortname_get ((xmms_plugin_t *) new_plugin));
+		return FALSE;
+	}
+
 	xmms_playback_client_stop (output, NULL);
 
 	g_mutex_lock (&output->status_mutex);
@@ -922,6 +1978,8 @@ xmms_output_plugin_switch (xmms_output_t *output, xmms_output_plugin_t *new_plug
 
 	g_mutex_unlock (&output->status_mutex);
 
+	xmms_output_preroll_invalidate (output);
+
 	return ret;
 }
 
@@ -948,16 +2006,43 @@ xmms_output_new (xmms_output_plugin_t *plugin, xmms_playlist_t *playlist, xmms_m
 	output->medialib = medialib;
 
 	g_mutex_init (&output->status_mutex);
-	g_mutex_init (&output->playtime_mutex);
 
 	prop = xmms_config_property_register ("output.buffersize", "32768", NULL, NULL);
 	size = xmms_config_property_get_int (prop);
 	XMMS_DBG ("Using buffersize %d", size);
 
+	/* the chunk size is bounded by the buffer, we always wait for
+	 * a whole chunk to be free before reading. Below that it follows
+	 * the plugin latency, see xmms_output_filler_chunk_max.
+	 */
+	prop = xmms_config_property_register ("output.chunk_size", "4096", NULL, NULL);
+	output->filler_chunk_min = MIN (MAX (xmms_config_property_get_int (prop), 256), size / 2);
+	output->filler_chunk_max = size / 2;
+	output->filler_chunk = output->filler_chunk_min;
+	XMMS_DBG ("Using filler chunk size %d-%d", output->filler_chunk_min,
+	          output->filler_chunk_max);
+
 	g_mutex_init (&output->filler_mutex);
 	output->filler_state = FILLER_STOP;
 	g_cond_init (&output->filler_state_cond);
-	output->filler_buffer = xmms_ringbuf_new (size);
+
+	prop = xmms_config_property_register ("output.lockfree_buffer", "0", NULL, NULL);
+	if (xmms_config_property_get_int (prop)) {
+		XMMS_DBG ("Using lock-free output buffer");
+		output->filler_buffer = xmms_ringbuf_new_lockfree (size, &output->filler_mutex);
+	} else {
+		output->filler_buffer = xmms_ringbuf_new (size);
+	}
+
+	g_mutex_init (&output->preroll_mutex);
+	g_cond_init (&output->preroll_cond);
+
+	prop = xmms_config_property_register ("output.preroll", "0", NULL, NULL);
+	if (xmms_config_property_get_int (prop)) {
+		output->preroll_running = TRUE;
+		output->preroll_thread = g_thread_new ("x2 out preroll", xmms_output_preroll_thread, output);
+	}
+
 	output->filler_thread = g_thread_new ("x2 out filler", xmms_output_filler, output);
 
 	xmms_config_property_register ("output.flush_on_pause", "1", NULL, NULL);
@@ -974,7 +2059,12 @@ xmms_output_new (xmms_output_plugin_t *plugin, xmms_playlist_t *playlist, xmms_m
 		xmms_log_error ("initalized output without a plugin, please fix!");
 	}
 
-
+	/* more output plugins to play the same stream on, each with its
+	 * own buffer, e.g. "diskwrite:block,ices:drop"
+	 */
+	xmms_config_property_register ("output.sink_resample_quality", "medium", NULL, NULL);
+	prop = xmms_config_property_register ("output.sinks", "", NULL, NULL);
+	xmms_output_sinks_init (output, xmms_config_property_get_string (prop), size);
 
 	return output;
 }
@@ -1060,7 +2150,7 @@ set_plugin (xmms_output_t *output, xmms_output_plugin_t *plugin)
 
 	if (!ret) {
 		output->plugin = NULL;
-	} else if (!output->monitor_volume_thread) {
+	} else if (!output->monitor_volume_thread && !output->primary) {
 		output->monitor_volume_running = TRUE;
 		output->monitor_volume_thread = g_thread_new ("x2 volume mon",
 		                                              xmms_output_monitor_volume_thread,
@@ -15,6 +15,7 @@
  */
 
 #include <xmmspriv/xmms_outputplugin.h>
+#include <xmmspriv/xmms_output.h>
 #include <xmmspriv/xmms_plugin.h>
 #include <xmmspriv/xmms_thread_name.h>
 #include <xmms/xmms_log.h>
@@ -388,6 +389,7 @@ xmms_output_plugin_writer (gpointer data)
 	xmms_output_plugin_t *plugin = (xmms_output_plugin_t *) data;
 	xmms_output_t *output = NULL;
 	gchar buffer[4096];
+	gconstpointer chunk;
 	gint ret;
 
 	g_mutex_lock (&plugin->write_mutex);
@@ -450,16 +452,27 @@ xmms_output_plugin_writer (gpointer data)
 
 			g_mutex_unlock (&plugin->write_mutex);
 
-			ret = xmms_output_read (output, buffer, 4096);
+			/* write straight out of the output buffer when we can,
+			 * the copy is only needed when a frame wraps around.
+			 */
+			chunk = NULL;
+			ret = xmms_output_read_reserve (output, &chunk, 4096);
+			if (ret == 0) {
+				ret = xmms_output_read (output, buffer, 4096);
+			}
 			if (ret > 0) {
 				xmms_error_t err;
 
 				xmms_error_reset (&err);
 
 				g_mutex_lock (&plugin->api_mutex);
-				plugin->methods.write (output, buffer, ret, &err);
+				plugin->methods.write (output, chunk ? (gpointer) chunk : buffer, ret, &err);
 				g_mutex_unlock (&plugin->api_mutex);
 
+				if (chunk) {
+					xmms_output_read_commit (output, ret);
+				}
+
 				if (xmms_error_iserror (&err)) {
 					XMMS_DBG ("Write method set error bit");
 
@@ -449,6 +449,50 @@ xmms_playlist_current_entry (xmms_playlist_t *playlist)
 	return ent;
 }
 
+/**
+ * Retrieve the entry that #xmms_playlist_advance would move to, without
+ * actually moving there. Jumplists are not followed, as that would mean
+ * loading another playlist.
+ *
+ * @returns the entry, or 0 if the active playlist has no entry after
+ *          the current one.
+ */
+xmms_medialib_entry_t
+xmms_playlist_next_entry (xmms_playlist_t *playlist)
+{
+	gint size, currpos;
+	xmmsv_t *plcoll;
+	xmms_medialib_entry_t ent = 0;
+
+	g_return_val_if_fail (playlist, 0);
+
+	g_mutex_lock (&playlist->mutex);
+
+	plcoll = xmms_playlist_get_coll (playlist, XMMS_ACTIVE_PLAYLIST, NULL);
+	if (plcoll == NULL) {
+		g_mutex_unlock (&playlist->mutex);
+		return 0;
+	}
+
+	currpos = xmms_playlist_coll_get_currpos (plcoll);
+	size = xmms_playlist_coll_get_size (plcoll);
+
+	if (!playlist->repeat_one) {
+		currpos++;
+		if (currpos == size && playlist->repeat_all) {
+			currpos = 0;
+		}
+	}
+
+	if (currpos >= 0 && currpos < size) {
+		xmmsv_coll_idlist_get_index (plcoll, currpos, &ent);
+	}
+
+	g_mutex_unlock (&playlist->mutex);
+
+	return ent;
+}
+
 
 /**
  * Retrieve the position of the currently active xmms_medialib_entry_t
@@ -721,17 +765,13 @@ xmms_playlist_client_rinsert (xmms_playlist_t *playlist, const gchar *plname, gi
 {
 	xmms_medialib_entry_t entry;
 	xmmsv_t *idlist;
-	xmmsv_list_iter_t *it;
-	xmmsv_t *list;
+	gint i;
 
 	idlist = xmms_medialib_add_recursive (playlist->medialib, path, err);
-	list = xmmsv_coll_idlist_get (idlist);
 
-	xmmsv_get_list_iter (list, &it);
-	xmmsv_list_iter_last (it);
-	while (xmmsv_list_iter_entry_int (it, &entry)) {
+	for (i = xmmsv_coll_idlist_get_size (idlist) - 1; i >= 0; i--) {
+		xmmsv_coll_idlist_get_index (idlist, i, &entry);
 		xmms_playlist_insert_entry (playlist, plname, pos, entry, err);
-		xmmsv_list_iter_prev (it);
 	}
 
 	xmmsv_unref (idlist);
@@ -882,16 +922,12 @@ xmms_playlist_client_radd (xmms_playlist_t *playlist, const gchar *plname,
 {
 	xmms_medialib_entry_t entry;
 	xmmsv_t *idlist;
-	xmmsv_list_iter_t *it;
-	xmmsv_t *list;
+	gint i;
 
 	idlist = xmms_medialib_add_recursive (playlist->medialib, path, err);
-	list = xmmsv_coll_idlist_get (idlist);
 
-	xmmsv_get_list_iter (list, &it);
-	while (xmmsv_list_iter_entry_int (it, &entry)) {
+	for (i = 0; xmmsv_coll_idlist_get_index (idlist, i, &entry); i++) {
 		xmms_playlist_add_entry (playlist, plname, entry, err);
-		xmmsv_list_iter_next (it);
 	}
 
 	xmmsv_unref (idlist);
@@ -1158,7 +1194,7 @@ xmms_playlist_client_list_entries (xmms_playlist_t *playlist, const gchar *plnam
 	xmmsv_t *entries = NULL;
 	xmmsv_t *plcoll;
 	xmms_medialib_entry_t entry;
-	xmmsv_list_iter_t *it;
+	gint i;
 
 	g_return_val_if_fail (playlist, NULL);
 
@@ -1172,15 +1208,9 @@ xmms_playlist_client_list_entries (xmms_playlist_t *playlist, const gchar *plnam
 
 	entries = xmmsv_new_list ();
 
-	xmmsv_get_list_iter (xmmsv_coll_idlist_get (plcoll), &it);
-	for (xmmsv_list_iter_first (it);
-	     xmmsv_list_iter_valid (it);
-	     xmmsv_list_iter_next (it)) {
-
-		xmmsv_list_iter_entry_int (it, &entry);
+	for (i = 0; xmmsv_coll_idlist_get_index (plcoll, i, &entry); i++) {
 		xmmsv_list_append_int (entries, entry);
 	}
-	xmmsv_list_iter_explicit_destroy (it);
 
 	g_mutex_unlock (&playlist->mutex);
 
@@ -204,6 +204,7 @@ xmms_plugin_add_builtin_plugins (void)
 	extern const xmms_plugin_desc_t xmms_builtin_nibbler;
 	extern const xmms_plugin_desc_t xmms_builtin_visualization;
 	extern const xmms_plugin_desc_t xmms_builtin_ringbuf;
+	extern const xmms_plugin_desc_t xmms_builtin_effects;
 
 	xmms_plugin_load (&xmms_builtin_magic, NULL);
 	xmms_plugin_load (&xmms_builtin_converter, NULL);
@@ -211,6 +212,7 @@ xmms_plugin_add_builtin_plugins (void)
 	xmms_plugin_load (&xmms_builtin_nibbler, NULL);
 	xmms_plugin_load (&xmms_builtin_visualization, NULL);
 	xmms_plugin_load (&xmms_builtin_ringbuf, NULL);
+	xmms_plugin_load (&xmms_builtin_effects, NULL);
 
 	/* load static plugins */
 	for (i = 0; xmms_builtin_plugins[i]; i++)
@@ -45,6 +45,29 @@ struct xmms_ringbuf_St {
 	GCond free_cond;
 	GCond used_cond;
 	GCond eos_cond;
+
+	/** Single producer / single consumer mode, see #xmms_ringbuf_new_lockfree */
+	gboolean lockfree;
+	/** buffer_size - 1, indices are free running and masked on access */
+	guint mask;
+	/** Protects the hotspot queue and the condition variables */
+	GMutex lock;
+	/** Held while hotspot callbacks run, supplied by the owner */
+	GMutex *hotspot_mutex;
+	gint hotspot_count;
+	/** Number of threads sleeping in free_cond / used_cond */
+	gint free_waiters, used_waiters;
+	/** Write index at the last clear, and the generation of that clear */
+	guint discard_index;
+	gint clear_gen;
+	/** Last clear generation the reader has caught up with */
+	gint applied_gen;
+
+	/** Outstanding zero-copy reservations, see #xmms_ringbuf_read_reserve */
+	gint read_reserved;
+	guint read_reserve_pos;
+	gint read_reserve_gen;
+	gint write_reserve_gen;
 };
 
 typedef struct xmms_ringbuf_hotspot_St {
@@ -99,6 +122,82 @@ xmms_ringbuf_new (guint size)
 	return ringbuf;
 }
 
+/**
+ * Allocate a new ringbuffer for single producer / single consumer use.
+ *
+ * The read and write indices are updated atomically, so the reader and
+ * the writer never need to share a lock to move data. The condition
+ * variables are only touched when the other side is actually sleeping,
+ * that is when the buffer ran empty or full.
+ *
+ * All producer side operations (write, clear and hotspot_set) must still
+ * be serialised by the caller, as must the consumer side ones (read and
+ * peek). The mutex passed to the blocking calls is released while
+ * sleeping but is not required by the buffer itself, so the reader may
+ * pass NULL.
+ *
+ * Hotspot callbacks are run by the reader with @a hotspot_mutex held,
+ * which should be the lock that serialises the producer.
+ *
+ * @param size The minimum size of the new ringbuffer, rounded up to
+ *             the next power of two
+ * @param hotspot_mutex Mutex to hold while running hotspot callbacks
+ * @returns a new #xmms_ringbuf_t
+ */
+xmms_ringbuf_t *
+xmms_ringbuf_new_lockfree (guint size, GMutex *hotspot_mutex)
+{
+	xmms_ringbuf_t *ringbuf;
+	guint capacity = 1;
+
+	g_return_val_if_fail (size > 0, NULL);
+	g_return_val_if_fail (size <= G_MAXINT / 2, NULL);
+
+	while (capacity < size) {
+		capacity <<= 1;
+	}
+
+	ringbuf = g_new0 (xmms_ringbuf_t, 1);
+
+	/* indices are never wrapped, so read == write only when empty and
+	 * the whole buffer is usable.
+	 */
+	ringbuf->lockfree = TRUE;
+	ringbuf->buffer_size_usable = capacity;
+	ringbuf->buffer_size = capacity;
+	ringbuf->mask = capacity - 1;
+	ringbuf->buffer = g_malloc (ringbuf->buffer_size);
+	ringbuf->hotspot_mutex = hotspot_mutex;
+
+	g_mutex_init (&ringbuf->lock);
+	g_cond_init (&ringbuf->free_cond);
+	g_cond_init (&ringbuf->used_cond);
+	g_cond_init (&ringbuf->eos_cond);
+
+	ringbuf->hotspots = g_queue_new ();
+
+	return ringbuf;
+}
+
+/**
+ * Tell if the ringbuffer was created with #xmms_ringbuf_new_lockfree
+ */
+gboolean
+xmms_ringbuf_is_lockfree (const xmms_ringbuf_t *ringbuf)
+{
+	g_return_val_if_fail (ringbuf, FALSE);
+
+	return ringbuf->lockfree;
+}
+
+static void
+hotspot_free (xmms_ringbuf_hotspot_t *hs)
+{
+	if (hs->destroy)
+		hs->destroy (hs->arg);
+	g_free (hs);
+}
+
 /**
  * Free all memory used by the ringbuffer
  */
@@ -107,6 +206,10 @@ xmms_ringbuf_destroy (xmms_ringbuf_t *ringbuf)
 {
 	g_return_if_fail (ringbuf);
 
+	if (ringbuf->lockfree) {
+		g_mutex_clear (&ringbuf->lock);
+	}
+
 	g_cond_clear (&ringbuf->eos_cond);
 	g_cond_clear (&ringbuf->used_cond);
 	g_cond_clear (&ringbuf->free_cond);
@@ -116,6 +219,271 @@ xmms_ringbuf_destroy (xmms_ringbuf_t *ringbuf)
 	g_free (ringbuf);
 }
 
+/*
+ * Lock-free mode
+ *
+ * rd_index is only written by the reader and wr_index only by the
+ * writer. Both run freely and are masked when touching the buffer, so
+ * wr_index - rd_index is the number of used bytes.
+ *
+ * A clear can not move rd_index from the writer side, instead it
+ * records the current write index as discard_index and bumps
+ * clear_gen. The reader skips ahead to discard_index once it notices,
+ * and drops anything it copied while a clear happened behind its back.
+ */
+
+static guint
+lf_used (const xmms_ringbuf_t *ringbuf)
+{
+	guint wr, from;
+
+	wr = (guint) g_atomic_int_get (&ringbuf->wr_index);
+
+	/* a pending clear frees everything up to discard_index, except
+	 * when the reader still has a reservation it is working on.
+	 */
+	if (g_atomic_int_get (&ringbuf->applied_gen) !=
+	    g_atomic_int_get (&ringbuf->clear_gen) &&
+	    !g_atomic_int_get (&ringbuf->read_reserved)) {
+		from = (guint) g_atomic_int_get (&ringbuf->discard_index);
+	} else {
+		from = (guint) g_atomic_int_get (&ringbuf->rd_index);
+	}
+
+	return wr - from;
+}
+
+static void
+lf_wake (xmms_ringbuf_t *ringbuf, GCond *cond, gint *waiters)
+{
+	if (g_atomic_int_get (waiters) > 0) {
+		g_mutex_lock (&ringbuf->lock);
+		g_cond_broadcast (cond);
+		g_mutex_unlock (&ringbuf->lock);
+	}
+}
+
+typedef gboolean (*lf_wait_cond_t) (const xmms_ringbuf_t *ringbuf, guint len);
+
+static gboolean
+lf_has_free (const xmms_ringbuf_t *ringbuf, guint len)
+{
+	return ringbuf->buffer_size_usable - lf_used (ringbuf) >= len ||
+	       g_atomic_int_get (&ringbuf->eos);
+}
+
+static gboolean
+lf_has_used (const xmms_ringbuf_t *ringbuf, guint len)
+{
+	return lf_used (ringbuf) >= len || g_atomic_int_get (&ringbuf->eos);
+}
+
+static gboolean
+lf_is_eos (const xmms_ringbuf_t *ringbuf, guint len)
+{
+	return !lf_used (ringbuf) && g_atomic_int_get (&ringbuf->eos);
+}
+
+/* Sleep on cond until done is satisfied. The caller's mutex (if any) is
+ * released while sleeping, just like with g_cond_wait, and the internal
+ * lock is always taken after it to keep the locking order.
+ */
+static void
+lf_wait (xmms_ringbuf_t *ringbuf, GCond *cond, gint *waiters,
+         lf_wait_cond_t done, guint len, GMutex *mtx)
+{
+	while (!done (ringbuf, len)) {
+		g_mutex_lock (&ringbuf->lock);
+		g_atomic_int_inc (waiters);
+
+		if (mtx) {
+			g_mutex_unlock (mtx);
+		}
+
+		/* the other side checks waiters after publishing its index,
+		 * so either it sees us here or we see its update below.
+		 */
+		if (!done (ringbuf, len)) {
+			g_cond_wait (cond, &ringbuf->lock);
+		}
+
+		g_atomic_int_add (waiters, -1);
+		g_mutex_unlock (&ringbuf->lock);
+
+		if (mtx) {
+			g_mutex_lock (mtx);
+		}
+	}
+}
+
+/* Skip to the last clear position if the writer side cleared the buffer */
+static gint
+lf_apply_clear (xmms_ringbuf_t *ringbuf)
+{
+	gint gen;
+
+	gen = g_atomic_int_get (&ringbuf->clear_gen);
+	if (gen != g_atomic_int_get (&ringbuf->applied_gen)) {
+		g_atomic_int_set (&ringbuf->rd_index,
+		                  g_atomic_int_get (&ringbuf->discard_index));
+		g_atomic_int_set (&ringbuf->applied_gen, gen);
+		lf_wake (ringbuf, &ringbuf->free_cond, &ringbuf->free_waiters);
+	}
+
+	return gen;
+}
+
+/* Run all hotspots at the current read position with the owners
+ * hotspot mutex held. Returns FALSE if one of them did.
+ */
+static gboolean
+lf_run_hotspots (xmms_ringbuf_t *ringbuf, guint rd)
+{
+	xmms_ringbuf_hotspot_t *hs;
+	gboolean ok = TRUE;
+
+	if (ringbuf->hotspot_mutex) {
+		g_mutex_lock (ringbuf->hotspot_mutex);
+	}
+
+	while (ok) {
+		g_mutex_lock (&ringbuf->lock);
+		hs = g_queue_peek_head (ringbuf->hotspots);
+		if (!hs || hs->pos != rd) {
+			g_mutex_unlock (&ringbuf->lock);
+			break;
+		}
+		(void) g_queue_pop_head (ringbuf->hotspots);
+		g_atomic_int_add (&ringbuf->hotspot_count, -1);
+		g_mutex_unlock (&ringbuf->lock);
+
+		ok = hs->callback (hs->arg);
+		hotspot_free (hs);
+	}
+
+	if (ringbuf->hotspot_mutex) {
+		g_mutex_unlock (ringbuf->hotspot_mutex);
+	}
+
+	return ok;
+}
+
+/* Catch up with clears and run the hotspots at the read position.
+ * Returns FALSE if a hotspot callback failed, otherwise the read
+ * position and how much can be read before the next hotspot.
+ */
+static gboolean
+lf_read_prepare (xmms_ringbuf_t *ringbuf, guint len, guint *rd_out,
+                 guint *to_read_out, gint *gen_out)
+{
+	xmms_ringbuf_hotspot_t *hs;
+	guint rd, wr, to_read;
+	gboolean due;
+	gint gen;
+
+	for (;;) {
+		gen = lf_apply_clear (ringbuf);
+
+		rd = (guint) g_atomic_int_get (&ringbuf->rd_index);
+		wr = (guint) g_atomic_int_get (&ringbuf->wr_index);
+		to_read = MIN (len, wr - rd);
+
+		if (g_atomic_int_get (&ringbuf->hotspot_count) > 0) {
+			g_mutex_lock (&ringbuf->lock);
+			hs = g_queue_peek_head (ringbuf->hotspots);
+			due = hs && hs->pos == rd;
+			if (hs && !due) {
+				/* make sure we don't cross a hotspot */
+				to_read = MIN (to_read, hs->pos - rd);
+			}
+			g_mutex_unlock (&ringbuf->lock);
+
+			if (due) {
+				if (!lf_run_hotspots (ringbuf, rd)) {
+					return FALSE;
+				}
+				continue;
+			}
+		}
+
+		*rd_out = rd;
+		*to_read_out = to_read;
+		*gen_out = gen;
+
+		return TRUE;
+	}
+}
+
+static guint
+lf_read_bytes (xmms_ringbuf_t *ringbuf, guint8 *data, guint len,
+               gboolean advance)
+{
+	guint rd, to_read, pos, cnt;
+	gint gen;
+
+	for (;;) {
+		if (!lf_read_prepare (ringbuf, len, &rd, &to_read, &gen)) {
+			return 0;
+		}
+
+		pos = rd & ringbuf->mask;
+		cnt = MIN (to_read, ringbuf->buffer_size - pos);
+		memcpy (data, ringbuf->buffer + pos, cnt);
+		memcpy (data + cnt, ringbuf->buffer, to_read - cnt);
+
+		if (g_atomic_int_get (&ringbuf->clear_gen) != gen) {
+			/* cleared while copying, what we got may be garbage */
+			continue;
+		}
+
+		if (advance && to_read) {
+			g_atomic_int_set (&ringbuf->rd_index, rd + to_read);
+			lf_wake (ringbuf, &ringbuf->free_cond, &ringbuf->free_waiters);
+		}
+
+		return to_read;
+	}
+}
+
+static guint
+lf_write (xmms_ringbuf_t *ringbuf, const guint8 *data, guint len)
+{
+	guint wr, pos, cnt, to_write;
+
+	wr = (guint) g_atomic_int_get (&ringbuf->wr_index);
+	to_write = MIN (len, ringbuf->buffer_size_usable - lf_used (ringbuf));
+
+	pos = wr & ringbuf->mask;
+	cnt = MIN (to_write, ringbuf->buffer_size - pos);
+	memcpy (ringbuf->buffer + pos, data, cnt);
+	memcpy (ringbuf->buffer, data + cnt, to_write - cnt);
+
+	if (to_write) {
+		g_atomic_int_set (&ringbuf->wr_index, wr + to_write);
+		lf_wake (ringbuf, &ringbuf->used_cond, &ringbuf->used_waiters);
+	}
+
+	return to_write;
+}
+
+static void
+lf_clear (xmms_ringbuf_t *ringbuf)
+{
+	g_mutex_lock (&ringbuf->lock);
+
+	while (!g_queue_is_empty (ringbuf->hotspots)) {
+		hotspot_free (g_queue_pop_head (ringbuf->hotspots));
+	}
+	g_atomic_int_set (&ringbuf->hotspot_count, 0);
+
+	g_atomic_int_set (&ringbuf->discard_index,
+	                  g_atomic_int_get (&ringbuf->wr_index));
+	g_atomic_int_inc (&ringbuf->clear_gen);
+
+	g_cond_broadcast (&ringbuf->free_cond);
+	g_mutex_unlock (&ringbuf->lock);
+}
+
 /**
  * Clear the ringbuffers data
  */
@@ -124,8 +492,22 @@ xmms_ringbuf_clear (xmms_ringbuf_t *ringbuf)
 {
 	g_return_if_fail (ringbuf);
 
-	ringbuf->rd_index = 0;
-	ringbuf->wr_index = 0;
+	if (ringbuf->lockfree) {
+		lf_clear (ringbuf);
+		return;
+	}
+
+	/* restart right after an outstanding read reservation so the
+	 * writer can not overwrite what the reader is still using.
+	 */
+	if (ringbuf->read_reserved) {
+		ringbuf->rd_index = (ringbuf->read_reserve_pos + ringbuf->read_reserved)
+		                    % ringbuf->buffer_size;
+	} else {
+		ringbuf->rd_index = 0;
+	}
+	ringbuf->wr_index = ringbuf->rd_index;
+	ringbuf->clear_gen++;
 
 	while (!g_queue_is_empty (ringbuf->hotspots)) {
 		xmms_ringbuf_hotspot_t *hs;
@@ -145,6 +527,13 @@ xmms_ringbuf_bytes_free (const xmms_ringbuf_t *ringbuf)
 {
 	g_return_val_if_fail (ringbuf, 0);
 
+	/* a read reservation that survived a clear still pins its bytes */
+	if (!ringbuf->lockfree && ringbuf->read_reserved &&
+	    ringbuf->read_reserve_gen != ringbuf->clear_gen) {
+		return ringbuf->buffer_size_usable - ringbuf->read_reserved -
+		       xmms_ringbuf_bytes_used (ringbuf);
+	}
+
 	return ringbuf->buffer_size_usable -
 	       xmms_ringbuf_bytes_used (ringbuf);
 }
@@ -157,6 +546,10 @@ xmms_ringbuf_bytes_used (const xmms_ringbuf_t *ringbuf)
 {
 	g_return_val_if_fail (ringbuf, 0);
 
+	if (ringbuf->lockfree) {
+		return lf_used (ringbuf);
+	}
+
 	if (ringbuf->wr_index >= ringbuf->rd_index) {
 		return ringbuf->wr_index - ringbuf->rd_index;
 	}
@@ -164,21 +557,21 @@ xmms_ringbuf_bytes_used (const xmms_ringbuf_t *ringbuf)
 	return ringbuf->buffer_size - (ringbuf->rd_index - ringbuf->wr_index);
 }
 
-static guint
-read_bytes (xmms_ringbuf_t *ringbuf, guint8 *data, guint len)
+/* Run the hotspots at the read position and clamp to_read so that
+ * the next one isn't crossed. Returns FALSE if a callback failed.
+ */
+static gboolean
+run_hotspots (xmms_ringbuf_t *ringbuf, guint *to_read)
 {
-	guint to_read, r = 0, cnt, tmp;
 	gboolean ok;
 
-	to_read = MIN (len, xmms_ringbuf_bytes_used (ringbuf));
-
 	while (!g_queue_is_empty (ringbuf->hotspots)) {
 		xmms_ringbuf_hotspot_t *hs = g_queue_peek_head (ringbuf->hotspots);
 		if (hs->pos != ringbuf->rd_index) {
 			/* make sure we don't cross a hotspot */
-			to_read = MIN (to_read,
-			               (hs->pos - ringbuf->rd_index + ringbuf->buffer_size)
-			               % ringbuf->buffer_size);
+			*to_read = MIN (*to_read,
+			                (hs->pos - ringbuf->rd_index + ringbuf->buffer_size)
+			                % ringbuf->buffer_size);
 			break;
 		}
 
@@ -189,13 +582,27 @@ read_bytes (xmms_ringbuf_t *ringbuf, guint8 *data, guint len)
 		g_free (hs);
 
 		if (!ok) {
-			return 0;
+			return FALSE;
 		}
 
 		/* we loop here, to see if there are multiple
 		   hotspots in same position */
 	}
 
+	return TRUE;
+}
+
+static guint
+read_bytes (xmms_ringbuf_t *ringbuf, guint8 *data, guint len)
+{
+	guint to_read, r = 0, cnt, tmp;
+
+	to_read = MIN (len, xmms_ringbuf_bytes_used (ringbuf));
+
+	if (!run_hotspots (ringbuf, &to_read)) {
+		return 0;
+	}
+
 	tmp = ringbuf->rd_index;
 
 	while (to_read > 0) {
@@ -229,6 +636,10 @@ xmms_ringbuf_read (xmms_ringbuf_t *ringbuf, gpointer data, guint len)
 	g_return_val_if_fail (data, 0);
 	g_return_val_if_fail (len > 0, 0);
 
+	if (ringbuf->lockfree) {
+		return lf_read_bytes (ringbuf, (guint8 *) data, len, TRUE);
+	}
+
 	r = read_bytes (ringbuf, (guint8 *) data, len);
 
 	ringbuf->rd_index += r;
@@ -255,6 +666,10 @@ xmms_ringbuf_peek (xmms_ringbuf_t *ringbuf, gpointer data, guint len)
 	g_return_val_if_fail (len > 0, 0);
 	g_return_val_if_fail (len <= ringbuf->buffer_size_usable, 0);
 
+	if (ringbuf->lockfree) {
+		return lf_read_bytes (ringbuf, (guint8 *) data, len, FALSE);
+	}
+
 	return read_bytes (ringbuf, (guint8 *) data, len);
 }
 
@@ -273,16 +688,23 @@ xmms_ringbuf_read_wait (xmms_ringbuf_t *ringbuf, gpointer data,
 	g_return_val_if_fail (ringbuf, 0);
 	g_return_val_if_fail (data, 0);
 	g_return_val_if_fail (len > 0, 0);
-	g_return_val_if_fail (mtx, 0);
+	g_return_val_if_fail (mtx || ringbuf->lockfree, 0);
 
 	while (r < len) {
 		res = xmms_ringbuf_read (ringbuf, dest + r, len - r);
 		r += res;
-		if (r == len || ringbuf->eos) {
+		if (r == len || g_atomic_int_get (&ringbuf->eos)) {
 			break;
 		}
-		if (!res)
+		if (res) {
+			continue;
+		}
+		if (ringbuf->lockfree) {
+			lf_wait (ringbuf, &ringbuf->used_cond, &ringbuf->used_waiters,
+			         lf_has_used, 1, mtx);
+		} else {
 			g_cond_wait (&ringbuf->used_cond, mtx);
+		}
 	}
 
 	return r;
@@ -301,7 +723,7 @@ xmms_ringbuf_peek_wait (xmms_ringbuf_t *ringbuf, gpointer data,
 	g_return_val_if_fail (data, 0);
 	g_return_val_if_fail (len > 0, 0);
 	g_return_val_if_fail (len <= ringbuf->buffer_size_usable, 0);
-	g_return_val_if_fail (mtx, 0);
+	g_return_val_if_fail (mtx || ringbuf->lockfree, 0);
 
 	xmms_ringbuf_wait_used (ringbuf, len, mtx);
 
@@ -330,6 +752,10 @@ xmms_ringbuf_write (xmms_ringbuf_t *ringbuf, gconstpointer data,
 	g_return_val_if_fail (data, 0);
 	g_return_val_if_fail (len > 0, 0);
 
+	if (ringbuf->lockfree) {
+		return lf_write (ringbuf, src, len);
+	}
+
 	to_write = MIN (len, xmms_ringbuf_bytes_free (ringbuf));
 
 	while (to_write > 0) {
@@ -361,20 +787,180 @@ xmms_ringbuf_write_wait (xmms_ringbuf_t *ringbuf, gconstpointer data,
 	g_return_val_if_fail (ringbuf, 0);
 	g_return_val_if_fail (data, 0);
 	g_return_val_if_fail (len > 0, 0);
-	g_return_val_if_fail (mtx, 0);
+	g_return_val_if_fail (mtx || ringbuf->lockfree, 0);
 
 	while (w < len) {
 		w += xmms_ringbuf_write (ringbuf, src + w, len - w);
-		if (w == len || ringbuf->eos) {
+		if (w == len || g_atomic_int_get (&ringbuf->eos)) {
 			break;
 		}
 
-		g_cond_wait (&ringbuf->free_cond, mtx);
+		if (ringbuf->lockfree) {
+			lf_wait (ringbuf, &ringbuf->free_cond, &ringbuf->free_waiters,
+			         lf_has_free, 1, mtx);
+		} else {
+			g_cond_wait (&ringbuf->free_cond, mtx);
+		}
 	}
 
 	return w;
 }
 
+/**
+ * Reserve space in the ringbuffer to write to directly, instead of
+ * passing a buffer to #xmms_ringbuf_write. Only the contiguous part
+ * up to the end of the buffer is handed out.
+ *
+ * The buffer lock doesn't have to be held between reserving and
+ * committing. If the buffer is cleared in between the commit is
+ * silently dropped. Only one write reservation can be outstanding.
+ *
+ * @param ringbuf Ringbuffer to write to
+ * @param len Number of bytes wanted, updated with the number of
+ *            bytes that may be written to the returned pointer
+ * @returns Pointer into the buffer, or NULL if it is full
+ */
+gpointer
+xmms_ringbuf_write_reserve (xmms_ringbuf_t *ringbuf, guint *len)
+{
+	guint pos;
+
+	g_return_val_if_fail (ringbuf, NULL);
+	g_return_val_if_fail (len, NULL);
+
+	*len = MIN (*len, xmms_ringbuf_bytes_free (ringbuf));
+
+	if (ringbuf->lockfree) {
+		pos = (guint) g_atomic_int_get (&ringbuf->wr_index) & ringbuf->mask;
+	} else {
+		pos = ringbuf->wr_index;
+	}
+
+	*len = MIN (*len, ringbuf->buffer_size - pos);
+	ringbuf->write_reserve_gen = g_atomic_int_get (&ringbuf->clear_gen);
+
+	if (!*len) {
+		return NULL;
+	}
+
+	return ringbuf->buffer + pos;
+}
+
+/**
+ * Make @a len bytes written to the space returned by
+ * #xmms_ringbuf_write_reserve visible to the reader.
+ */
+void
+xmms_ringbuf_write_commit (xmms_ringbuf_t *ringbuf, guint len)
+{
+	guint wr;
+
+	g_return_if_fail (ringbuf);
+
+	if (!len || g_atomic_int_get (&ringbuf->clear_gen) != ringbuf->write_reserve_gen) {
+		return;
+	}
+
+	if (ringbuf->lockfree) {
+		wr = (guint) g_atomic_int_get (&ringbuf->wr_index);
+		g_atomic_int_set (&ringbuf->wr_index, wr + len);
+		lf_wake (ringbuf, &ringbuf->used_cond, &ringbuf->used_waiters);
+		return;
+	}
+
+	ringbuf->wr_index = (ringbuf->wr_index + len) % ringbuf->buffer_size;
+	g_cond_broadcast (&ringbuf->used_cond);
+}
+
+/**
+ * Get a pointer to the data at the read position, instead of copying
+ * it out with #xmms_ringbuf_read. Hotspots are handled just like when
+ * reading, and only the contiguous part before the next hotspot or the
+ * end of the buffer is handed out.
+ *
+ * The reserved bytes stay in the buffer until
+ * #xmms_ringbuf_read_commit is called, even if the buffer is cleared
+ * meanwhile, so the buffer lock doesn't need to be held while using
+ * them. Only one read reservation can be outstanding.
+ *
+ * @param ringbuf Ringbuffer to read from
+ * @param len Number of bytes wanted, updated with the number of
+ *            bytes that may be read from the returned pointer
+ * @returns Pointer into the buffer, or NULL if there is nothing to read
+ */
+gconstpointer
+xmms_ringbuf_read_reserve (xmms_ringbuf_t *ringbuf, guint *len)
+{
+	guint pos = 0, to_read;
+	gint gen = 0;
+
+	g_return_val_if_fail (ringbuf, NULL);
+	g_return_val_if_fail (len, NULL);
+	g_return_val_if_fail (!ringbuf->read_reserved, NULL);
+
+	if (ringbuf->lockfree) {
+		/* pin the read position before looking at it, a clear that
+		 * comes after this won't free the reserved bytes.
+		 */
+		g_atomic_int_set (&ringbuf->read_reserved, 1);
+		if (!lf_read_prepare (ringbuf, *len, &pos, &to_read, &gen)) {
+			to_read = 0;
+		}
+		pos &= ringbuf->mask;
+	} else {
+		to_read = MIN (*len, xmms_ringbuf_bytes_used (ringbuf));
+		if (!run_hotspots (ringbuf, &to_read)) {
+			to_read = 0;
+		}
+		pos = ringbuf->rd_index;
+		gen = ringbuf->clear_gen;
+	}
+
+	*len = MIN (to_read, ringbuf->buffer_size - pos);
+
+	if (!*len) {
+		g_atomic_int_set (&ringbuf->read_reserved, 0);
+		return NULL;
+	}
+
+	g_atomic_int_set (&ringbuf->read_reserved, *len);
+	ringbuf->read_reserve_pos = pos;
+	ringbuf->read_reserve_gen = gen;
+
+	return ringbuf->buffer + pos;
+}
+
+/**
+ * Release @a len bytes of the space returned by
+ * #xmms_ringbuf_read_reserve, advancing the read position unless
+ * the buffer was cleared meanwhile.
+ */
+void
+xmms_ringbuf_read_commit (xmms_ringbuf_t *ringbuf, guint len)
+{
+	guint rd;
+
+	g_return_if_fail (ringbuf);
+	g_return_if_fail (len <= (guint) ringbuf->read_reserved);
+
+	if (ringbuf->lockfree) {
+		if (g_atomic_int_get (&ringbuf->clear_gen) == ringbuf->read_reserve_gen && len) {
+			rd = (guint) g_atomic_int_get (&ringbuf->rd_index);
+			g_atomic_int_set (&ringbuf->rd_index, rd + len);
+		}
+		g_atomic_int_set (&ringbuf->read_reserved, 0);
+		lf_wake (ringbuf, &ringbuf->free_cond, &ringbuf->free_waiters);
+		return;
+	}
+
+	if (ringbuf->clear_gen == ringbuf->read_reserve_gen) {
+		ringbuf->rd_index = (ringbuf->rd_index + len) % ringbuf->buffer_size;
+	}
+	ringbuf->read_reserved = 0;
+
+	g_cond_broadcast (&ringbuf->free_cond);
+}
+
 /**
  * Block until we have free space in the ringbuffer.
  */
@@ -384,7 +970,13 @@ xmms_ringbuf_wait_free (xmms_ringbuf_t *ringbuf, guint len, GMutex *mtx)
 	g_return_if_fail (ringbuf);
 	g_return_if_fail (len > 0);
 	g_return_if_fail (len <= ringbuf->buffer_size_usable);
-	g_return_if_fail (mtx);
+	g_return_if_fail (mtx || ringbuf->lockfree);
+
+	if (ringbuf->lockfree) {
+		lf_wait (ringbuf, &ringbuf->free_cond, &ringbuf->free_waiters,
+		         lf_has_free, len, mtx);
+		return;
+	}
 
 	while ((xmms_ringbuf_bytes_free (ringbuf) < len) && !ringbuf->eos) {
 		g_cond_wait (&ringbuf->free_cond, mtx);
@@ -401,7 +993,13 @@ xmms_ringbuf_wait_used (xmms_ringbuf_t *ringbuf, guint len, GMutex *mtx)
 	g_return_if_fail (ringbuf);
 	g_return_if_fail (len > 0);
 	g_return_if_fail (len <= ringbuf->buffer_size_usable);
-	g_return_if_fail (mtx);
+	g_return_if_fail (mtx || ringbuf->lockfree);
+
+	if (ringbuf->lockfree) {
+		lf_wait (ringbuf, &ringbuf->used_cond, &ringbuf->used_waiters,
+		         lf_has_used, len, mtx);
+		return;
+	}
 
 	while ((xmms_ringbuf_bytes_used (ringbuf) < len) && !ringbuf->eos) {
 		g_cond_wait (&ringbuf->used_cond, mtx);
@@ -419,7 +1017,7 @@ xmms_ringbuf_iseos (const xmms_ringbuf_t *ringbuf)
 {
 	g_return_val_if_fail (ringbuf, TRUE);
 
-	return !xmms_ringbuf_bytes_used (ringbuf) && ringbuf->eos;
+	return !xmms_ringbuf_bytes_used (ringbuf) && g_atomic_int_get (&ringbuf->eos);
 }
 
 /**
@@ -430,13 +1028,21 @@ xmms_ringbuf_set_eos (xmms_ringbuf_t *ringbuf, gboolean eos)
 {
 	g_return_if_fail (ringbuf);
 
-	ringbuf->eos = eos;
+	if (ringbuf->lockfree) {
+		g_mutex_lock (&ringbuf->lock);
+	}
+
+	g_atomic_int_set (&ringbuf->eos, eos);
 
 	if (eos) {
 		g_cond_broadcast (&ringbuf->eos_cond);
 		g_cond_broadcast (&ringbuf->used_cond);
 		g_cond_broadcast (&ringbuf->free_cond);
 	}
+
+	if (ringbuf->lockfree) {
+		g_mutex_unlock (&ringbuf->lock);
+	}
 }
 
 
@@ -447,7 +1053,18 @@ void
 xmms_ringbuf_wait_eos (xmms_ringbuf_t *ringbuf, GMutex *mtx)
 {
 	g_return_if_fail (ringbuf);
-	g_return_if_fail (mtx);
+	g_return_if_fail (mtx || ringbuf->lockfree);
+
+	if (ringbuf->lockfree) {
+		gint waiters = 0;
+
+		/* eos_cond is only signalled from set_eos, which always
+		 * broadcasts, so there is no need to track waiters here.
+		 */
+		lf_wait (ringbuf, &ringbuf->eos_cond, &waiters,
+		         lf_is_eos, 0, mtx);
+		return;
+	}
 
 	while (!xmms_ringbuf_iseos (ringbuf)) {
 		g_cond_wait (&(ringbuf->eos_cond), mtx);
@@ -472,5 +1089,13 @@ xmms_ringbuf_hotspot_set (xmms_ringbuf_t *ringbuf, gboolean (*cb) (void *), void
 	hs->destroy = destroy;
 	hs->arg = arg;
 
+	if (ringbuf->lockfree) {
+		g_mutex_lock (&ringbuf->lock);
+		g_queue_push_tail (ringbuf->hotspots, hs);
+		g_atomic_int_inc (&ringbuf->hotspot_count);
+		g_mutex_unlock (&ringbuf->lock);
+		return;
+	}
+
 	g_queue_push_tail (ringbuf->hotspots, hs);
 }
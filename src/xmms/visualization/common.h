@@ -20,6 +20,7 @@
 #include <glib.h>
 
 #include <xmmspriv/xmms_log.h>
+#include <xmmspriv/xmms_ringbuf.h>
 #include <xmmspriv/xmms_visualization.h>
 #include <xmmsc/xmmsc_visualization.h>
 
@@ -56,7 +57,8 @@ void cleanup_udp (xmmsc_vis_udp_t *t, xmms_socket_t socket);
 gboolean write_udp (xmmsc_vis_udp_t *t, xmms_vis_client_t *c, int32_t id, struct timeval *time, int channels, int size, short *buf, int socket);
 
 /* provided by format.c */
-void fft_init (void);
+void fft_frame (int channels, int size, short *samples);
+gboolean fft_size_valid (gint size);
 short fill_buffer (int16_t *dest, xmmsc_vis_properties_t* prop, int channels, int size, short *src);
 
 /* never call a fetch without a guaranteed release following! */
@@ -84,6 +86,14 @@ struct xmms_visualization_St {
 	GMutex clientlock;
 	int32_t clientc;
 	xmms_vis_client_t **clientv;
+
+	/* frames queued by send_data, delivered by the vis thread */
+	xmms_ringbuf_t *frames;
+	GThread *thread;
+	/* taken with trylock only, the decoding side never waits for it */
+	GMutex producer_lock;
+	gint frames_sent;
+	gint frames_dropped;
 };
 
 #endif
@@ -1,138 +1,245 @@
 #include <math.h>
 #include "common.h"
 
-#define FFT_LEN XMMSC_VISUALIZATION_WINDOW_SIZE
-/* TODO: better way, check this! */
-#define FFT_BITS 9
+/* Spectrum sizes selectable with the spectrum.size property */
+#define FFT_MIN_BITS 8
+#define FFT_MAX_BITS 13
+#define FFT_MAX_LEN (1 << FFT_MAX_BITS)
+
+/* Bins that fit in a vis packet, larger spectra are folded to this */
+#define SPEC_MAX_BINS (2 * XMMSC_VISUALIZATION_WINDOW_SIZE)
 
 /* Log scale settings */
 #define AMP_LOG_SCALE_THRESHOLD0	0.001f
 #define AMP_LOG_SCALE_DIVISOR		6.908f	/* divisor = -log threshold */
 #define FREQ_LOG_SCALE_BASE		2.0f
 
-static gfloat window[FFT_LEN];
-static gfloat spec[FFT_LEN/2];
-static gboolean fft_ready = FALSE;
-static gboolean fft_done;
+/**
+ * Everything needed to compute a spectrum of len real points. The input
+ * is packed into a complex FFT of half the size, whose result is split
+ * back into the spectrum of the real signal.
+ */
+typedef struct {
+	gint len;
+	/* Hann window used to reduce spectral leakage */
+	gfloat *window;
+	/* bit reversed index, len / 2 entries */
+	guint *bitrev;
+	/* twiddles of the stage with half size h stored at [h, 2h) so every
+	 * stage reads them in order, len / 2 entries */
+	gfloat *tw_re;
+	gfloat *tw_im;
+	/* twiddles splitting the packed result, len / 2 entries */
+	gfloat *split_re;
+	gfloat *split_im;
+	/* work buffers */
+	gfloat *re;
+	gfloat *im;
+	/* magnitudes, len / 2 entries */
+	gfloat *spec;
+	/* spec is up to date with the history */
+	gboolean done;
+} fft_plan_t;
+
+/* Only touched from the vis thread, so nothing here is locked. */
+static fft_plan_t *plans[FFT_MAX_BITS + 1];
+
+/* The latest mono samples, history[(history_pos - 1) & mask] is the newest */
+static gfloat history[FFT_MAX_LEN];
+static guint history_pos;
 
-void fft_init ()
+static fft_plan_t *
+fft_plan_get (gint bits)
 {
-	if (!fft_ready) {
-		int i;
-		/* calculate Hann window used to reduce spectral leakage */
-		for (i = 0; i < FFT_LEN; i++) {
-			window[i] = 0.5 - 0.5 * cos (2.0 * M_PI * i / FFT_LEN);
+	fft_plan_t *plan;
+	gint len, half, h, i, j, b;
+
+	if (plans[bits]) {
+		return plans[bits];
+	}
+
+	len = 1 << bits;
+	half = len / 2;
+
+	plan = g_new0 (fft_plan_t, 1);
+	plan->len = len;
+	plan->window = g_new (gfloat, len);
+	plan->bitrev = g_new (guint, half);
+	plan->tw_re = g_new (gfloat, half);
+	plan->tw_im = g_new (gfloat, half);
+	plan->split_re = g_new (gfloat, half);
+	plan->split_im = g_new (gfloat, half);
+	plan->re = g_new (gfloat, half);
+	plan->im = g_new (gfloat, half);
+	plan->spec = g_new (gfloat, half);
+
+	for (i = 0; i < len; i++) {
+		plan->window[i] = 0.5 - 0.5 * cos (2.0 * M_PI * i / len);
+	}
+
+	for (i = 0; i < half; i++) {
+		for (j = 0, b = 1; b < half; b <<= 1) {
+			j = (j << 1) | ((i & b) ? 1 : 0);
+		}
+		plan->bitrev[i] = j;
+	}
+
+	plan->tw_re[0] = 1.0f;
+	plan->tw_im[0] = 0.0f;
+	for (h = 1; h < half; h <<= 1) {
+		for (j = 0; j < h; j++) {
+			plan->tw_re[h + j] = cos (M_PI * j / h);
+			plan->tw_im[h + j] = -sin (M_PI * j / h);
 		}
-		fft_done = TRUE;
 	}
-	fft_done = FALSE;
-}
 
-/* interesting:	data->value.uint32 = xmms_sample_samples_to_ms (vis->format, pos); */
+	for (i = 0; i < half; i++) {
+		plan->split_re[i] = cos (2.0 * M_PI * i / len);
+		plan->split_im[i] = -sin (2.0 * M_PI * i / len);
+	}
 
-static void
-fft (short *samples, gfloat *spec)
+	plans[bits] = plan;
+
+	return plan;
+}
+
+/**
+ * Start a new frame: add the samples to the history the spectra are
+ * computed from, mixed down to mono. The spectra are computed on demand,
+ * at most once per frame and size however many clients want them.
+ */
+void
+fft_frame (int channels, int size, short *samples)
 {
-	gint nv2, k, l, j = 0, i;
-	gfloat t_r, t_i;
-	gfloat buf[FFT_LEN][2];
-
-	for (i = 0; i < FFT_LEN; i++){
-		buf[i][0]  = (float) samples[j++];
-		buf[i][0] += (float) samples[j++];
-		buf[i][0] /= (float) (1 << 17);
-		buf[i][0] *= window[i];
-		buf[i][1] = 0.0f;
-	}
-
-	/* reorder... */  /* this is crappy! Go rewrite it using real bitreversing */
-	nv2 = FFT_LEN / 2;
-	j = 1;
-
-	for (i = 1; i < FFT_LEN; i++) {
-		if (i < j) {
-			t_r = buf[i - 1][0];
-			t_i = buf[i - 1][1];
-			buf[i - 1][0] = buf[j - 1][0];
-			buf[i - 1][1] = buf[j - 1][1];
-			buf[j - 1][0] = t_r;
-			buf[j - 1][1] = t_i;
-		}
+	gint i, c, sum;
 
-		k = nv2;
+	if (channels <= 0) {
+		return;
+	}
 
-		while (k < j) {
-			j -= k;
-			k >>= 1;
+	for (i = 0; i + channels <= size; i += channels) {
+		for (c = 0, sum = 0; c < channels; c++) {
+			sum += samples[i + c];
 		}
+		/* same scale as the sum of a stereo pair over 2^17 */
+		history[history_pos] = (gfloat) sum / channels / (float) (1 << 16);
+		history_pos = (history_pos + 1) & (FFT_MAX_LEN - 1);
+	}
 
-		j += k;
+	for (i = FFT_MIN_BITS; i <= FFT_MAX_BITS; i++) {
+		if (plans[i]) {
+			plans[i]->done = FALSE;
+		}
 	}
+}
 
-	/* do fft */
-	for (l = 1; l <= FFT_BITS; l++) {
-		gint le = 1 << l;
-		gint le1 = le / 2;
-		gfloat u_r = 1.0;
-		gfloat u_i = 0.0;
-		gfloat w_r =  cosf (M_PI / (float) le1);
-		gfloat w_i = -sinf (M_PI / (float) le1);
+static void
+fft (fft_plan_t *plan)
+{
+	gint half = plan->len / 2;
+	gint i, j, h, g, start;
+	gfloat *re = plan->re;
+	gfloat *im = plan->im;
 
-		for (j = 1; j <= le1; j++) {
-			for (i = j; i <= FFT_LEN; i += le) {
-				gint ip = i + le1;
+	/* pack even samples as real, odd as imaginary parts */
+	start = history_pos - plan->len;
+	for (i = 0; i < half; i++) {
+		j = plan->bitrev[i];
+		re[j] = history[(start + 2 * i) & (FFT_MAX_LEN - 1)] * plan->window[2 * i];
+		im[j] = history[(start + 2 * i + 1) & (FFT_MAX_LEN - 1)] * plan->window[2 * i + 1];
+	}
 
-				t_r = buf[ip - 1][0] * u_r - u_i * buf[ip - 1][1];
-				t_i = buf[ip - 1][1] * u_r + u_i * buf[ip - 1][0];
+	/* radix 2 butterflies, the inner loop runs over contiguous data */
+	for (h = 1; h < half; h <<= 1) {
+		const gfloat *w_re = plan->tw_re + h;
+		const gfloat *w_im = plan->tw_im + h;
 
-				buf[ip - 1][0] = buf[i - 1][0] - t_r;
-				buf[ip - 1][1] = buf[i - 1][1] - t_i;
+		for (g = 0; g < half; g += 2 * h) {
+			gfloat *a_re = re + g, *a_im = im + g;
+			gfloat *b_re = re + g + h, *b_im = im + g + h;
 
-				buf[i - 1][0] =  buf[i - 1][0] + t_r;
-				buf[i - 1][1] =  buf[i - 1][1] + t_i;
-			}
+			for (j = 0; j < h; j++) {
+				gfloat t_re = b_re[j] * w_re[j] - b_im[j] * w_im[j];
+				gfloat t_im = b_re[j] * w_im[j] + b_im[j] * w_re[j];
 
-			t_r = u_r * w_r - w_i * u_i;
-			u_i = w_r * u_i + w_i * u_r;
-			u_r = t_r;
+				b_re[j] = a_re[j] - t_re;
+				b_im[j] = a_im[j] - t_im;
+				a_re[j] = a_re[j] + t_re;
+				a_im[j] = a_im[j] + t_im;
+			}
 		}
 	}
 
-	/* output abs-value instead */
-	for (i = 0; i < nv2; i++) {
-		spec[i] = 2 * hypot (buf[i][0], buf[i][1]) / FFT_LEN;
+	/* split into the spectrum of the real input and output abs-value */
+	for (i = 0; i < half; i++) {
+		gint k = (half - i) & (half - 1);
+		gfloat e_re = 0.5f * (re[i] + re[k]);
+		gfloat e_im = 0.5f * (im[i] - im[k]);
+		gfloat o_re = 0.5f * (im[i] + im[k]);
+		gfloat o_im = 0.5f * (re[k] - re[i]);
+		gfloat x_re = e_re + o_re * plan->split_re[i] - o_im * plan->split_im[i];
+		gfloat x_im = e_im + o_re * plan->split_im[i] + o_im * plan->split_re[i];
+
+		plan->spec[i] = 2 * sqrtf (x_re * x_re + x_im * x_im) / plan->len;
 	}
 
 	/* correct the scale */
-	spec[nv2 - 1] /= 2;
+	plan->spec[half - 1] /= 2;
+
+	plan->done = TRUE;
+}
+
+/**
+ * Check that size is a spectrum size we can compute.
+ */
+gboolean
+fft_size_valid (gint size)
+{
+	return size >= (1 << FFT_MIN_BITS) && size <= FFT_MAX_LEN &&
+	       (size & (size - 1)) == 0;
 }
 
 /**
  * Calcualte the FFT on the decoded data buffer.
  */
 static short
-fill_buffer_fft (int16_t* dest, int size, short *src)
+fill_buffer_fft (int16_t* dest, xmmsc_vis_properties_t* prop)
 {
-	int i;
+	fft_plan_t *plan;
+	int i, j, bits, bins, fold;
 	float tmp;
 
-	if (size != FFT_LEN * 2) {
+	if (!fft_size_valid (prop->spectrum_size)) {
 		return 0;
 	}
 
-	if (!fft_done) {
-		fft (src, spec);
-		fft_done = TRUE;
+	for (bits = FFT_MIN_BITS; (1 << bits) < prop->spectrum_size; bits++);
+
+	plan = fft_plan_get (bits);
+	if (!plan->done) {
+		fft (plan);
+	}
+
+	bins = plan->len / 2;
+	fold = 1;
+	while (bins > SPEC_MAX_BINS) {
+		bins /= 2;
+		fold *= 2;
 	}
 
 	/* TODO: more sophisticated! */
-	for (i = 0; i < FFT_LEN / 2; ++i) {
-		if (spec[i] >= 1.0) {
+	for (i = 0; i < bins; ++i) {
+		/* report the loudest of the folded bins */
+		tmp = plan->spec[i * fold];
+		for (j = 1; j < fold; j++) {
+			tmp = MAX (tmp, plan->spec[i * fold + j]);
+		}
+
+		if (tmp >= 1.0) {
 			dest[i] = htons (SHRT_MAX);
-		} else if (spec[i] < 0.0) {
+		} else if (tmp < 0.0) {
 			dest[i] = 0;
 		} else {
-			tmp = spec[i];
 			if (tmp > AMP_LOG_SCALE_THRESHOLD0) {
 //				tmp = 1.0f + (logf (tmp) /  AMP_LOG_SCALE_DIVISOR);
 			} else {
@@ -141,7 +248,7 @@ fill_buffer_fft (int16_t* dest, int size, short *src)
 			dest[i] = htons ((int16_t)(tmp * SHRT_MAX));
 		}
 	}
-	return FFT_LEN / 2;
+	return bins;
 }
 
 short
@@ -203,7 +310,7 @@ fill_buffer (int16_t *dest, xmmsc_vis_properties_t* prop, int channels, int size
 		}
 	}
 	if (prop->type == VIS_SPECTRUM) {
-		size = fill_buffer_fft (dest, size, src);
+		size = fill_buffer_fft (dest, prop);
 	}
 	return size;
 }
@@ -32,6 +32,16 @@
 
 static xmms_visualization_t *vis = NULL;
 
+/* Room for a few stereo frames, larger ones just fit fewer. */
+#define XMMS_VIS_QUEUE_SIZE (64 * 1024)
+
+/* Header of a frame in the queue, followed by size samples. */
+typedef struct {
+	struct timeval time;
+	gint channels;
+	gint size;
+} xmms_vis_frame_t;
+
 static int32_t xmms_visualization_client_query_version (xmms_visualization_t *vis, xmms_error_t *err);
 static int32_t xmms_visualization_client_register (xmms_visualization_t *vis, xmms_error_t *err);
 static int32_t xmms_visualization_client_init_shm (xmms_visualization_t *vis, int32_t id, const char *shmid, xmms_error_t *err);
@@ -40,6 +50,7 @@ static int32_t xmms_visualization_client_set_property (xmms_visualization_t *vis
 static int32_t xmms_visualization_client_set_properties (xmms_visualization_t *vis, int32_t id, xmmsv_t *prop, xmms_error_t *err);
 static void xmms_visualization_client_shutdown (xmms_visualization_t *vis, int32_t id, xmms_error_t *err);
 static void xmms_visualization_destroy (xmms_object_t *object);
+static gpointer xmms_visualization_thread (gpointer data);
 
 #include "visualization/object_ipc.c"
 
@@ -114,9 +125,13 @@ xmms_visualization_new (xmms_output_t *output)
 {
 	vis = xmms_object_new (xmms_visualization_t, xmms_visualization_destroy);
 	g_mutex_init (&vis->clientlock);
+	g_mutex_init (&vis->producer_lock);
 	vis->clientc = 0;
 	vis->output = output;
 
+	vis->frames = xmms_ringbuf_new_lockfree (XMMS_VIS_QUEUE_SIZE, NULL);
+	vis->thread = g_thread_new ("x2 vis", xmms_visualization_thread, vis);
+
 	xmms_object_ref (output);
 
 	xmms_visualization_register_ipc_commands (XMMS_OBJECT (vis));
@@ -136,6 +151,14 @@ xmms_visualization_destroy (xmms_object_t *object)
 {
 	XMMS_DBG ("Deactivating visualization object.");
 
+	xmms_ringbuf_set_eos (vis->frames, TRUE);
+	g_thread_join (vis->thread);
+	xmms_ringbuf_destroy (vis->frames);
+	g_mutex_clear (&vis->producer_lock);
+
+	XMMS_DBG ("Visualization sent %d frames, dropped %d",
+	          vis->frames_sent, vis->frames_dropped);
+
 	xmms_object_unref (vis->output);
 
 	/* TODO: assure that the xform is already dead! */
@@ -169,6 +192,7 @@ properties_init (xmmsc_vis_properties_t *p)
 	p->type = VIS_PCM;
 	p->stereo = 1;
 	p->pcm_hardwire = 0;
+	p->spectrum_size = XMMSC_VISUALIZATION_WINDOW_SIZE;
 }
 
 static gboolean
@@ -188,6 +212,11 @@ property_set (xmmsc_vis_properties_t *p, const gchar* key, const gchar* data)
 		p->stereo = (atoi (data) > 0);
 	} else if (!g_ascii_strcasecmp (key, "pcm.hardwire")) {
 		p->pcm_hardwire = (atoi (data) > 0);
+	} else if (!g_ascii_strcasecmp (key, "spectrum.size")) {
+		if (!fft_size_valid (atoi (data))) {
+			return FALSE;
+		}
+		p->spectrum_size = atoi (data);
 	/* TODO: all the stuff following */
 	} else if (!g_ascii_strcasecmp (key, "timeframe")) {
 		p->timeframe = g_strtod (data, NULL);
@@ -313,11 +342,15 @@ package_write (xmms_vis_client_t *c, int32_t id, struct timeval *time, int chann
 	return FALSE;
 }
 
+/**
+ * Queue samples for the vis thread. Called on the decoding side, so
+ * this never blocks: if the queue is full, or another chain is queueing
+ * at the same time, the frame is dropped and counted.
+ */
 void
 send_data (int channels, int size, short *buf)
 {
-	int i;
-	struct timeval time;
+	xmms_vis_frame_t frame;
 	guint32 latency;
 
 	if (!vis) {
@@ -326,23 +359,90 @@ send_data (int channels, int size, short *buf)
 
 	latency = xmms_output_latency (vis->output);
 
-	fft_init ();
+	gettimeofday (&frame.time, NULL);
+	frame.time.tv_sec += (latency / 1000);
+	frame.time.tv_usec += (latency % 1000) * 1000;
+	if (frame.time.tv_usec > 1000000) {
+		frame.time.tv_sec++;
+		frame.time.tv_usec -= 1000000;
+	}
+	frame.channels = channels;
+	frame.size = size;
 
-	gettimeofday (&time, NULL);
-	time.tv_sec += (latency / 1000);
-	time.tv_usec += (latency % 1000) * 1000;
-	if (time.tv_usec > 1000000) {
-		time.tv_sec++;
-		time.tv_usec -= 1000000;
+	if (!g_mutex_trylock (&vis->producer_lock)) {
+		g_atomic_int_inc (&vis->frames_dropped);
+		return;
 	}
 
-	g_mutex_lock (&vis->clientlock);
-	for (i = 0; i < vis->clientc; ++i) {
-		if (vis->clientv[i]) {
-			package_write (vis->clientv[i], i, &time, channels, size, buf);
+	/* only the vis thread frees space, so the check stays valid */
+	if (xmms_ringbuf_bytes_free (vis->frames) < sizeof (frame) + size * sizeof (short)) {
+		g_atomic_int_inc (&vis->frames_dropped);
+	} else {
+		xmms_ringbuf_write (vis->frames, &frame, sizeof (frame));
+		xmms_ringbuf_write (vis->frames, buf, size * sizeof (short));
+	}
+
+	g_mutex_unlock (&vis->producer_lock);
+}
+
+/**
+ * Run the transforms and write the queued frames to the clients.
+ */
+static gpointer
+xmms_visualization_thread (gpointer data)
+{
+	xmms_visualization_t *vis = data;
+	xmms_vis_frame_t frame;
+	short *buf = NULL;
+	gint bufsize = 0;
+	int i;
+
+	while (TRUE) {
+		xmms_ringbuf_wait_used (vis->frames, sizeof (frame), NULL);
+		if (xmms_ringbuf_iseos (vis->frames)) {
+			break;
+		}
+
+		xmms_ringbuf_read (vis->frames, &frame, sizeof (frame));
+
+		if (frame.size > bufsize) {
+			bufsize = frame.size;
+			buf = g_renew (short, buf, bufsize);
+		}
+		if (frame.size > 0) {
+			xmms_ringbuf_read_wait (vis->frames, buf, frame.size * sizeof (short), NULL);
+		}
+
+		fft_frame (frame.channels, frame.size, buf);
+
+		g_mutex_lock (&vis->clientlock);
+		for (i = 0; i < vis->clientc; ++i) {
+			if (vis->clientv[i]) {
+				package_write (vis->clientv[i], i, &frame.time, frame.channels, frame.size, buf);
+			}
 		}
+		g_mutex_unlock (&vis->clientlock);
+
+		g_atomic_int_inc (&vis->frames_sent);
 	}
-	g_mutex_unlock (&vis->clientlock);
+
+	g_free (buf);
+
+	return NULL;
+}
+
+/**
+ * Get the number of frames handed to the clients, and the number
+ * dropped because the vis thread could not keep up.
+ */
+void
+xmms_visualization_stats_get (xmms_visualization_t *vis, guint *frames_sent,
+                              guint *frames_dropped)
+{
+	g_return_if_fail (vis);
+
+	*frames_sent = g_atomic_int_get (&vis->frames_sent);
+	*frames_dropped = g_atomic_int_get (&vis->frames_dropped);
 }
 
 /** @} */
@@ -67,6 +67,18 @@ struct xmms_xform_St {
 	xmmsv_t *browse_dict;
 	gint browse_index;
 
+	/** number of reads asked of this xform, and passed on to the plugin */
+	guint64 read_calls;
+	guint64 plugin_read_calls;
+
+	/** profiling counters, only updated by the thread reading the chain */
+	guint64 bytes_out;
+	guint64 read_usec;
+	guint64 read_usec_max;
+	guint64 seek_calls;
+	guint64 seek_usec;
+	guint64 reallocs;
+
 	/** used for line reading */
 	struct {
 		gchar buf[XMMS_XFORM_MAX_LINE_SIZE];
@@ -89,10 +101,21 @@ const char *xmms_xform_shortname (xmms_xform_t *xform);
 static xmms_xform_t *add_effects (xmms_xform_t *last,
                                   xmms_medialib_entry_t entry,
                                   GList *goal_formats);
+static xmms_xform_t *add_effect_stage (xmms_xform_t *last,
+                                       xmms_medialib_entry_t entry,
+                                       GList *goal_formats,
+                                       GList *plugins);
 static xmms_xform_t *xmms_xform_new_effect (xmms_xform_t* last,
                                             xmms_medialib_entry_t entry,
                                             GList *goal_formats,
                                             const gchar *name);
+static xmms_xform_t *chain_setup_url_session (xmms_medialib_t *medialib,
+                                              xmms_medialib_session_t *session,
+                                              xmms_medialib_entry_t entry,
+                                              const gchar *url,
+                                              GList *goal_formats,
+                                              gboolean rehash,
+                                              gboolean metadata_only);
 static void xmms_xform_destroy (xmms_object_t *object);
 static xmms_stream_type_t *xmms_xform_get_out_stream_type (xmms_xform_t *xform);
 
@@ -843,9 +866,12 @@ xmms_xform_this_peek (xmms_xform_t *xform, gpointer buf, gint siz,
 	while (xform->buffered < siz) {
 		gint res;
 
+		xform->plugin_read_calls++;
+
 		if (xform->buffered + READ_CHUNK > xform->buffersize) {
 			xform->buffersize *= 2;
 			xform->buffer = g_realloc (xform->buffer, xform->buffersize);
+			xform->reallocs++;
 		}
 
 		res = xmms_xform_plugin_read (xform->plugin, xform,
@@ -906,9 +932,9 @@ xmms_xform_hotspots_update (xmms_xform_t *xform)
 	return ret;
 }
 
-gint
-xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
-                      xmms_error_t *err)
+static gint
+xmms_xform_this_read_unprofiled (xmms_xform_t *xform, gpointer buf, gint siz,
+                                 xmms_error_t *err)
 {
 	gint read = 0;
 	gint nexths;
@@ -946,6 +972,7 @@ xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
 	while (read < siz) {
 		gint res;
 
+		xform->plugin_read_calls++;
 		res = xmms_xform_plugin_read (xform->plugin, xform, buf + read, siz - read, err);
 		if (xform->metadata_collected && xform->metadata_changed)
 			xmms_xform_metadata_update (xform);
@@ -971,6 +998,7 @@ xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
 					                         xform->buffersize + res);
 					xform->buffer = g_realloc (xform->buffer,
 					                           xform->buffersize);
+					xform->reallocs++;
 				}
 
 				g_memmove (xform->buffer + xform->buffered, buf + read, res);
@@ -984,9 +1012,70 @@ xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
 	return read;
 }
 
-gint64
-xmms_xform_this_seek (xmms_xform_t *xform, gint64 offset,
-                      xmms_xform_seek_mode_t whence, xmms_error_t *err)
+gint
+xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
+                      xmms_error_t *err)
+{
+	gint64 start, elapsed;
+	gint ret;
+
+	xform->read_calls++;
+
+	start = g_get_monotonic_time ();
+	ret = xmms_xform_this_read_unprofiled (xform, buf, siz, err);
+	elapsed = g_get_monotonic_time () - start;
+
+	xform->read_usec += elapsed;
+	xform->read_usec_max = MAX (xform->read_usec_max, elapsed);
+	if (ret > 0) {
+		xform->bytes_out += ret;
+	}
+
+	return ret;
+}
+
+/**
+ * Run the process method of an effect xform over @a frames frames of
+ * float samples in @a buf.
+ */
+void
+xmms_xform_this_process (xmms_xform_t *xform, gfloat *buf, gint frames)
+{
+	xmms_xform_plugin_process (xform->plugin, xform, buf, frames);
+}
+
+/**
+ * Check whether the process method of an effect xform would change
+ * the samples at all.
+ */
+gboolean
+xmms_xform_this_active (xmms_xform_t *xform)
+{
+	return xmms_xform_plugin_active (xform->plugin, xform);
+}
+
+/**
+ * Sum up the read counters of every xform in the chain ending in @a xform.
+ *
+ * @param reads number of reads asked of the xforms
+ * @param plugin_reads number of those that reached the plugins
+ */
+void
+xmms_xform_chain_read_calls (xmms_xform_t *xform, guint64 *reads,
+                             guint64 *plugin_reads)
+{
+	*reads = *plugin_reads = 0;
+
+	for (; xform; xform = xform->prev) {
+		*reads += xform->read_calls;
+		*plugin_reads += xform->plugin_read_calls;
+	}
+}
+
+static gint64
+xmms_xform_this_seek_unprofiled (xmms_xform_t *xform, gint64 offset,
+                                 xmms_xform_seek_mode_t whence,
+                                 xmms_error_t *err)
 {
 	gint64 res;
 
@@ -1023,6 +1112,66 @@ xmms_xform_this_seek (xmms_xform_t *xform, gint64 offset,
 	return res;
 }
 
+gint64
+xmms_xform_this_seek (xmms_xform_t *xform, gint64 offset,
+                      xmms_xform_seek_mode_t whence, xmms_error_t *err)
+{
+	gint64 start, res;
+
+	xform->seek_calls++;
+
+	start = g_get_monotonic_time ();
+	res = xmms_xform_this_seek_unprofiled (xform, offset, whence, err);
+	xform->seek_usec += g_get_monotonic_time () - start;
+
+	return res;
+}
+
+/**
+ * Get the profiling counters of every xform in the chain ending in
+ * @a xform, starting with the first one.
+ *
+ * The counters are updated without locking by the thread reading the
+ * chain, so the caller must make sure the chain stays alive, and the
+ * values may be off by the read in progress.  The times are inclusive
+ * of the xforms earlier in the chain, self_usec is the time spent in
+ * the xform itself.
+ *
+ * @returns a list of dicts.
+ */
+xmmsv_t *
+xmms_xform_chain_profile (xmms_xform_t *xform)
+{
+	xmmsv_t *list, *dict;
+
+	list = xmmsv_new_list ();
+
+	for (; xform; xform = xform->prev) {
+		guint64 upstream_usec, self_usec;
+
+		upstream_usec = xform->prev ? xform->prev->read_usec : 0;
+		self_usec = xform->read_usec > upstream_usec
+		          ? xform->read_usec - upstream_usec : 0;
+
+		dict = xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("name", xmms_xform_shortname (xform)),
+		                         XMMSV_DICT_ENTRY_INT ("calls", xform->read_calls),
+		                         XMMSV_DICT_ENTRY_INT ("plugin_calls", xform->plugin_read_calls),
+		                         XMMSV_DICT_ENTRY_INT ("bytes_in", xform->prev ? xform->prev->bytes_out : 0),
+		                         XMMSV_DICT_ENTRY_INT ("bytes_out", xform->bytes_out),
+		                         XMMSV_DICT_ENTRY_INT ("usec", xform->read_usec),
+		                         XMMSV_DICT_ENTRY_INT ("self_usec", self_usec),
+		                         XMMSV_DICT_ENTRY_INT ("max_usec", xform->read_usec_max),
+		                         XMMSV_DICT_ENTRY_INT ("seeks", xform->seek_calls),
+		                         XMMSV_DICT_ENTRY_INT ("seek_usec", xform->seek_usec),
+		                         XMMSV_DICT_ENTRY_INT ("reallocs", xform->reallocs),
+		                         XMMSV_DICT_END);
+		xmmsv_list_insert (list, 0, dict);
+		xmmsv_unref (dict);
+	}
+
+	return list;
+}
+
 gint
 xmms_xform_peek (xmms_xform_t *xform, gpointer buf, gint siz,
                  xmms_error_t *err)
@@ -1195,6 +1344,22 @@ xmms_xform_goal_hints_get (xmms_xform_t *xform)
 }
 
 
+/* Whether some plugin takes the output of the xform, which is as far
+ * as can be told without setting it up. */
+static gboolean
+has_decoder (xmms_xform_t *xform)
+{
+	match_state_t state;
+
+	state.out_type = xmms_xform_get_out_stream_type (xform);
+	state.match = NULL;
+	state.priority = -1;
+
+	xmms_plugin_foreach (XMMS_PLUGIN_TYPE_XFORM, xmms_xform_match, &state);
+
+	return state.match != NULL;
+}
+
 static gboolean
 has_goalformat (xmms_xform_t *xform, GList *goal_formats)
 {
@@ -1229,16 +1394,19 @@ outdata_type_metadata_collect (xmms_xform_t *xform)
 
 	type = xmms_xform_get_out_stream_type (xform);
 	mime = xmms_stream_type_get_str (type, XMMS_STREAM_TYPE_MIMETYPE);
-	if (strcmp (mime, "audio/pcm") != 0) {
-		return;
-	}
 
-	val = xmms_stream_type_get_int (type, XMMS_STREAM_TYPE_FMT_FORMAT);
-	if (val != -1) {
-		const gchar *name = xmms_sample_name_get ((xmms_sample_format_t) val);
-		xmms_xform_metadata_set_str (xform,
-		                             XMMS_MEDIALIB_ENTRY_PROPERTY_SAMPLE_FMT,
-		                             name);
+	/* a metadata-only chain may end with compressed data, which
+	 * still carries the samplerate and channels of the stream */
+	if (strcmp (mime, "audio/pcm") == 0) {
+		val = xmms_stream_type_get_int (type, XMMS_STREAM_TYPE_FMT_FORMAT);
+		if (val != -1) {
+			const gchar *name = xmms_sample_name_get ((xmms_sample_format_t) val);
+			xmms_xform_metadata_set_str (xform,
+			                             XMMS_MEDIALIB_ENTRY_PROPERTY_SAMPLE_FMT,
+			                             name);
+		}
+	} else if (strncmp (mime, "audio/", 6) != 0) {
+		return;
 	}
 
 	val = xmms_stream_type_get_int (type, XMMS_STREAM_TYPE_FMT_SAMPLERATE);
@@ -1258,7 +1426,7 @@ outdata_type_metadata_collect (xmms_xform_t *xform)
 
 static xmms_xform_t *
 chain_setup (xmms_medialib_t *medialib, xmms_medialib_entry_t entry,
-             const gchar *url, GList *goal_formats)
+             const gchar *url, GList *goal_formats, gboolean metadata_only)
 {
 	xmms_xform_t *xform, *last;
 	gchar *durl, *args;
@@ -1296,6 +1464,13 @@ chain_setup (xmms_medialib_t *medialib, xmms_medialib_entry_t entry,
 	}
 	xmms_medialib_decode_url (durl);
 
+	/* a segment of a file (from a cue sheet for example) gets its
+	 * duration from the segment plugin, which wants decoded audio */
+	if (xmms_xform_metadata_has_val (xform, XMMS_MEDIALIB_ENTRY_PROPERTY_STARTMS) ||
+	    xmms_xform_metadata_has_val (xform, XMMS_MEDIALIB_ENTRY_PROPERTY_STOPMS)) {
+		metadata_only = FALSE;
+	}
+
 	xmms_xform_outdata_type_add (xform, XMMS_STREAM_TYPE_MIMETYPE,
 	                             "application/x-url", XMMS_STREAM_TYPE_URL,
 	                             durl, XMMS_STREAM_TYPE_END);
@@ -1315,6 +1490,23 @@ chain_setup (xmms_medialib_t *medialib, xmms_medialib_entry_t entry,
 		}
 		xmms_object_unref (last);
 		last = xform;
+
+		/* everything the medialib wants is known, don't bother
+		 * initialising the decoder, as long as there is one */
+		if (metadata_only &&
+		    xmms_xform_plugin_can_metadata_only (xform->plugin)) {
+			if (!has_decoder (xform)) {
+				xmms_log_error ("Couldn't find a decoder for '%s' (%d)",
+				                durl, entry);
+				xmms_object_unref (last);
+				g_free (durl);
+
+				return NULL;
+			}
+			XMMS_DBG ("Metadata-only chain ends with '%s'",
+			          xmms_xform_shortname (xform));
+			break;
+		}
 	} while (!has_goalformat (xform, goal_formats));
 
 	g_free (durl);
@@ -1395,11 +1587,42 @@ xmms_xform_chain_setup_session (xmms_medialib_t *medialib,
 	return xform;
 }
 
+xmms_xform_t *
+xmms_xform_chain_setup_metadata_session (xmms_medialib_t *medialib,
+                                         xmms_medialib_session_t *session,
+                                         xmms_medialib_entry_t entry,
+                                         GList *goal_formats)
+{
+	gchar *url;
+	xmms_xform_t *xform;
+
+	if (!(url = get_url_for_entry (session, entry))) {
+		return NULL;
+	}
+
+	xform = chain_setup_url_session (medialib, session, entry, url,
+	                                 goal_formats, TRUE, TRUE);
+	g_free (url);
+
+	return xform;
+}
+
 xmms_xform_t *
 xmms_xform_chain_setup_url_session (xmms_medialib_t *medialib,
                                     xmms_medialib_session_t *session,
                                     xmms_medialib_entry_t entry, const gchar *url,
                                     GList *goal_formats, gboolean rehash)
+{
+	return chain_setup_url_session (medialib, session, entry, url,
+	                                goal_formats, rehash, FALSE);
+}
+
+static xmms_xform_t *
+chain_setup_url_session (xmms_medialib_t *medialib,
+                         xmms_medialib_session_t *session,
+                         xmms_medialib_entry_t entry, const gchar *url,
+                         GList *goal_formats, gboolean rehash,
+                         gboolean metadata_only)
 {
 	xmms_xform_t *last;
 	xmms_plugin_t *plugin;
@@ -1407,7 +1630,7 @@ xmms_xform_chain_setup_url_session (xmms_medialib_t *medialib,
 	gboolean add_segment = FALSE;
 	gint priority;
 
-	last = chain_setup (medialib, entry, url, goal_formats);
+	last = chain_setup (medialib, entry, url, goal_formats, metadata_only);
 	if (!last) {
 		return NULL;
 	}
@@ -1476,10 +1699,12 @@ static xmms_xform_t *
 add_effects (xmms_xform_t *last, xmms_medialib_entry_t entry,
              GList *goal_formats)
 {
+	GList *kernels = NULL;
 	gint effect_no;
 
 	for (effect_no = 0; TRUE; effect_no++) {
 		xmms_config_property_t *cfg;
+		xmms_xform_plugin_t *plugin;
 		gchar key[64];
 		const gchar *name;
 
@@ -1496,10 +1721,119 @@ add_effects (xmms_xform_t *last, xmms_medialib_entry_t entry,
 			continue;
 		}
 
+		/* effects with a process method that follow each other
+		 * share a single effect stage */
+		plugin = xmms_xform_find_plugin (name);
+		if (plugin && xmms_xform_plugin_can_process (plugin)) {
+			kernels = g_list_append (kernels, plugin);
+			continue;
+		}
+
+		if (plugin) {
+			xmms_object_unref (plugin);
+		}
+
+		last = add_effect_stage (last, entry, goal_formats, kernels);
+		kernels = NULL;
+
 		last = xmms_xform_new_effect (last, entry, goal_formats, name);
 	}
 
-	return last;
+	return add_effect_stage (last, entry, goal_formats, kernels);
+}
+
+/**
+ * Add an effect stage running the process methods of @a plugins, in
+ * order.  If the stream can't be handled by the stage, or by one of the
+ * effects as it is, each effect is added as an xform of its own instead.
+ *
+ * Consumes the list and the plugin references in it.
+ */
+static xmms_xform_t *
+add_effect_stage (xmms_xform_t *last, xmms_medialib_entry_t entry,
+                  GList *goal_formats, GList *plugins)
+{
+	xmms_xform_plugin_t *stage_plugin;
+	xmms_xform_t *stage = NULL, *carrier;
+	xmms_stream_type_t *st, *float_type;
+	GList *n;
+	gint priority;
+
+	if (!plugins) {
+		return last;
+	}
+
+	st = xmms_xform_get_out_stream_type (last);
+
+	/* the kernels run on float whatever the stream is, keep to the
+	 * sample formats each effect declared it can take */
+	for (n = plugins; n; n = g_list_next (n)) {
+		if (!xmms_xform_plugin_supports (n->data, st, &priority)) {
+			break;
+		}
+	}
+
+	stage_plugin = xmms_xform_find_plugin ("effects");
+	if (stage_plugin) {
+		if (!n && xmms_xform_plugin_supports (stage_plugin, st, &priority)) {
+			stage = xmms_xform_new (stage_plugin, last, last->medialib,
+			                        entry, goal_formats);
+		}
+		xmms_object_unref (stage_plugin);
+	}
+
+	if (!stage) {
+		for (n = plugins; n; n = g_list_next (n)) {
+			const gchar *name = xmms_plugin_shortname_get (n->data);
+			last = xmms_xform_new_effect (last, entry, goal_formats, name);
+			xmms_object_unref (n->data);
+		}
+		g_list_free (plugins);
+		return last;
+	}
+
+	/* the effects see the stream as float samples through an xform
+	 * without a plugin, which also gives them the metadata of the
+	 * chain */
+	float_type = _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
+	                                    XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+	                                    XMMS_STREAM_TYPE_FMT_FORMAT,
+	                                    XMMS_SAMPLE_FORMAT_FLOAT,
+	                                    XMMS_STREAM_TYPE_FMT_CHANNELS,
+	                                    xmms_stream_type_get_int (st, XMMS_STREAM_TYPE_FMT_CHANNELS),
+	                                    XMMS_STREAM_TYPE_FMT_SAMPLERATE,
+	                                    xmms_stream_type_get_int (st, XMMS_STREAM_TYPE_FMT_SAMPLERATE),
+	                                    XMMS_STREAM_TYPE_END);
+
+	carrier = xmms_xform_new (NULL, last, last->medialib, entry, goal_formats);
+	xmms_xform_outdata_type_set (carrier, float_type);
+	xmms_object_unref (float_type);
+
+	for (n = plugins; n; n = g_list_next (n)) {
+		xmms_xform_plugin_t *plugin = n->data;
+		xmms_xform_t *kernel;
+
+		xmms_xform_plugin_config_property_register (plugin, "enabled", "0",
+		                                            NULL, NULL);
+
+		kernel = xmms_xform_new (plugin, carrier, last->medialib, entry,
+		                         goal_formats);
+		if (kernel) {
+			xmms_effect_stage_kernel_add (stage, kernel);
+			xmms_object_unref (kernel);
+		} else {
+			xmms_log_info ("Effect '%s' failed to initialize, skipping",
+			               xmms_plugin_shortname_get ((xmms_plugin_t *) plugin));
+		}
+
+		xmms_object_unref (plugin);
+	}
+	g_list_free (plugins);
+
+	xmms_object_unref (carrier);
+	xmms_object_unref (last);
+
+	return stage;
 }
 
 static xmms_xform_t *
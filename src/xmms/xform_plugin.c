@@ -25,8 +25,16 @@ struct xmms_xform_plugin_St {
 	GHashTable *metadata_mapper;
 	GList *in_types;
 	xmms_stream_type_t *default_out_type;
+	gboolean metadata_only;
+
+	/** time spent in the process method, guarded by process_stats_lock */
+	guint64 process_calls;
+	guint64 process_frames;
+	guint64 process_usec;
 };
 
+static GMutex process_stats_lock;
+
 static void
 destroy (xmms_object_t *obj)
 {
@@ -119,6 +127,14 @@ xmms_xform_plugin_get_out_stream_type (xmms_xform_plugin_t *plugin)
 	return plugin->default_out_type;
 }
 
+void
+xmms_xform_plugin_set_metadata_only (xmms_xform_plugin_t *plugin)
+{
+	g_return_if_fail (plugin);
+
+	plugin->metadata_only = TRUE;
+}
+
 gboolean
 xmms_xform_plugin_supports (const xmms_xform_plugin_t *plugin, const xmms_stream_type_t *st,
                             gint *priority)
@@ -243,6 +259,18 @@ xmms_xform_plugin_can_destroy (const xmms_xform_plugin_t *plugin)
 	return !!plugin->methods.destroy;
 }
 
+gboolean
+xmms_xform_plugin_can_metadata_only (const xmms_xform_plugin_t *plugin)
+{
+	return plugin->metadata_only;
+}
+
+gboolean
+xmms_xform_plugin_can_process (const xmms_xform_plugin_t *plugin)
+{
+	return !!plugin->methods.process;
+}
+
 gboolean
 xmms_xform_plugin_init (const xmms_xform_plugin_t *plugin, xmms_xform_t *xform)
 {
@@ -280,3 +308,76 @@ xmms_xform_plugin_destroy (const xmms_xform_plugin_t *plugin, xmms_xform_t *xfor
 	plugin->methods.destroy (xform);
 }
 
+/**
+ * Run the process method of an effect plugin, accounting the time it
+ * takes to the plugin.
+ */
+void
+xmms_xform_plugin_process (xmms_xform_plugin_t *plugin, xmms_xform_t *xform,
+                           gfloat *buf, gint frames)
+{
+	gint64 start, elapsed;
+
+	start = g_get_monotonic_time ();
+	plugin->methods.process (xform, buf, frames);
+	elapsed = g_get_monotonic_time () - start;
+
+	g_mutex_lock (&process_stats_lock);
+	plugin->process_calls++;
+	plugin->process_frames += frames;
+	plugin->process_usec += elapsed;
+	g_mutex_unlock (&process_stats_lock);
+}
+
+gboolean
+xmms_xform_plugin_active (const xmms_xform_plugin_t *plugin, xmms_xform_t *xform)
+{
+	if (!plugin->methods.active) {
+		return TRUE;
+	}
+
+	return plugin->methods.active (xform);
+}
+
+static gboolean
+xmms_xform_plugin_process_stats_foreach (xmms_plugin_t *_plugin, gpointer udata)
+{
+	xmms_xform_plugin_t *plugin = (xmms_xform_plugin_t *) _plugin;
+	xmmsv_t *dict = udata;
+	xmmsv_t *stats;
+
+	if (!plugin->methods.process) {
+		return TRUE;
+	}
+
+	g_mutex_lock (&process_stats_lock);
+	stats = xmmsv_build_dict (XMMSV_DICT_ENTRY_INT ("calls", plugin->process_calls),
+	                          XMMSV_DICT_ENTRY_INT ("frames", plugin->process_frames),
+	                          XMMSV_DICT_ENTRY_INT ("usec", plugin->process_usec),
+	                          XMMSV_DICT_END);
+	g_mutex_unlock (&process_stats_lock);
+
+	xmmsv_dict_set (dict, xmms_plugin_shortname_get (_plugin), stats);
+	xmmsv_unref (stats);
+
+	return TRUE;
+}
+
+/**
+ * Get the time spent in the process method of every effect plugin
+ * that has one.
+ *
+ * @returns a dict of plugin name to a dict of calls, frames and usec.
+ */
+xmmsv_t *
+xmms_xform_plugin_process_stats (void)
+{
+	xmmsv_t *dict;
+
+	dict = xmmsv_new_dict ();
+	xmms_plugin_foreach (XMMS_PLUGIN_TYPE_XFORM,
+	                     xmms_xform_plugin_process_stats_foreach, dict);
+
+	return dict;
+}
+
@@ -0,0 +1,90 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2017 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Measures request/response throughput against a running server while
+ * keeping a number of medialib_get_info calls in flight.
+ *
+ * Usage: bench_ipc_pipeline [calls] [in-flight] [id]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <xmmsclient/xmmsclient.h>
+
+static double
+now (void)
+{
+	struct timeval tv;
+
+	gettimeofday (&tv, NULL);
+
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int
+main (int argc, char **argv)
+{
+	xmmsc_connection_t *conn;
+	xmmsc_result_t **window;
+	xmmsv_t *value;
+	int calls, inflight, id, sent, done, errors = 0;
+	double start, elapsed;
+
+	calls = argc > 1 ? atoi (argv[1]) : 100000;
+	inflight = argc > 2 ? atoi (argv[2]) : 1000;
+	id = argc > 3 ? atoi (argv[3]) : 1;
+
+	if (calls <= 0 || inflight <= 0) {
+		fprintf (stderr, "usage: %s [calls] [in-flight] [id]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	conn = xmmsc_init ("bench-ipc-pipeline");
+	if (!xmmsc_connect (conn, getenv ("XMMS_PATH"))) {
+		fprintf (stderr, "connection failed: %s\n", xmmsc_get_last_error (conn));
+		return EXIT_FAILURE;
+	}
+
+	window = calloc (inflight, sizeof (xmmsc_result_t *));
+
+	start = now ();
+
+	/* keep the window full, waiting on the oldest call each time */
+	for (sent = 0, done = 0; done < calls; done++) {
+		while (sent < calls && sent - done < inflight) {
+			window[sent % inflight] = xmmsc_medialib_get_info (conn, id);
+			sent++;
+		}
+
+		xmmsc_result_wait (window[done % inflight]);
+		value = xmmsc_result_get_value (window[done % inflight]);
+		if (xmmsv_is_error (value)) {
+			errors++;
+		}
+		xmmsc_result_unref (window[done % inflight]);
+	}
+
+	elapsed = now () - start;
+
+	printf ("%d calls, %d in flight, %d errors\n", calls, inflight, errors);
+	printf ("%.2f s, %.0f calls/s\n", elapsed, calls / elapsed);
+
+	free (window);
+	xmmsc_unref (conn);
+
+	return EXIT_SUCCESS;
+}
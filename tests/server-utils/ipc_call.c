@@ -32,24 +32,22 @@ struct xmms_future_St {
 	GCond cond;
 };
 
-xmmsv_t *
-__xmms_ipc_call (xmms_object_t *object, gint cmd, ...)
+static xmmsv_t *
+xmms_ipc_call_valist (xmms_object_t *object, gint32 client, gint cmd, va_list ap)
 {
 	xmms_object_cmd_arg_t arg;
 	xmmsv_t *entry, *params;
-	va_list ap;
 
 	params = xmmsv_new_list ();
 
-	va_start (ap, cmd);
 	while ((entry = va_arg (ap, xmmsv_t *)) != NULL) {
 		xmmsv_list_append (params, entry);
 		xmmsv_unref (entry);
 	}
-	va_end (ap);
 
 	xmms_object_cmd_arg_init (&arg);
 	arg.args = params;
+	arg.client = client;
 
 	xmms_object_cmd_call (XMMS_OBJECT (object), cmd, &arg);
 	xmmsv_unref (params);
@@ -65,6 +63,32 @@ __xmms_ipc_call (xmms_object_t *object, gint cmd, ...)
 	return xmmsv_new_error (arg.error.message);
 }
 
+xmmsv_t *
+__xmms_ipc_call (xmms_object_t *object, gint cmd, ...)
+{
+	xmmsv_t *ret;
+	va_list ap;
+
+	va_start (ap, cmd);
+	ret = xmms_ipc_call_valist (object, 0, cmd, ap);
+	va_end (ap);
+
+	return ret;
+}
+
+xmmsv_t *
+__xmms_ipc_call_as (xmms_object_t *object, gint32 client, gint cmd, ...)
+{
+	xmmsv_t *ret;
+	va_list ap;
+
+	va_start (ap, cmd);
+	ret = xmms_ipc_call_valist (object, client, cmd, ap);
+	va_end (ap);
+
+	return ret;
+}
+
 static void
 future_callback (xmms_object_t *object, xmmsv_t *val, gpointer udata)
 {
@@ -26,6 +26,10 @@
 xmmsv_t *__xmms_ipc_call (xmms_object_t *object, gint cmd, ...) XMMS_SENTINEL(0);
 #define XMMS_IPC_CALL(obj, cmd, ...) __xmms_ipc_call (XMMS_OBJECT (obj), cmd, __VA_ARGS__, NULL);
 
+/* Same as XMMS_IPC_CALL, made on behalf of the given client id */
+xmmsv_t *__xmms_ipc_call_as (xmms_object_t *object, gint32 client, gint cmd, ...) XMMS_SENTINEL(0);
+#define XMMS_IPC_CALL_AS(obj, client, cmd, ...) __xmms_ipc_call_as (XMMS_OBJECT (obj), client, cmd, __VA_ARGS__, NULL);
+
 typedef struct xmms_future_St xmms_future_t;
 
 xmms_future_t *__xmms_ipc_check_signal (xmms_object_t *object, gint message, glong delay, glong timeout);
@@ -0,0 +1,98 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2017 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Adds entries to an in-memory medialib and prints the insert rate for
+ * each block of entries, to show whether it drops as the library grows.
+ *
+ * Usage: bench_medialib_import [entries] [block] [session-size]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <glib.h>
+
+#include <xmmspriv/xmms_log.h>
+#include <xmmspriv/xmms_ipc.h>
+#include <xmmspriv/xmms_config.h>
+#include <xmmspriv/xmms_medialib.h>
+
+int
+main (int argc, char **argv)
+{
+	xmms_medialib_session_t *session;
+	xmms_medialib_t *medialib;
+	xmms_error_t err;
+	gint entries, block, batch, i;
+	gint64 start, block_start, now;
+
+	entries = argc > 1 ? atoi (argv[1]) : 500000;
+	block = argc > 2 ? atoi (argv[2]) : 50000;
+	batch = argc > 3 ? atoi (argv[3]) : 256;
+
+	if (entries <= 0 || block <= 0 || batch <= 0) {
+		fprintf (stderr, "usage: %s [entries] [block] [session-size]\n",
+		         argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	xmms_ipc_init ();
+	xmms_log_init (0);
+	xmms_config_init ("memory://");
+	xmms_config_property_register ("medialib.path", "memory://", NULL, NULL);
+
+	medialib = xmms_medialib_init ();
+
+	xmms_error_reset (&err);
+
+	printf ("%10s %12s\n", "entries", "entries/s");
+
+	start = block_start = g_get_monotonic_time ();
+	session = xmms_medialib_session_begin (medialib);
+
+	for (i = 1; i <= entries; i++) {
+		gchar *url = g_strdup_printf ("file:///music/%08d.flac", i);
+
+		if (!xmms_medialib_entry_new (session, url, &err)) {
+			fprintf (stderr, "could not add %s\n", url);
+			g_free (url);
+			xmms_medialib_session_abort (session);
+			return EXIT_FAILURE;
+		}
+		g_free (url);
+
+		if (i % batch == 0 || i == entries) {
+			xmms_medialib_session_commit (session);
+			if (i < entries) {
+				session = xmms_medialib_session_begin (medialib);
+			}
+		}
+
+		if (i % block == 0) {
+			now = g_get_monotonic_time ();
+			printf ("%10d %12.0f\n", i, block / ((now - block_start) / 1e6));
+			block_start = now;
+		}
+	}
+
+	now = g_get_monotonic_time ();
+	printf ("%d entries in %.2f s\n", entries, (now - start) / 1e6);
+
+	xmms_object_unref (medialib);
+	xmms_config_shutdown ();
+	xmms_ipc_shutdown ();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2017 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Times the sample converter for each resampler quality setting.
+ *
+ * Usage: bench_resampler [from-rate] [to-rate] [channels] [seconds]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <glib.h>
+
+#include <xmmspriv/xmms_converter.h>
+#include <xmmspriv/xmms_streamtype.h>
+#include <xmms/xmms_object.h>
+#include <xmms/xmms_sample.h>
+
+#define CHUNK_FRAMES 4096
+
+static xmms_stream_type_t *
+pcm_type (gint rate, gint channels)
+{
+	return _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
+	                              XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+	                              XMMS_STREAM_TYPE_FMT_FORMAT, XMMS_SAMPLE_FORMAT_S16,
+	                              XMMS_STREAM_TYPE_FMT_CHANNELS, channels,
+	                              XMMS_STREAM_TYPE_FMT_SAMPLERATE, rate,
+	                              XMMS_STREAM_TYPE_END);
+}
+
+int
+main (int argc, char **argv)
+{
+	static const gchar *qualities[] = { "linear", "low", "medium", "high" };
+	xmms_stream_type_t *from, *to;
+	xmms_sample_converter_t *conv;
+	gint16 *chunk;
+	gint from_rate, to_rate, channels, seconds, i, j;
+	guint q;
+	gint64 frames, produced, start, elapsed;
+
+	from_rate = argc > 1 ? atoi (argv[1]) : 44100;
+	to_rate = argc > 2 ? atoi (argv[2]) : 48000;
+	channels = argc > 3 ? atoi (argv[3]) : 2;
+	seconds = argc > 4 ? atoi (argv[4]) : 60;
+
+	if (from_rate <= 0 || to_rate <= 0 || channels <= 0 || seconds <= 0) {
+		fprintf (stderr, "usage: %s [from-rate] [to-rate] [channels] [seconds]\n",
+		         argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* a 1 kHz tone, restarted every chunk; the content does not matter
+	 * for the timing */
+	chunk = g_new (gint16, CHUNK_FRAMES * channels);
+	for (i = 0; i < CHUNK_FRAMES; i++) {
+		for (j = 0; j < channels; j++) {
+			chunk[i * channels + j] = 16000 * sin (2 * M_PI * 1000.0 * i / from_rate);
+		}
+	}
+
+	from = pcm_type (from_rate, channels);
+	to = pcm_type (to_rate, channels);
+
+	printf ("%d Hz -> %d Hz, %d channels, %d s of audio\n",
+	        from_rate, to_rate, channels, seconds);
+
+	for (q = 0; q < G_N_ELEMENTS (qualities); q++) {
+		xmms_sample_t *out;
+		guint outlen;
+
+		conv = xmms_sample_converter_init (from, to,
+		                                   xmms_sample_resample_quality_from_string (qualities[q]));
+		if (!conv) {
+			fprintf (stderr, "could not create converter\n");
+			return EXIT_FAILURE;
+		}
+
+		produced = 0;
+		start = g_get_monotonic_time ();
+		for (frames = 0; frames < (gint64) from_rate * seconds; frames += CHUNK_FRAMES) {
+			xmms_sample_convert (conv, chunk, CHUNK_FRAMES * channels * sizeof (gint16),
+			                     &out, &outlen);
+			produced += outlen / (channels * sizeof (gint16));
+		}
+		elapsed = g_get_monotonic_time () - start;
+
+		printf ("%-7s %10" G_GINT64_FORMAT " frames out %8.2f ms %7.1fx realtime\n",
+		        qualities[q], produced, elapsed / 1000.0,
+		        (double) frames / from_rate / (elapsed / 1e6));
+
+		xmms_object_unref (conv);
+	}
+
+	xmms_object_unref (from);
+	xmms_object_unref (to);
+	g_free (chunk);
+
+	return EXIT_SUCCESS;
+}
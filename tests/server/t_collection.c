@@ -507,6 +507,160 @@ CASE (test_client_query_infos2)
 	xmmsv_unref (ordered);
 }
 
+CASE (test_client_query_cursor) {
+	xmmsv_t *universe, *ordered, *order, *fetch, *result, *expected;
+	gint32 cursor;
+
+	xmms_mock_entry (medialib, 3, "Red Fang", "Murder the Mountains", "Wires");
+	xmms_mock_entry (medialib, 1, "Red Fang", "Murder the Mountains", "Malverde");
+	xmms_mock_entry (medialib, 2, "Red Fang", "Murder the Mountains", "Hank Is Dead");
+
+	universe = xmmsv_new_coll (XMMS_COLLECTION_TYPE_UNIVERSE);
+	order = xmmsv_build_list (XMMSV_LIST_ENTRY_STR ("tracknr"),
+	                          XMMSV_LIST_END);
+	ordered = xmmsv_coll_add_order_operators (universe, order);
+	xmmsv_unref (universe);
+	xmmsv_unref (order);
+
+	fetch = xmmsv_from_xson ("{ 'type': 'cluster-list', 'cluster-by': 'position', "
+	                         "  'data': { 'type': 'metadata', 'fields': ['title'], "
+	                         "            'get': ['value'], 'aggregate': 'first' } }");
+
+	result = XMMS_IPC_CALL (dag, XMMS_IPC_COMMAND_COLLECTION_QUERY_OPEN,
+	                        ordered, fetch);
+	CU_ASSERT_TRUE (xmmsv_get_int (result, &cursor));
+	xmmsv_unref (result);
+
+	result = XMMS_IPC_CALL (dag, XMMS_IPC_COMMAND_COLLECTION_QUERY_NEXT,
+	                        xmmsv_new_int (cursor), xmmsv_new_int (2));
+	expected = xmmsv_from_xson ("['Malverde', 'Hank Is Dead']");
+	CU_ASSERT (xmmsv_compare (expected, result));
+	xmmsv_unref (expected);
+	xmmsv_unref (result);
+
+	result = XMMS_IPC_CALL (dag, XMMS_IPC_COMMAND_COLLECTION_QUERY_NEXT,
+	                        xmmsv_new_int (cursor), xmmsv_new_int (2));
+	expected = xmmsv_from_xson ("['Wires']");
+	CU_ASSERT (xmmsv_compare (expected, result));
+	xmmsv_unref (expected);
+	xmmsv_unref (result);
+
+	/* exhausted, which also closes the cursor */
+	result = XMMS_IPC_CALL (dag, XMMS_IPC_COMMAND_COLLECTION_QUERY_NEXT,
+	                        xmmsv_new_int (cursor), xmmsv_new_int (2));
+	CU_ASSERT (xmmsv_is_type (result, XMMSV_TYPE_NONE));
+	xmmsv_unref (result);
+
+	result = XMMS_IPC_CALL (dag, XMMS_IPC_COMMAND_COLLECTION_QUERY_CLOSE,
+	                        xmmsv_new_int (cursor));
+	CU_ASSERT (xmmsv_is_type (result, XMMSV_TYPE_ERROR));
+	xmmsv_unref (result);
+}
+
+CASE (test_client_query_cursor_owner) {
+	xmmsv_t *universe, *fetch, *result;
+	gint32 cursor;
+
+	xmms_mock_entry (medialib, 1, "Red Fang", "Murder the Mountains", "Malverde");
+
+	universe = xmmsv_new_coll (XMMS_COLLECTION_TYPE_UNIVERSE);
+	fetch = xmmsv_from_xson ("{ 'type': 'count' }");
+
+	result = XMMS_IPC_CALL_AS (dag, 1, XMMS_IPC_COMMAND_COLLECTION_QUERY_OPEN,
+	                           xmmsv_ref (universe), xmmsv_ref (fetch));
+	CU_ASSERT_TRUE (xmmsv_get_int (result, &cursor));
+	xmmsv_unref (result);
+
+	/* another client can neither read nor close it */
+	result = XMMS_IPC_CALL_AS (dag, 2, XMMS_IPC_COMMAND_COLLECTION_QUERY_NEXT,
+	                           xmmsv_new_int (cursor), xmmsv_new_int (1));
+	CU_ASSERT (xmmsv_is_type (result, XMMSV_TYPE_ERROR));
+	xmmsv_unref (result);
+
+	result = XMMS_IPC_CALL_AS (dag, 2, XMMS_IPC_COMMAND_COLLECTION_QUERY_CLOSE,
+	                           xmmsv_new_int (cursor));
+	CU_ASSERT (xmmsv_is_type (result, XMMSV_TYPE_ERROR));
+	xmmsv_unref (result);
+
+	/* the owner going away drops it */
+	xmms_object_emit (XMMS_OBJECT (xmms_ipc_manager_get ()),
+	                  XMMS_IPC_SIGNAL_IPC_MANAGER_CLIENT_DISCONNECTED,
+	                  xmmsv_new_int (1));
+
+	result = XMMS_IPC_CALL_AS (dag, 1, XMMS_IPC_COMMAND_COLLECTION_QUERY_NEXT,
+	                           xmmsv_new_int (cursor), xmmsv_new_int (1));
+	CU_ASSERT (xmmsv_is_type (result, XMMSV_TYPE_ERROR));
+	xmmsv_unref (result);
+
+	xmmsv_unref (fetch);
+	xmmsv_unref (universe);
+}
+
+CASE (test_client_query_cache) {
+	xmmsv_t *universe, *reference, *fetch, *result, *cached;
+	gint count;
+
+	xmms_mock_entry (medialib, 1, "Red Fang", "Murder the Mountains", "Malverde");
+
+	universe = xmmsv_new_coll (XMMS_COLLECTION_TYPE_UNIVERSE);
+	fetch = xmmsv_from_xson ("{ 'type': 'count' }");
+
+	result = XMMS_IPC_CALL (dag, XMMS_IPC_COMMAND_COLLECTION_QUERY,
+	                        xmmsv_ref (universe), xmmsv_ref (fetch));
+	CU_ASSERT (xmmsv_get_int (result, &count));
+	CU_ASSERT_EQUAL (1, count);
+
+	/* the same query hands out the cached result itself */
+	cached = XMMS_IPC_CALL (dag, XMMS_IPC_COMMAND_COLLECTION_QUERY,
+	                        xmmsv_ref (universe), xmmsv_ref (fetch));
+	CU_ASSERT_PTR_EQUAL (result, cached);
+	xmmsv_unref (cached);
+	xmmsv_unref (result);
+
+	/* a new entry must not be hidden by the cached result */
+	xmms_mock_entry (medialib, 2, "Red Fang", "Murder the Mountains", "Hank Is Dead");
+
+	result = XMMS_IPC_CALL (dag, XMMS_IPC_COMMAND_COLLECTION_QUERY,
+	                        xmmsv_ref (universe), xmmsv_ref (fetch));
+	CU_ASSERT (xmmsv_get_int (result, &count));
+	CU_ASSERT_EQUAL (2, count);
+	xmmsv_unref (result);
+
+	/* neither must a change to a referenced collection */
+	result = XMMS_IPC_CALL (dag, XMMS_IPC_COMMAND_COLLECTION_SAVE,
+	                        xmmsv_new_string ("Test"),
+	                        xmmsv_new_string (XMMS_COLLECTION_NS_COLLECTIONS),
+	                        xmmsv_new_coll (XMMS_COLLECTION_TYPE_IDLIST));
+	xmmsv_unref (result);
+
+	reference = xmmsv_new_coll (XMMS_COLLECTION_TYPE_REFERENCE);
+	xmmsv_coll_attribute_set_string (reference, "reference", "Test");
+	xmmsv_coll_attribute_set_string (reference, "namespace",
+	                                 XMMS_COLLECTION_NS_COLLECTIONS);
+
+	result = XMMS_IPC_CALL (dag, XMMS_IPC_COMMAND_COLLECTION_QUERY,
+	                        xmmsv_ref (reference), xmmsv_ref (fetch));
+	CU_ASSERT (xmmsv_get_int (result, &count));
+	CU_ASSERT_EQUAL (0, count);
+	xmmsv_unref (result);
+
+	result = XMMS_IPC_CALL (dag, XMMS_IPC_COMMAND_COLLECTION_SAVE,
+	                        xmmsv_new_string ("Test"),
+	                        xmmsv_new_string (XMMS_COLLECTION_NS_COLLECTIONS),
+	                        xmmsv_ref (universe));
+	xmmsv_unref (result);
+
+	result = XMMS_IPC_CALL (dag, XMMS_IPC_COMMAND_COLLECTION_QUERY,
+	                        xmmsv_ref (reference), xmmsv_ref (fetch));
+	CU_ASSERT (xmmsv_get_int (result, &count));
+	CU_ASSERT_EQUAL (2, count);
+	xmmsv_unref (result);
+
+	xmmsv_unref (reference);
+	xmmsv_unref (universe);
+	xmmsv_unref (fetch);
+}
+
 CASE (test_reject_direct_cyclic_collections)
 {
 	xmmsv_t *reference, *result;
@@ -0,0 +1,188 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2017 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include "xcu.h"
+
+#include <math.h>
+#include <glib.h>
+
+#include <xmmspriv/xmms_converter.h>
+#include <xmmspriv/xmms_streamtype.h>
+#include <xmms/xmms_object.h>
+#include <xmms/xmms_sample.h>
+
+#define CHUNK_FRAMES 4096
+
+/* output frames skipped while the history of the filter fills up */
+#define SETTLE_FRAMES 256
+
+static const struct {
+	xmms_sample_resample_quality_t quality;
+	gdouble max_thdn;
+} qualities[] = {
+	{ XMMS_SAMPLE_RESAMPLE_LINEAR, -55.0 },
+	{ XMMS_SAMPLE_RESAMPLE_LOW, -75.0 },
+	{ XMMS_SAMPLE_RESAMPLE_MEDIUM, -80.0 },
+	{ XMMS_SAMPLE_RESAMPLE_HIGH, -80.0 },
+};
+
+SETUP (converter) {
+	return 0;
+}
+
+CLEANUP () {
+	return 0;
+}
+
+static xmms_stream_type_t *
+pcm_type (gint rate, gint channels)
+{
+	return _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
+	                              XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+	                              XMMS_STREAM_TYPE_FMT_FORMAT, XMMS_SAMPLE_FORMAT_S16,
+	                              XMMS_STREAM_TYPE_FMT_CHANNELS, channels,
+	                              XMMS_STREAM_TYPE_FMT_SAMPLERATE, rate,
+	                              XMMS_STREAM_TYPE_END);
+}
+
+/* Run frames frames of S16 input through a converter, in chunks, and
+ * return everything it produced. */
+static gint16 *
+convert_all (xmms_stream_type_t *from, xmms_stream_type_t *to,
+             xmms_sample_resample_quality_t quality,
+             const gint16 *in, gint frames, gint channels, gint *outframes)
+{
+	xmms_sample_converter_t *conv;
+	GArray *result;
+	gint i;
+
+	conv = xmms_sample_converter_init (from, to, quality);
+	CU_ASSERT_PTR_NOT_NULL_FATAL (conv);
+
+	result = g_array_new (FALSE, FALSE, sizeof (gint16));
+
+	for (i = 0; i < frames; i += CHUNK_FRAMES) {
+		xmms_sample_t *out;
+		guint outlen;
+
+		xmms_sample_convert (conv, (xmms_sample_t *) &in[i * channels],
+		                     MIN (CHUNK_FRAMES, frames - i) * channels * sizeof (gint16),
+		                     &out, &outlen);
+		g_array_append_vals (result, out, outlen / sizeof (gint16));
+	}
+
+	xmms_object_unref (conv);
+
+	*outframes = result->len / channels;
+
+	return (gint16 *) g_array_free (result, FALSE);
+}
+
+/* A constant signal has to come out unchanged, as each phase of the
+ * filter is normalised to unity gain. */
+CASE (test_resample_dc)
+{
+	xmms_stream_type_t *from, *to;
+	gint16 *in, *out;
+	gint frames = 48000, outframes, i;
+	guint q;
+
+	from = pcm_type (48000, 2);
+	to = pcm_type (44100, 2);
+
+	in = g_new (gint16, frames * 2);
+	for (i = 0; i < frames; i++) {
+		in[i * 2] = 10000;
+		in[i * 2 + 1] = -10000;
+	}
+
+	for (q = 0; q < G_N_ELEMENTS (qualities); q++) {
+		out = convert_all (from, to, qualities[q].quality, in, frames, 2, &outframes);
+
+		CU_ASSERT (ABS (outframes - 44100) <= 1);
+
+		for (i = SETTLE_FRAMES; i < outframes; i++) {
+			CU_ASSERT (ABS (out[i * 2] - 10000) <= 2);
+			CU_ASSERT (ABS (out[i * 2 + 1] + 10000) <= 2);
+		}
+
+		g_free (out);
+	}
+
+	g_free (in);
+	xmms_object_unref (from);
+	xmms_object_unref (to);
+}
+
+/* A 1 kHz tone at 44.1 kHz resampled to 48 kHz, where one period is
+ * exactly 48 frames. Fit a 1 kHz sine and dc offset to the output over
+ * whole periods, and check the amplitude of the fit and how much of the
+ * output it does not explain (THD+N). */
+CASE (test_resample_sine)
+{
+	xmms_stream_type_t *from, *to;
+	gint16 *in, *out;
+	gint frames = 44100, outframes, window, i;
+	gdouble s, c, dc, amplitude, residual, thdn;
+	guint q;
+
+	from = pcm_type (44100, 1);
+	to = pcm_type (48000, 1);
+
+	in = g_new (gint16, frames);
+	for (i = 0; i < frames; i++) {
+		in[i] = 16000 * sin (2 * M_PI * 1000.0 * i / 44100);
+	}
+
+	for (q = 0; q < G_N_ELEMENTS (qualities); q++) {
+		out = convert_all (from, to, qualities[q].quality, in, frames, 1, &outframes);
+
+		CU_ASSERT (ABS (outframes - 48000) <= 1);
+
+		window = (outframes - SETTLE_FRAMES) / 48 * 48;
+
+		s = c = dc = 0.0;
+		for (i = 0; i < window; i++) {
+			gdouble v = out[SETTLE_FRAMES + i];
+			s += v * sin (2 * M_PI * i / 48);
+			c += v * cos (2 * M_PI * i / 48);
+			dc += v;
+		}
+		s = s * 2 / window;
+		c = c * 2 / window;
+		dc = dc / window;
+
+		residual = 0.0;
+		for (i = 0; i < window; i++) {
+			gdouble e = out[SETTLE_FRAMES + i] - dc -
+			            s * sin (2 * M_PI * i / 48) -
+			            c * cos (2 * M_PI * i / 48);
+			residual += e * e;
+		}
+
+		amplitude = sqrt (s * s + c * c);
+		thdn = 10 * log10 (residual / (amplitude * amplitude / 2 * window));
+
+		CU_ASSERT (fabs (amplitude - 16000) < 160);
+		CU_ASSERT (thdn < qualities[q].max_thdn);
+
+		g_free (out);
+	}
+
+	g_free (in);
+	xmms_object_unref (from);
+	xmms_object_unref (to);
+}
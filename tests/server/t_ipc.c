@@ -0,0 +1,209 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2017 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include "xcu.h"
+
+#include <unistd.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <xmmspriv/xmms_ipc.h>
+#include <xmmspriv/xmms_log.h>
+#include <xmmspriv/xmms_config.h>
+#include <xmmsc/xmmsc_ipc_transport.h>
+
+#define START 1000000
+
+/* more than the server queues for a client before it stops reading */
+#define MESSAGES 500
+
+typedef struct {
+	xmms_object_t object;
+} echo_t;
+
+SETUP (ipc) {
+	xmms_ipc_init ();
+	xmms_log_init (0);
+	xmms_config_init ("memory://");
+
+	return 0;
+}
+
+CLEANUP () {
+	xmms_config_shutdown ();
+	xmms_ipc_shutdown ();
+
+	return 0;
+}
+
+static void
+echo_cmd (xmms_object_t *object, xmms_object_cmd_arg_t *arg)
+{
+	arg->retval = xmmsv_ref (arg->args);
+}
+
+static gint32
+value_int (xmmsv_t *value)
+{
+	gint32 i = -1;
+
+	CU_ASSERT_TRUE (xmmsv_get_int32 (value, &i));
+
+	return i;
+}
+
+CASE (test_signal_rate_unlimited)
+{
+	xmms_ipc_signal_rate_t rate = { 0, 0, NULL };
+	xmmsv_t *arg, *val;
+
+	arg = xmmsv_new_int (1);
+
+	val = xmms_ipc_signal_rate_offer (&rate, arg, START);
+	CU_ASSERT_PTR_EQUAL (arg, val);
+	xmmsv_unref (val);
+
+	val = xmms_ipc_signal_rate_offer (&rate, arg, START);
+	CU_ASSERT_PTR_EQUAL (arg, val);
+	xmmsv_unref (val);
+
+	CU_ASSERT_PTR_NULL (rate.held);
+
+	xmmsv_unref (arg);
+}
+
+CASE (test_signal_rate_limited)
+{
+	xmms_ipc_signal_rate_t rate = { 100000, 0, NULL };
+	xmmsv_t *val, *arg[5];
+	gint i;
+
+	for (i = 0; i < 5; i++) {
+		arg[i] = xmmsv_new_int (i);
+	}
+
+	/* the first value goes out right away */
+	val = xmms_ipc_signal_rate_offer (&rate, arg[0], START);
+	CU_ASSERT_EQUAL (0, value_int (val));
+	xmmsv_unref (val);
+
+	/* the ones that come too early are held back, latest wins */
+	CU_ASSERT_PTR_NULL (xmms_ipc_signal_rate_offer (&rate, arg[1], START + 10000));
+	CU_ASSERT_PTR_NULL (xmms_ipc_signal_rate_offer (&rate, arg[2], START + 20000));
+	CU_ASSERT_EQUAL (2, value_int (rate.held));
+
+	/* and delivered when the interval ends */
+	val = xmms_ipc_signal_rate_take (&rate, START + 100000);
+	CU_ASSERT_EQUAL (2, value_int (val));
+	xmmsv_unref (val);
+
+	CU_ASSERT_PTR_NULL (xmms_ipc_signal_rate_take (&rate, START + 100000));
+
+	/* the interval counts from the late delivery */
+	CU_ASSERT_PTR_NULL (xmms_ipc_signal_rate_offer (&rate, arg[3], START + 150000));
+
+	/* a value on time replaces the one held back */
+	val = xmms_ipc_signal_rate_offer (&rate, arg[4], START + 200000);
+	CU_ASSERT_EQUAL (4, value_int (val));
+	xmmsv_unref (val);
+
+	CU_ASSERT_PTR_NULL (rate.held);
+
+	/* clearing drops what is held */
+	CU_ASSERT_PTR_NULL (xmms_ipc_signal_rate_offer (&rate, arg[1], START + 210000));
+	xmms_ipc_signal_rate_clear (&rate);
+	CU_ASSERT_PTR_NULL (rate.held);
+
+	for (i = 0; i < 5; i++) {
+		xmmsv_unref (arg[i]);
+	}
+}
+
+CASE (test_workers_dispatch)
+{
+	xmms_ipc_transport_t *transport;
+	xmms_ipc_msg_t *msg;
+	xmmsv_t *args, *val;
+	echo_t *echo;
+	gchar *socket, *path;
+	gint64 deadline;
+	gint i, replies, v;
+	bool disconnected = false;
+
+	xmms_config_property_register ("core.ipc_workers", "2", NULL, NULL);
+
+	echo = xmms_object_new (echo_t, NULL);
+	xmms_object_cmd_add (XMMS_OBJECT (echo), XMMS_IPC_COMMAND_FIRST, echo_cmd);
+	xmms_ipc_object_register (XMMS_IPC_OBJECT_MAIN, XMMS_OBJECT (echo));
+
+	socket = g_strdup_printf ("/tmp/xmms2-test-ipc-%d", (gint) getpid ());
+	path = g_strconcat ("unix://", socket, NULL);
+
+	CU_ASSERT_TRUE_FATAL (xmms_ipc_setup_server (path));
+	transport = xmms_ipc_client_init (path);
+	CU_ASSERT_PTR_NOT_NULL_FATAL (transport);
+
+	deadline = g_get_monotonic_time () + 10 * G_USEC_PER_SEC;
+
+	for (i = 0; i < MESSAGES; i++) {
+		args = xmmsv_build_list (XMMSV_LIST_ENTRY_INT (i), XMMSV_LIST_END);
+		msg = xmms_ipc_msg_new (XMMS_IPC_OBJECT_MAIN, XMMS_IPC_COMMAND_FIRST);
+		xmms_ipc_msg_put_value (msg, args);
+		xmms_ipc_msg_set_cookie (msg, i);
+		xmmsv_unref (args);
+
+		while (!xmms_ipc_msg_write_transport (msg, transport, &disconnected)) {
+			CU_ASSERT_FALSE_FATAL (disconnected);
+			CU_ASSERT_FATAL (g_get_monotonic_time () < deadline);
+			/* accepting the connection is up to the default context */
+			g_main_context_iteration (NULL, FALSE);
+			g_usleep (1000);
+		}
+		xmms_ipc_msg_destroy (msg);
+	}
+
+	/* every command is answered, in the order it was sent */
+	msg = xmms_ipc_msg_alloc ();
+	for (replies = 0; replies < MESSAGES; ) {
+		if (!xmms_ipc_msg_read_transport (msg, transport, &disconnected)) {
+			CU_ASSERT_FALSE_FATAL (disconnected);
+			CU_ASSERT_FATAL (g_get_monotonic_time () < deadline);
+			g_main_context_iteration (NULL, FALSE);
+			g_usleep (1000);
+			continue;
+		}
+
+		CU_ASSERT_EQUAL (XMMS_IPC_COMMAND_REPLY, xmms_ipc_msg_get_cmd (msg));
+		CU_ASSERT_EQUAL (replies, xmms_ipc_msg_get_cookie (msg));
+		CU_ASSERT_TRUE (xmms_ipc_msg_get_value (msg, &val));
+		CU_ASSERT_TRUE (xmmsv_list_get_int32 (val, 0, &v));
+		CU_ASSERT_EQUAL (replies, v);
+		xmmsv_unref (val);
+
+		xmms_ipc_msg_destroy (msg);
+		msg = xmms_ipc_msg_alloc ();
+		replies++;
+	}
+	xmms_ipc_msg_destroy (msg);
+
+	xmms_ipc_transport_destroy (transport);
+	xmms_ipc_object_unregister (XMMS_IPC_OBJECT_MAIN);
+	xmms_object_unref (echo);
+
+	g_unlink (socket);
+	g_free (socket);
+	g_free (path);
+}
@@ -198,16 +198,67 @@ CASE (test_not_resolved)
 	                                      XMMS_MEDIALIB_ENTRY_STATUS_NEW);
 	xmms_medialib_session_commit(session);
 
+	count = xmms_medialib_num_not_resolved (medialib);
+	CU_ASSERT_EQUAL (2, count);
+
+	entry = xmms_medialib_entry_not_resolved_get (medialib);
+	CU_ASSERT (entry == first || entry == second);
+
+	/* resolving, removing and aborted sessions update the set */
 	session = xmms_medialib_session_begin (medialib);
-	count = xmms_medialib_num_not_resolved (session);
+	xmms_medialib_entry_property_set_int (session, first, "status",
+	                                      XMMS_MEDIALIB_ENTRY_STATUS_OK);
 	xmms_medialib_session_commit (session);
 
-	CU_ASSERT_EQUAL (2, count);
+	CU_ASSERT_EQUAL (1, xmms_medialib_num_not_resolved (medialib));
+	CU_ASSERT_EQUAL (second, xmms_medialib_entry_not_resolved_get (medialib));
 
 	session = xmms_medialib_session_begin (medialib);
-	entry = xmms_medialib_entry_not_resolved_get (session);
+	xmms_medialib_entry_remove (session, second);
+	xmms_medialib_session_abort (session);
+
+	CU_ASSERT_EQUAL (1, xmms_medialib_num_not_resolved (medialib));
+
+	session = xmms_medialib_session_begin (medialib);
+	xmms_medialib_entry_remove (session, second);
 	xmms_medialib_session_commit (session);
-	CU_ASSERT (entry == first || entry == second);
+
+	CU_ASSERT_EQUAL (0, xmms_medialib_num_not_resolved (medialib));
+	CU_ASSERT_EQUAL (0, xmms_medialib_entry_not_resolved_get (medialib));
+}
+
+CASE (test_new_id)
+{
+	xmms_medialib_session_t *session;
+	xmms_medialib_entry_t first, second, third;
+	xmms_error_t err;
+
+	xmms_error_reset (&err);
+
+	first = xmms_mock_entry (medialib, 1, "Red Fang", "Red Fang", "Prehistoric Dog");
+	CU_ASSERT_EQUAL (1, first);
+
+	/* ids of aborted sessions and removed entries are not handed out again */
+	session = xmms_medialib_session_begin (medialib);
+	second = xmms_medialib_entry_new (session, "file:///aborted.mp3", &err);
+	xmms_medialib_session_abort (session);
+
+	session = xmms_medialib_session_begin (medialib);
+	xmms_medialib_entry_remove (session, first);
+	xmms_medialib_session_commit (session);
+
+	third = xmms_mock_entry (medialib, 2, "Red Fang", "Red Fang", "Reverse Thunder");
+	CU_ASSERT (third > second);
+	CU_ASSERT (second > first);
+
+	/* the counter is stored, and stays put when the highest id goes */
+	session = xmms_medialib_session_begin (medialib);
+	xmms_medialib_entry_remove (session, third);
+	xmms_medialib_session_commit (session);
+
+	session = xmms_medialib_session_begin_ro (medialib);
+	CU_ASSERT_EQUAL (third + 1, xmms_medialib_session_get_next_id (session));
+	xmms_medialib_session_abort (session);
 }
 
 CASE (test_query_random_id)
@@ -269,6 +320,73 @@ CASE (test_session)
 	xmmsv_unref (spec);
 }
 
+static void
+count_signal (xmms_object_t *object, xmmsv_t *val, gpointer udata)
+{
+	gint *count = (gint *) udata;
+	(*count)++;
+}
+
+static void
+store_signal (xmms_object_t *object, xmmsv_t *val, gpointer udata)
+{
+	xmmsv_t **stored = (xmmsv_t **) udata;
+	*stored = xmmsv_ref (val);
+}
+
+CASE (test_session_bulk)
+{
+	xmms_medialib_session_t *session;
+	xmms_medialib_entry_t first, second;
+	xmms_error_t err;
+	xmmsv_t *changes = NULL, *list;
+	gint added = 0, changed = 0;
+
+	xmms_error_reset (&err);
+
+	first = xmms_mock_entry (medialib, 1, "Red Fang", "Red Fang", "Prehistoric Dog");
+
+	xmms_object_connect (XMMS_OBJECT (medialib),
+	                     XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_ADDED,
+	                     count_signal, &added);
+	xmms_object_connect (XMMS_OBJECT (medialib),
+	                     XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_CHANGED,
+	                     count_signal, &changed);
+	xmms_object_connect (XMMS_OBJECT (medialib),
+	                     XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED,
+	                     store_signal, &changes);
+
+	session = xmms_medialib_session_begin_bulk (medialib);
+	second = xmms_medialib_entry_new (session, "file:///red/fang/reverse_thunder.mp3", &err);
+	xmms_medialib_entry_new (session, "file:///red/fang/wires.mp3", &err);
+	xmms_medialib_entry_property_set_str (session, second, "title", "Reverse Thunder");
+	xmms_medialib_entry_property_set_int (session, first, "tracknr", 2);
+	CU_ASSERT_TRUE (xmms_medialib_session_commit (session));
+
+	/* one summary instead of a signal per entry */
+	CU_ASSERT_EQUAL (0, added);
+	CU_ASSERT_EQUAL (0, changed);
+	CU_ASSERT_PTR_NOT_NULL_FATAL (changes);
+
+	CU_ASSERT_TRUE (xmmsv_dict_get (changes, "added", &list));
+	CU_ASSERT_EQUAL (2, xmmsv_list_get_size (list));
+	CU_ASSERT_TRUE (xmmsv_dict_get (changes, "changed", &list));
+	CU_ASSERT_EQUAL (1, xmmsv_list_get_size (list));
+	CU_ASSERT_LIST_INT_EQUAL (list, 0, first);
+
+	xmms_object_disconnect (XMMS_OBJECT (medialib),
+	                        XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED,
+	                        store_signal, &changes);
+	xmms_object_disconnect (XMMS_OBJECT (medialib),
+	                        XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_CHANGED,
+	                        count_signal, &changed);
+	xmms_object_disconnect (XMMS_OBJECT (medialib),
+	                        XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_ADDED,
+	                        count_signal, &added);
+
+	xmmsv_unref (changes);
+}
+
 CASE (test_metadata_fetch_spec)
 {
 	xmmsv_t *universe, *spec, *result;
@@ -574,6 +692,47 @@ CASE(test_client_get_info)
 	xmmsv_unref (result);
 }
 
+CASE(test_client_get_info_batch)
+{
+	xmmsv_t *result, *ids, *keys, *info, *title, *server;
+	const gchar *value;
+
+	xmms_mock_entry (medialib, 1, "Red Fang", "Red Fang", "Prehistoric Dog");
+	xmms_mock_entry (medialib, 2, "Red Fang", "Red Fang", "Reverse Thunder");
+
+	ids = xmmsv_build_list (XMMSV_LIST_ENTRY_INT (2),
+	                        XMMSV_LIST_ENTRY_INT (1337),
+	                        XMMSV_LIST_ENTRY_INT (1),
+	                        XMMSV_LIST_END);
+	keys = xmmsv_build_list (XMMSV_LIST_ENTRY_STR ("title"),
+	                         XMMSV_LIST_END);
+
+	result = XMMS_IPC_CALL (medialib, XMMS_IPC_COMMAND_MEDIALIB_GET_INFO_BATCH,
+	                        ids, keys, xmmsv_new_list ());
+	CU_ASSERT (xmmsv_is_type (result, XMMSV_TYPE_LIST));
+	CU_ASSERT_EQUAL (3, xmmsv_list_get_size (result));
+
+	/* rows come back in request order, with only the asked for keys */
+	CU_ASSERT (xmmsv_list_get (result, 0, &info));
+	CU_ASSERT (xmmsv_dict_get (info, "title", &title));
+	CU_ASSERT (xmmsv_dict_get (title, "server", &server));
+	CU_ASSERT (xmmsv_get_string (server, &value));
+	CU_ASSERT_STRING_EQUAL ("Reverse Thunder", value);
+	CU_ASSERT_FALSE (xmmsv_dict_has_key (info, "artist"));
+	CU_ASSERT_FALSE (xmmsv_dict_has_key (info, "id"));
+
+	CU_ASSERT (xmmsv_list_get (result, 1, &info));
+	CU_ASSERT (xmmsv_is_type (info, XMMSV_TYPE_NONE));
+
+	CU_ASSERT (xmmsv_list_get (result, 2, &info));
+	CU_ASSERT (xmmsv_dict_get (info, "title", &title));
+	CU_ASSERT (xmmsv_dict_get (title, "server", &server));
+	CU_ASSERT (xmmsv_get_string (server, &value));
+	CU_ASSERT_STRING_EQUAL ("Prehistoric Dog", value);
+
+	xmmsv_unref (result);
+}
+
 CASE(test_client_entry_add)
 {
 	xmms_medialib_session_t *session;
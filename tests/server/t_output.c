@@ -0,0 +1,181 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2017 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include "xcu.h"
+
+#include <string.h>
+#include <glib.h>
+
+#include <xmmspriv/xmms_output.h>
+#include <xmmspriv/xmms_ringbuf.h>
+
+#define FRAME_SIZE 4
+
+typedef struct {
+	xmms_ringbuf_t *ringbuf;
+	GMutex mutex;
+	guint8 *data;
+	guint len;
+} sink_t;
+
+static guint8 *
+pattern_new (guint len)
+{
+	guint8 *data;
+	guint i;
+
+	data = g_new (guint8, len);
+	for (i = 0; i < len; i++) {
+		data[i] = i;
+	}
+
+	return data;
+}
+
+static void
+sink_init (sink_t *sink, guint size)
+{
+	sink->ringbuf = xmms_ringbuf_new (size);
+	g_mutex_init (&sink->mutex);
+	sink->data = NULL;
+	sink->len = 0;
+}
+
+static void
+sink_clear (sink_t *sink)
+{
+	xmms_ringbuf_destroy (sink->ringbuf);
+	g_mutex_clear (&sink->mutex);
+	g_free (sink->data);
+}
+
+/* plays the part of a slow output plugin */
+static gpointer
+sink_drain (gpointer arg)
+{
+	sink_t *sink = (sink_t *) arg;
+	guint ret;
+
+	g_mutex_lock (&sink->mutex);
+	while (sink->len < 256) {
+		g_mutex_unlock (&sink->mutex);
+		g_usleep (1000);
+		g_mutex_lock (&sink->mutex);
+
+		ret = xmms_ringbuf_read (sink->ringbuf, sink->data + sink->len, FRAME_SIZE);
+		sink->len += ret;
+	}
+	g_mutex_unlock (&sink->mutex);
+
+	return NULL;
+}
+
+static gpointer
+sink_stop (gpointer arg)
+{
+	sink_t *sink = (sink_t *) arg;
+
+	g_usleep (10000);
+
+	g_mutex_lock (&sink->mutex);
+	xmms_ringbuf_set_eos (sink->ringbuf, TRUE);
+	g_mutex_unlock (&sink->mutex);
+
+	return NULL;
+}
+
+SETUP (output) {
+	return 0;
+}
+
+CLEANUP () {
+	return 0;
+}
+
+CASE (test_sink_queue_drop)
+{
+	guint8 *data;
+	guint64 dropped = 0;
+	guint avail, ret;
+	sink_t sink;
+
+	sink_init (&sink, 64);
+	data = pattern_new (256);
+
+	/* everything fits */
+	ret = xmms_output_sink_queue (sink.ringbuf, &sink.mutex, FALSE, FRAME_SIZE,
+	                              data, 16, &dropped);
+	CU_ASSERT_EQUAL (16, ret);
+	CU_ASSERT_EQUAL (0, dropped);
+
+	/* the whole frames that fit are queued, the rest is dropped */
+	avail = xmms_ringbuf_bytes_free (sink.ringbuf);
+	ret = xmms_output_sink_queue (sink.ringbuf, &sink.mutex, FALSE, FRAME_SIZE,
+	                              data, 256, &dropped);
+	CU_ASSERT_EQUAL (avail - avail % FRAME_SIZE, ret);
+	CU_ASSERT_EQUAL (0, ret % FRAME_SIZE);
+	CU_ASSERT_EQUAL (256 - ret, dropped);
+
+	/* a full buffer drops everything without waiting */
+	ret = xmms_output_sink_queue (sink.ringbuf, &sink.mutex, FALSE, FRAME_SIZE,
+	                              data, 16, &dropped);
+	CU_ASSERT_EQUAL (0, ret);
+	CU_ASSERT_EQUAL (256 - (avail - avail % FRAME_SIZE) + 16, dropped);
+
+	g_free (data);
+	sink_clear (&sink);
+}
+
+CASE (test_sink_queue_block)
+{
+	GThread *thread;
+	guint8 *data;
+	guint64 dropped = 0;
+	guint ret, used;
+	sink_t sink;
+
+	sink_init (&sink, 64);
+	sink.data = g_new0 (guint8, 256);
+	data = pattern_new (256);
+
+	/* waits for the reader instead of dropping */
+	thread = g_thread_new ("drain", sink_drain, &sink);
+	ret = xmms_output_sink_queue (sink.ringbuf, &sink.mutex, TRUE, FRAME_SIZE,
+	                              data, 256, &dropped);
+	g_thread_join (thread);
+
+	CU_ASSERT_EQUAL (256, ret);
+	CU_ASSERT_EQUAL (0, dropped);
+	CU_ASSERT_EQUAL (256, sink.len);
+	CU_ASSERT_EQUAL (0, memcmp (data, sink.data, 256));
+
+	/* a sink that stops while we wait ends the wait */
+	used = xmms_output_sink_queue (sink.ringbuf, &sink.mutex, FALSE, FRAME_SIZE,
+	                               data, 256, &dropped);
+	dropped = 0;
+
+	thread = g_thread_new ("stop", sink_stop, &sink);
+	ret = xmms_output_sink_queue (sink.ringbuf, &sink.mutex, TRUE, FRAME_SIZE,
+	                              data, 16, &dropped);
+	g_thread_join (thread);
+
+	CU_ASSERT_TRUE (used > 0);
+	CU_ASSERT_EQUAL (0, ret);
+	CU_ASSERT_EQUAL (0, dropped);
+
+	g_free (data);
+	sink_clear (&sink);
+}
@@ -0,0 +1,107 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2017 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Times serialization and parsing of a query result sized value.
+ *
+ * Usage: bench_xmmsv_serialization [entries] [rounds]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <xmmsc/xmmsv.h>
+
+static xmmsv_t *
+build_result (int entries)
+{
+	xmmsv_t *list, *dict;
+	char buf[64];
+	int i;
+
+	/* roughly what a medialib query with a few fields returns */
+	list = xmmsv_new_list ();
+	for (i = 0; i < entries; i++) {
+		dict = xmmsv_new_dict ();
+		xmmsv_dict_set_int (dict, "id", i + 1);
+		xmmsv_dict_set_int (dict, "tracknr", i % 20);
+		xmmsv_dict_set_int (dict, "duration", 180000 + i);
+		snprintf (buf, sizeof (buf), "Artist %d", i / 100);
+		xmmsv_dict_set_string (dict, "artist", buf);
+		snprintf (buf, sizeof (buf), "Album %d", i / 10);
+		xmmsv_dict_set_string (dict, "album", buf);
+		snprintf (buf, sizeof (buf), "Title of track number %d", i);
+		xmmsv_dict_set_string (dict, "title", buf);
+		xmmsv_list_append (list, dict);
+		xmmsv_unref (dict);
+	}
+
+	return list;
+}
+
+static double
+elapsed (clock_t start)
+{
+	return (double) (clock () - start) / CLOCKS_PER_SEC;
+}
+
+int
+main (int argc, char **argv)
+{
+	xmmsv_t *value, *bin, *parsed;
+	const unsigned char *data;
+	unsigned int len = 0;
+	double put = 0, get = 0;
+	int entries, rounds, i;
+	clock_t start;
+
+	entries = argc > 1 ? atoi (argv[1]) : 100000;
+	rounds = argc > 2 ? atoi (argv[2]) : 10;
+
+	value = build_result (entries);
+
+	for (i = 0; i < rounds; i++) {
+		start = clock ();
+		bin = xmmsv_serialize (value);
+		put += elapsed (start);
+
+		if (!bin || !xmmsv_get_bin (bin, &data, &len)) {
+			fprintf (stderr, "serialization failed\n");
+			return EXIT_FAILURE;
+		}
+
+		start = clock ();
+		parsed = xmmsv_deserialize (bin);
+		get += elapsed (start);
+
+		if (!parsed || xmmsv_list_get_size (parsed) != entries) {
+			fprintf (stderr, "parsing failed\n");
+			return EXIT_FAILURE;
+		}
+
+		xmmsv_unref (parsed);
+		xmmsv_unref (bin);
+	}
+
+	xmmsv_unref (value);
+
+	printf ("%d entries, %u bytes, %d rounds\n", entries, len, rounds);
+	printf ("serialize:   %8.2f ms/round %8.1f MB/s\n",
+	        put * 1000 / rounds, len * (double) rounds / put / 1e6);
+	printf ("deserialize: %8.2f ms/round %8.1f MB/s\n",
+	        get * 1000 / rounds, len * (double) rounds / get / 1e6);
+
+	return EXIT_SUCCESS;
+}
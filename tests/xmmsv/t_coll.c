@@ -253,3 +253,105 @@ CASE (test_coll_idlist)
 
 	xmmsv_unref (c);
 }
+
+CASE (test_coll_idlist_packed)
+{
+	xmmsv_t *c, *list, *bin, *parsed, *copy;
+	int64_t expected[] = { 3, 2, -2, 4, INT64_C (1) << 40 };
+	const int64_t *ids;
+	int64_t v;
+	int i;
+
+	c = xmmsv_new_coll (XMMS_COLLECTION_TYPE_IDLIST);
+
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_append (c, 1));
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_append (c, 4));
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_insert (c, 0, 2));
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_insert (c, -1, 3));
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_append (c, INT64_C (1) << 40));
+	CU_ASSERT_FALSE (xmmsv_coll_idlist_insert (c, 6, 0));
+
+	/* 2, 1, 3, 4, 1 << 40 before moving 3 to the front */
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_move (c, 2, 0));
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_set_index (c, 2, -2));
+	CU_ASSERT_FALSE (xmmsv_coll_idlist_move (c, 0, 5));
+
+	/* the list follows the packed ids */
+	list = xmmsv_coll_idlist_get (c);
+	CU_ASSERT_EQUAL (xmmsv_list_get_size (list), 5);
+	for (i = 0; i < 5; i++) {
+		CU_ASSERT_TRUE (xmmsv_list_get_int64 (list, i, &v));
+		CU_ASSERT_EQUAL (v, expected[i]);
+	}
+
+	CU_ASSERT_EQUAL (xmmsv_coll_idlist_get_ids (c, &ids), 5);
+	CU_ASSERT_EQUAL (0, memcmp (ids, expected, sizeof (expected)));
+
+	/* ...and stays live, changes go both ways */
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_append (c, 7));
+	CU_ASSERT_PTR_EQUAL (xmmsv_coll_idlist_get (c), list);
+	CU_ASSERT_TRUE (xmmsv_list_get_int64 (list, -1, &v));
+	CU_ASSERT_EQUAL (v, 7);
+
+	CU_ASSERT_TRUE (xmmsv_list_remove (list, -1));
+	CU_ASSERT_TRUE (xmmsv_list_set_int (list, 0, 8));
+	CU_ASSERT_EQUAL (xmmsv_coll_idlist_get_size (c), 5);
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_get_index_int64 (c, 0, &v));
+	CU_ASSERT_EQUAL (v, 8);
+	CU_ASSERT_TRUE (xmmsv_list_set_int (list, 0, expected[0]));
+
+	bin = xmmsv_serialize (c);
+	CU_ASSERT_PTR_NOT_NULL (bin);
+	parsed = xmmsv_deserialize (bin);
+	CU_ASSERT_PTR_NOT_NULL (parsed);
+	copy = xmmsv_copy (c);
+
+	CU_ASSERT_EQUAL (xmmsv_coll_idlist_get_size (parsed), 5);
+	CU_ASSERT_EQUAL (xmmsv_coll_idlist_get_size (copy), 5);
+	for (i = 0; i < 5; i++) {
+		CU_ASSERT_TRUE (xmmsv_coll_idlist_get_index_int64 (parsed, i, &v));
+		CU_ASSERT_EQUAL (v, expected[i]);
+		CU_ASSERT_TRUE (xmmsv_coll_idlist_get_index_int64 (copy, i, &v));
+		CU_ASSERT_EQUAL (v, expected[i]);
+	}
+
+	xmmsv_unref (copy);
+	xmmsv_unref (parsed);
+	xmmsv_unref (bin);
+	xmmsv_unref (c);
+}
+
+CASE (test_coll_idlist_append_after_list_change)
+{
+	xmmsv_t *c, *list;
+	int64_t v;
+
+	c = xmmsv_new_coll (XMMS_COLLECTION_TYPE_IDLIST);
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_append (c, 1));
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_append (c, 2));
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_append (c, 3));
+
+	/* shrink the list behind the collection's back, then append */
+	list = xmmsv_coll_idlist_get (c);
+	CU_ASSERT_TRUE (xmmsv_list_remove (list, 0));
+	CU_ASSERT_TRUE (xmmsv_list_remove (list, 0));
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_append (c, 4));
+
+	CU_ASSERT_EQUAL (xmmsv_coll_idlist_get_size (c), 2);
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_get_index_int64 (c, 1, &v));
+	CU_ASSERT_EQUAL (v, 4);
+
+	/* and grow it */
+	CU_ASSERT_TRUE (xmmsv_list_append_int (list, 5));
+	CU_ASSERT_TRUE (xmmsv_list_append_int (list, 6));
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_append (c, 7));
+
+	CU_ASSERT_EQUAL (xmmsv_coll_idlist_get_size (c), 5);
+	CU_ASSERT_EQUAL (xmmsv_list_get_size (list), 5);
+	CU_ASSERT_TRUE (xmmsv_coll_idlist_get_index_int64 (c, 4, &v));
+	CU_ASSERT_EQUAL (v, 7);
+	CU_ASSERT_TRUE (xmmsv_list_get_int64 (list, 4, &v));
+	CU_ASSERT_EQUAL (v, 7);
+
+	xmmsv_unref (c);
+}
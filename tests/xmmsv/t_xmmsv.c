@@ -959,6 +959,44 @@ CASE (test_xmmsv_type_bitbuffer2)
 	xmmsv_unref (value);
 }
 
+CASE (test_xmmsv_type_bitbuffer_unaligned)
+{
+	xmmsv_t *value;
+	unsigned char b[4];
+	int64_t r;
+
+	value = xmmsv_new_bitbuffer ();
+
+	/* mix writes on and off byte boundaries */
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_put_bits (value, 3, 0x5));
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_put_bits (value, 32, 0x89abcdef));
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_put_data (value, (unsigned char *)"test", 4));
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_put_bits (value, 5, 0x11));
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_put_bits (value, 64, -2));
+	CU_ASSERT_EQUAL (xmmsv_bitbuffer_len (value), 3 + 32 + 32 + 5 + 64);
+
+	/* 0b101 followed by the first five bits of 0x89 */
+	CU_ASSERT_EQUAL (xmmsv_bitbuffer_buffer (value)[0], 0xb1);
+
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_rewind (value));
+
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_get_bits (value, 3, &r));
+	CU_ASSERT_EQUAL (r, 0x5);
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_get_bits (value, 32, &r));
+	CU_ASSERT_EQUAL (r, 0x89abcdef);
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_get_data (value, b, 4));
+	CU_ASSERT_EQUAL (memcmp (b, "test", 4), 0);
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_get_bits (value, 5, &r));
+	CU_ASSERT_EQUAL (r, 0x11);
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_get_bits (value, 64, &r));
+	CU_ASSERT_EQUAL (r, -2);
+
+	CU_ASSERT_FALSE (xmmsv_bitbuffer_get_bits (value, 8, &r));
+	CU_ASSERT_FALSE (xmmsv_bitbuffer_get_data (value, b, 1));
+
+	xmmsv_unref (value);
+}
+
 CASE (test_xmmsv_type_bitbuffer_ro)
 {
 	xmmsv_t *value;
@@ -996,6 +1034,30 @@ CASE (test_xmmsv_type_bitbuffer_ro)
 	xmmsv_unref (value);
 }
 
+CASE (test_xmmsv_type_bitbuffer_oversized)
+{
+	xmmsv_t *value;
+	const unsigned char data[8] = {0x12, 0x23, 0x34, 0x45, 0x56, 0x67, 0x78, 0x89};
+	unsigned char b[8];
+
+	/* len * 8 does not fit in an int, must not pass the bounds check */
+	value = xmmsv_new_bitbuffer_ro (data, 8);
+	CU_ASSERT_FALSE (xmmsv_bitbuffer_get_data (value, b, 0x10000001));
+	CU_ASSERT_FALSE (xmmsv_bitbuffer_get_data (value, b, INT_MAX));
+	CU_ASSERT_EQUAL (0, xmmsv_bitbuffer_pos (value));
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_get_data (value, b, 8));
+	CU_ASSERT_EQUAL (0x89, b[7]);
+	xmmsv_unref (value);
+
+	value = xmmsv_new_bitbuffer ();
+	CU_ASSERT_FALSE (xmmsv_bitbuffer_put_data (value, data, 0x10000001));
+	CU_ASSERT_FALSE (xmmsv_bitbuffer_put_data (value, data, INT_MAX));
+	CU_ASSERT_EQUAL (0, xmmsv_bitbuffer_len (value));
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_put_data (value, data, 8));
+	CU_ASSERT_EQUAL (64, xmmsv_bitbuffer_len (value));
+	xmmsv_unref (value);
+}
+
 CASE (test_xmmsv_list_flatten) {
 	xmmsv_t *list, *flat, *tmp;
 	int l1[] = {0, 1, 2, 3};